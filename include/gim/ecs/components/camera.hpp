@@ -10,7 +10,8 @@
 const static auto FOV_DEFAULT = 45.0F;
 const static auto NEAR_PLANE_DEFAULT = 0.1F;
 const static auto FAR_PLANE_DEFAULT = 1000.F;
-const static auto SPEED_DEFAULT = 0.05F;
+// Units per second.
+const static auto SPEED_DEFAULT = 2.F;
 const static auto YAW_DEFAULT = -90.F;
 const static auto PITCH_DEFAULT = 0.F;
 const static auto SENSITIVITY_DEFAULT = 0.1F;
@@ -39,6 +40,12 @@ class Component : public gim::ecs::IComponent {
     float nearPlane = NEAR_PLANE_DEFAULT;
     float farPlane = FAR_PLANE_DEFAULT;
     glm::vec3 position = glm::vec3(0.0F, 0.0F, -0.F);
+    // The position before the last simulation step, frames are drawn
+    // between the two.
+    glm::vec3 previousPosition = position;
+    // The direction the camera is being moved in, x to the right and y
+    // forward, each in [-1, 1].
+    glm::vec2 movement = glm::vec2(0.F);
     glm::vec3 front = glm::vec3(0.0F, 0.0F, -1.F);
     glm::vec3 up = glm::vec3(0.0F, 1.0F, 0.F);
     float speed = SPEED_DEFAULT;
@@ -53,17 +60,45 @@ class Component : public gim::ecs::IComponent {
     auto operator=(Component &&) -> Component & = delete;
     ~Component() override = default;
 
+    /**
+     * @brief The UBO shaders read the camera from. It is built once and
+     * shared, updateShaderUBO() rewrites it in place.
+     */
     [[nodiscard]] auto getShaderUBO() -> std::shared_ptr<UBO> {
-        return std::make_shared<UBO>(getViewMatrix(), getProjectionMatrix());
+        if (!ubo) {
+            ubo = std::make_shared<UBO>(getProjectionMatrix(), getViewMatrix());
+        }
+        return ubo;
+    }
+
+    /**
+     * @brief Rewrite the shared UBO after the camera moved, seen from alpha
+     * of the way between the previous and the current position.
+     */
+    auto updateShaderUBO(float alpha = 1.F) -> void {
+        getShaderUBO();
+        ubo->projectionMatrix = getProjectionMatrix();
+        ubo->viewMatrix = getViewMatrix(alpha);
+    }
+
+    /**
+     * @brief Whether the camera moved in the last simulation step, so frames
+     * drawn until the next one see it in a different place.
+     */
+    [[nodiscard]] auto moving() const -> bool {
+        return position != previousPosition;
     }
 
   private:
+    std::shared_ptr<UBO> ubo;
+
     [[nodiscard]] auto getProjectionMatrix() const -> glm::mat4 {
         return glm::perspective(FOV, aspectRatio, nearPlane, farPlane);
     }
 
-    [[nodiscard]] auto getViewMatrix() const -> glm::mat4 {
-        return glm::lookAt(position, position + front, up);
+    [[nodiscard]] auto getViewMatrix(float alpha = 1.F) const -> glm::mat4 {
+        auto eye = glm::mix(previousPosition, position, alpha);
+        return glm::lookAt(eye, eye + front, up);
     }
 
 #pragma mark - Shaders.
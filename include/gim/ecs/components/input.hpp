@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <gim/library/queue.hpp>
+#include <vector>
+
+namespace gim::ecs::components::Input {
+enum Type : uint32_t {
+    KeyDown = 0,
+    KeyUp = 1,
+    MouseMotion = 2,
+    Quit = 3,
+};
+
+/**
+ * @brief One sampled input. Keys are SDL keycodes, which are the lowercase
+ * character for letter keys, so game code doesn't need SDL to read them.
+ */
+struct Event {
+    Type type = Type::KeyDown;
+    // When the platform saw the event, in nanoseconds of the steady clock
+    // (Profiler::clock()).
+    std::uint64_t timestamp = 0;
+    std::int32_t key = 0;
+    // The relative mouse motion in pixels.
+    float x = 0.F;
+    float y = 0.F;
+};
+
+// How many events can wait for the next simulation tick, more are dropped.
+constexpr std::size_t QueueSize = 1024;
+
+/**
+ * @brief Where input is pushed by the pump (and any other thread) until the
+ * input system drains it at the start of a tick.
+ */
+using Queue = gim::library::queue::MpscRing<Event, QueueSize>;
+
+/**
+ * @brief The input as of the current tick, kept up to date by the input
+ * system.
+ */
+class State {
+  public:
+    std::vector<std::int32_t> held;
+    // The mouse motion during the tick.
+    float mouseX = 0.F;
+    float mouseY = 0.F;
+    // The latency of the oldest event handled this tick, in nanoseconds.
+    std::uint64_t latency = 0;
+
+    [[nodiscard]] auto isHeld(std::int32_t key) const -> bool {
+        return std::find(held.begin(), held.end(), key) != held.end();
+    }
+};
+} // namespace gim::ecs::components::Input
@@ -224,7 +224,7 @@ class ShaderBuilder {
     std::map<std::string, std::shared_ptr<Uniform>> shaderUniforms;
 
   public:
-    auto getVertices() { return vertices; }
+    auto getVertices() -> std::vector<Vertex> const & { return vertices; }
     auto setVertexSprv(std::vector<char> vertSprv) -> ShaderBuilder * {
         this->vertCode = std::move(vertSprv);
         return this;
@@ -1,30 +1,69 @@
 #pragma once
 
+#include "gim/ecs/engine/command_buffer.hpp"
 #include "gim/ecs/engine/component_array.hpp"
 #include "gim/ecs/engine/component_manager.hpp"
 #include "gim/ecs/engine/entity_manager.hpp"
+#include "gim/ecs/engine/resource_manager.hpp"
 #include "gim/ecs/engine/system_manager.hpp"
+#include <fmt/format.h>
+#include <gim/library/arena.hpp>
+#include <gim/library/profiler.hpp>
 #include <gim/ecs/components/engine-state.hpp>
 #include <memory>
+#include <span>
+#include <stdexcept>
 #include <utility>
 
 namespace gim::ecs {
 class ECS {
   private:
-    std::shared_ptr<EntityManager<100'00>> entityManager =
-        std::make_shared<EntityManager<100'00>>();
+    std::shared_ptr<EntityManager> entityManager =
+        std::make_shared<EntityManager>();
     std::shared_ptr<ComponentManager> componentManager =
         std::make_shared<ComponentManager>();
     std::shared_ptr<SystemManager> systemManager =
         std::make_shared<SystemManager>(componentManager);
+    std::unique_ptr<CommandBuffer> commandBuffer =
+        std::make_unique<CommandBuffer>();
+    std::unique_ptr<ResourceManager> resourceManager =
+        std::make_unique<ResourceManager>();
+
+    auto liveSignature(Entity entity) -> Signature * {
+        auto signature = entityManager->getSignature(entity);
+
+        if (signature == nullptr) {
+            throw std::runtime_error(
+                fmt::format("Entity {} is not alive.\n", entity).data());
+        }
+
+        return signature;
+    }
+
+    template <typename T> static auto changedSignature() -> Signature {
+        Signature changed;
+        changed.set<T>();
+        return changed;
+    }
 
   public:
+    ECS() {
+        systemManager->setCommandBuffer(commandBuffer.get());
+        systemManager->setResourceManager(resourceManager.get());
+    }
+
     auto createEntity() -> Entity { return entityManager->createEntity(); }
 
+    /**
+     * @brief Whether a handle refers to a live entity, handles to destroyed
+     * entities never become alive again.
+     */
+    auto alive(Entity entity) -> bool { return entityManager->alive(entity); }
+
     auto destroyEntity(Entity entity) -> void {
         entityManager->destroyEntity(entity);
         componentManager->entityDestroyed(entity);
-        systemManager->entitySignatureChanged(entity, nullptr);
+        systemManager->entityDestroyed(entity);
     }
 
     template <typename T> auto registerComponent() -> void {
@@ -33,17 +72,61 @@ class ECS {
 
     template <typename T>
     auto addComponent(Entity entity, std::shared_ptr<T> component) -> void {
+        auto signature = liveSignature(entity);
         componentManager->addComponent<T>(entity, std::move(component));
-        auto signature = entityManager->getSignature(entity);
         signature->set<T>();
-        systemManager->entitySignatureChanged(entity, signature);
+        systemManager->entitySignatureChanged(entity, *signature,
+                                              changedSignature<T>());
+    }
+
+    /**
+     * @brief Construct a component in place for an entity. Components which
+     * opt in to Storage::Value live directly in the packed component array.
+     */
+    template <typename T, typename... Args>
+    auto emplace(Entity entity, Args &&...args) -> T & {
+        auto signature = liveSignature(entity);
+        auto &component =
+            componentManager->emplace<T>(entity, std::forward<Args>(args)...);
+        signature->set<T>();
+        systemManager->entitySignatureChanged(entity, *signature,
+                                              changedSignature<T>());
+        return component;
+    }
+
+    /**
+     * @brief Give entities[i] the component values[i], the way emplace()
+     * would one by one. Throws before changing anything if an entity is not
+     * alive.
+     */
+    template <typename T>
+    auto insertBulk(std::span<Entity const> entities,
+                    std::span<T const> values) -> void {
+        if (entities.size() != values.size()) {
+            throw std::runtime_error(
+                fmt::format("insertBulk got {} entities but {} values.\n",
+                            entities.size(), values.size())
+                    .data());
+        }
+        for (auto entity : entities) {
+            liveSignature(entity);
+        }
+
+        componentManager->insertBulk<T>(entities, values);
+        for (auto entity : entities) {
+            auto signature = entityManager->getSignature(entity);
+            signature->set<T>();
+            systemManager->entitySignatureChanged(entity, *signature,
+                                                  changedSignature<T>());
+        }
     }
 
     template <typename T> auto removeComponent(Entity entity) -> void {
+        auto signature = liveSignature(entity);
         componentManager->removeComponent<T>(entity);
-        auto signature = entityManager->getSignature(entity);
         signature->unset<T>();
-        systemManager->entitySignatureChanged(entity, signature);
+        systemManager->entitySignatureChanged(entity, *signature,
+                                              changedSignature<T>());
     }
 
     template <typename T>
@@ -51,10 +134,99 @@ class ECS {
         return componentManager->getComponent<T>(entity);
     }
 
+    template <typename T> auto get(Entity entity) -> T & {
+        return componentManager->get<T>(entity);
+    }
+
+    template <typename T> auto hasComponent(Entity entity) -> bool {
+        return componentManager->hasComponent<T>(entity);
+    }
+
+    /**
+     * @brief A lazy query over every entity which has all of the components
+     * Ts, yielding (entity, Ts &...) tuples. Request `const T` for read only
+     * access.
+     */
+    template <typename... Ts> auto view() {
+        return componentManager->view<Ts...>();
+    }
+
+    /**
+     * @brief Insert or replace an engine wide singleton, looked up in
+     * constant time with resource<T>().
+     */
+    template <typename T>
+    auto insertResource(std::shared_ptr<T> resource) -> void {
+        resourceManager->insert<T>(std::move(resource),
+                                   componentManager->currentTick());
+    }
+
+    template <typename T, typename... Args>
+    auto emplaceResource(Args &&...args) -> T & {
+        insertResource(std::make_shared<T>(std::forward<Args>(args)...));
+        return resource<T>();
+    }
+
+    /**
+     * @brief The resource of type T, request `const T` for read only access.
+     */
+    template <typename T> auto resource() -> T & {
+        return resourceManager->get<T>(componentManager->currentTick());
+    }
+
+    template <typename T> auto hasResource() -> bool {
+        return resourceManager->contains<T>();
+    }
+
+    template <typename T> auto removeResource() -> void {
+        resourceManager->remove<T>();
+    }
+
     template <typename T> auto registerSystem() -> void {
         systemManager->registerSystem<T>();
     }
 
-    auto update() -> void { systemManager->update(); }
+    /**
+     * @brief Record structural changes to apply at the next sync point
+     * instead of right away, safe to use while systems are iterating and from
+     * any job system thread.
+     */
+    auto commands() -> CommandBuffer & { return *commandBuffer; }
+
+    /**
+     * @brief Apply every recorded command, update() does this once all
+     * systems have run.
+     */
+    auto flush() -> void {
+        GIM_PROFILE_ZONE("ECS::flush");
+        commandBuffer->apply(*entityManager, *componentManager, *systemManager);
+    }
+
+    /**
+     * @brief Run the simulation systems once and apply their commands, the
+     * engine loop calls this at a fixed rate.
+     */
+    auto simulate() -> void {
+        systemManager->update(Stage::Simulation);
+        flush();
+    }
+
+    /**
+     * @brief Run the render systems and apply their commands, then free the
+     * frame arenas of every thread. Called once a frame.
+     */
+    auto render() -> void {
+        systemManager->update(Stage::Render);
+        flush();
+        gim::library::memory::FrameArenas::instance().reset();
+    }
+
+    /**
+     * @brief One simulation step followed by one frame.
+     */
+    auto update() -> void {
+        simulate();
+        render();
+    }
 };
 } // namespace gim::ecs
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <gim/ecs/engine/component_array.hpp>
+#include <gim/ecs/engine/component_type.hpp>
+#include <gim/ecs/engine/entity_manager.hpp>
+#include <gim/ecs/engine/signature.hpp>
+#include <gim/ecs/engine/tick.hpp>
+#include <limits>
+#include <memory>
+#include <new>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace gim::ecs {
+/**
+ * @brief Type erased information about how a component is stored in an
+ * archetype column.
+ */
+struct ColumnType {
+    ComponentTypeId type = 0;
+    std::size_t size = 0;
+    std::size_t align = 0;
+    // Pod columns are relocated with memcpy and never destroyed, relocate
+    // and destroy are only used for other columns.
+    bool pod = false;
+    // Move construct the element at src into the uninitialised dst and
+    // destroy src.
+    void (*relocate)(void *dst, void *src) = nullptr;
+    void (*destroy)(void *element) = nullptr;
+
+    template <typename Stored> static auto of(ComponentTypeId type) {
+        return ColumnType{
+            .type = type,
+            .size = sizeof(Stored),
+            .align = alignof(Stored),
+            .relocate =
+                [](void *dst, void *src) {
+                    auto *source = static_cast<Stored *>(src);
+                    new (dst) Stored(std::move(*source));
+                    source->~Stored();
+                },
+            .destroy =
+                [](void *element) { static_cast<Stored *>(element)->~Stored(); },
+        };
+    }
+
+    /**
+     * @brief A column of a PodComponent, aligned to PodAlignment.
+     */
+    template <PodComponent T> static auto ofPod(ComponentTypeId type) {
+        return ColumnType{
+            .type = type,
+            .size = sizeof(T),
+            .align = std::max(alignof(T), PodAlignment),
+            .pod = true,
+            .relocate =
+                [](void *dst, void *src) { std::memcpy(dst, src, sizeof(T)); },
+            .destroy = [](void * /*element*/) {},
+        };
+    }
+
+    /**
+     * @brief Move the element at src into dst, see relocate.
+     */
+    auto move(void *dst, void *src) const -> void {
+        if (pod) {
+            std::memcpy(dst, src, size);
+        } else {
+            relocate(dst, src);
+        }
+    }
+};
+
+/**
+ * @brief A fixed size, cache line aligned block of memory holding the rows
+ * of an archetype. Each component gets its own column (SoA) so iterating a
+ * single component type walks contiguous memory, followed by a column of
+ * the ComponentTicks of those components.
+ */
+class Chunk {
+  public:
+    static constexpr std::size_t Alignment = 64;
+
+  private:
+    struct Deleter {
+        auto operator()(std::byte *data) const -> void {
+            ::operator delete[](data, std::align_val_t{Alignment});
+        }
+    };
+
+    std::unique_ptr<std::byte[], Deleter> data;
+
+  public:
+    explicit Chunk(std::size_t bytes)
+        : data(static_cast<std::byte *>(
+              ::operator new[](bytes, std::align_val_t{Alignment}))) {}
+
+    [[nodiscard]] auto bytes() const -> std::byte * { return data.get(); }
+};
+
+/**
+ * @brief All entities which have exactly the same set of components.
+ *
+ * Rows are packed, row r lives in chunk r / rowsPerChunk. Removing a row
+ * moves the last row into the hole so every chunk but the last is always
+ * full.
+ */
+class Archetype {
+  public:
+    // The size of a chunk when every row fits, components larger than this
+    // get chunks big enough to hold a single row.
+    static constexpr std::size_t ChunkSize = 16 * 1024;
+    static constexpr std::uint8_t NoColumn =
+        std::numeric_limits<std::uint8_t>::max();
+    static constexpr std::uint32_t NoArchetype =
+        std::numeric_limits<std::uint32_t>::max();
+
+  private:
+    Signature signature;
+    std::vector<ColumnType> columns;
+    // The byte offset of every column and its ticks within a chunk, the
+    // entity column always starts at 0.
+    std::vector<std::size_t> offsets;
+    std::vector<std::size_t> tickOffsets;
+    // Find the column of a component type without searching.
+    std::array<std::uint8_t, Signature::capacity> columnOf{};
+    std::size_t rowsPerChunk = 0;
+    std::size_t chunkBytes = 0;
+    std::vector<Chunk> chunks;
+    std::size_t rows = 0;
+
+    auto layout(std::size_t capacity) const -> std::size_t {
+        auto end = sizeof(Entity) * capacity;
+
+        for (auto const &column : columns) {
+            end = (end + column.align - 1) / column.align * column.align;
+            end += column.size * capacity;
+            end = alignTicks(end) + sizeof(ComponentTicks) * capacity;
+        }
+
+        return end;
+    }
+
+    static auto alignTicks(std::size_t offset) -> std::size_t {
+        constexpr auto align = alignof(ComponentTicks);
+        return (offset + align - 1) / align * align;
+    }
+
+    auto element(std::size_t column, std::size_t row) const -> void * {
+        auto &chunk = chunks[row / rowsPerChunk];
+        return chunk.bytes() + offsets[column] +
+               columns[column].size * (row % rowsPerChunk);
+    }
+
+    auto tickElement(std::size_t column, std::size_t row) const
+        -> ComponentTicks * {
+        return ticksData(row / rowsPerChunk, static_cast<std::uint8_t>(column)) +
+               row % rowsPerChunk;
+    }
+
+  public:
+    /**
+     * @brief Add/remove edges to neighbouring archetypes, indexed by
+     * ComponentTypeId and filled in lazily by the owning manager.
+     */
+    std::array<std::uint32_t, Signature::capacity> addEdges{};
+    std::array<std::uint32_t, Signature::capacity> removeEdges{};
+
+    Archetype(Signature signature, std::vector<ColumnType> columnTypes)
+        : signature(signature), columns(std::move(columnTypes)) {
+        addEdges.fill(NoArchetype);
+        removeEdges.fill(NoArchetype);
+        columnOf.fill(NoColumn);
+
+        std::sort(columns.begin(), columns.end(),
+                  [](auto const &a, auto const &b) { return a.type < b.type; });
+
+        std::size_t perRow = sizeof(Entity);
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            columnOf[columns[i].type] = static_cast<std::uint8_t>(i);
+            perRow += columns[i].size + sizeof(ComponentTicks);
+        }
+
+        rowsPerChunk = std::max<std::size_t>(ChunkSize / perRow, 1);
+        while (rowsPerChunk > 1 && layout(rowsPerChunk) > ChunkSize) {
+            rowsPerChunk--;
+        }
+        chunkBytes = std::max(layout(rowsPerChunk), ChunkSize);
+
+        auto end = sizeof(Entity) * rowsPerChunk;
+        for (auto const &column : columns) {
+            end = (end + column.align - 1) / column.align * column.align;
+            offsets.push_back(end);
+            end += column.size * rowsPerChunk;
+            end = alignTicks(end);
+            tickOffsets.push_back(end);
+            end += sizeof(ComponentTicks) * rowsPerChunk;
+        }
+    }
+
+    Archetype(const Archetype &) = delete;
+    Archetype(Archetype &&) = delete;
+    auto operator=(const Archetype &) -> Archetype & = delete;
+    auto operator=(Archetype &&) -> Archetype & = delete;
+
+    ~Archetype() {
+        for (std::size_t column = 0; column < columns.size(); column++) {
+            if (columns[column].pod) {
+                continue;
+            }
+            for (std::size_t row = 0; row < rows; row++) {
+                columns[column].destroy(element(column, row));
+            }
+        }
+    }
+
+    [[nodiscard]] auto getSignature() const -> Signature const & {
+        return signature;
+    }
+
+    [[nodiscard]] auto getColumns() const -> std::vector<ColumnType> const & {
+        return columns;
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t { return rows; }
+
+    /**
+     * @brief The number of chunks holding at least one row.
+     */
+    [[nodiscard]] auto chunkCount() const -> std::size_t {
+        return (rows + rowsPerChunk - 1) / rowsPerChunk;
+    }
+
+    [[nodiscard]] auto chunkCapacity() const -> std::size_t {
+        return rowsPerChunk;
+    }
+
+    /**
+     * @brief The number of live rows in a chunk.
+     */
+    [[nodiscard]] auto chunkSize(std::size_t chunk) const -> std::size_t {
+        return std::min(rows - chunk * rowsPerChunk, rowsPerChunk);
+    }
+
+    [[nodiscard]] auto column(ComponentTypeId type) const -> std::uint8_t {
+        return type < columnOf.size() ? columnOf[type] : NoColumn;
+    }
+
+    /**
+     * @brief Get the start of a column in a chunk.
+     */
+    template <typename Stored>
+    [[nodiscard]] auto columnData(std::size_t chunk, std::uint8_t column) const
+        -> Stored * {
+        return std::launder(
+            reinterpret_cast<Stored *>(chunks[chunk].bytes() + offsets[column]));
+    }
+
+    /**
+     * @brief Get the start of the ticks of a column in a chunk.
+     */
+    [[nodiscard]] auto ticksData(std::size_t chunk, std::uint8_t column) const
+        -> ComponentTicks * {
+        return std::launder(reinterpret_cast<ComponentTicks *>(
+            chunks[chunk].bytes() + tickOffsets[column]));
+    }
+
+    [[nodiscard]] auto ticksAt(std::uint8_t column, std::size_t row) const
+        -> ComponentTicks & {
+        return *tickElement(column, row);
+    }
+
+    [[nodiscard]] auto entities(std::size_t chunk) const -> Entity * {
+        return std::launder(reinterpret_cast<Entity *>(chunks[chunk].bytes()));
+    }
+
+    [[nodiscard]] auto entityAt(std::size_t row) const -> Entity {
+        return entities(row / rowsPerChunk)[row % rowsPerChunk];
+    }
+
+    [[nodiscard]] auto at(std::uint8_t column, std::size_t row) const
+        -> void * {
+        return element(column, row);
+    }
+
+    /**
+     * @brief Append an uninitialised row for an entity, the caller must
+     * construct every column of the new row and set its ticks.
+     *
+     * @return std::size_t The new row.
+     */
+    auto allocate(Entity entity) -> std::size_t {
+        if (rows == chunks.size() * rowsPerChunk) {
+            chunks.emplace_back(chunkBytes);
+        }
+
+        auto row = rows++;
+        new (entities(row / rowsPerChunk) + row % rowsPerChunk) Entity(entity);
+        return row;
+    }
+
+    /**
+     * @brief Remove a row whose columns have already been destroyed or
+     * relocated, by moving the last row into it.
+     *
+     * @return Entity The entity which now lives in the row, or the removed
+     * entity if the row was the last one.
+     */
+    auto release(std::size_t row) -> Entity {
+        auto last = rows - 1;
+        auto moved = entityAt(row);
+
+        if (row != last) {
+            moved = entityAt(last);
+            for (std::size_t column = 0; column < columns.size(); column++) {
+                columns[column].move(element(column, row),
+                                     element(column, last));
+                *tickElement(column, row) = *tickElement(column, last);
+            }
+            entities(row / rowsPerChunk)[row % rowsPerChunk] = moved;
+        }
+
+        rows--;
+
+        // Keep a single spare chunk around so an entity bouncing on a chunk
+        // boundary doesn't allocate every time.
+        if (chunks.size() * rowsPerChunk >= rows + 2 * rowsPerChunk) {
+            chunks.pop_back();
+        }
+
+        return moved;
+    }
+
+    /**
+     * @brief Destroy every column of a row and remove it.
+     */
+    auto erase(std::size_t row) -> Entity {
+        for (std::size_t column = 0; column < columns.size(); column++) {
+            if (!columns[column].pod) {
+                columns[column].destroy(element(column, row));
+            }
+        }
+        return release(row);
+    }
+};
+} // namespace gim::ecs
@@ -0,0 +1,454 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <fmt/printf.h>
+#include <gim/ecs/engine/archetype.hpp>
+#include <gim/ecs/engine/component_array.hpp>
+#include <gim/ecs/engine/component_type.hpp>
+#include <gim/ecs/engine/entity_manager.hpp>
+#include <gim/ecs/engine/signature.hpp>
+#include <gim/ecs/engine/tick.hpp>
+#include <gim/ecs/engine/view.hpp>
+#include <gim/library/arena.hpp>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gim::ecs {
+/**
+ * @brief A component manager which groups entities with the same set of
+ * components into archetypes.
+ *
+ * It exposes the same API as SparseComponentManager so the ECS can be built
+ * on top of either (see GIM_ECS_ARCHETYPES), but fetching several components
+ * of one entity hits a single row and iterating several components walks
+ * the columns of each matching chunk linearly. The price is that adding or
+ * removing a component moves the entity between archetypes.
+ */
+class ArchetypeComponentManager {
+  private:
+    struct Location {
+        // The handle the location belongs to, so stale handles to the same
+        // slot find nothing.
+        Entity entity = NullEntity;
+        std::uint32_t archetype = Archetype::NoArchetype;
+        std::size_t row = 0;
+    };
+
+    // Indexed by ComponentTypeId, unregistered types are empty.
+    std::vector<std::optional<ColumnType>> componentTypes;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<Signature, std::uint32_t> archetypeIndex;
+    // Where every entity lives, indexed by entity index.
+    std::vector<Location> locations;
+    TickClock clock;
+
+    template <typename T> auto checkRegistered() const -> ComponentTypeId {
+        auto type = componentTypeId<T>();
+
+        if (type >= componentTypes.size() || !componentTypes[type]) {
+            throw std::runtime_error(
+                fmt::format("Component '{}' not registered before use.\n",
+                            typeid(T).name())
+                    .data());
+        }
+
+        return type;
+    }
+
+    auto location(Entity entity) const -> Location {
+        auto index = entityIndex(entity);
+        return index < locations.size() && locations[index].entity == entity
+                   ? locations[index]
+                   : Location{};
+    }
+
+    auto archetypeFor(Signature const &signature) -> std::uint32_t {
+        auto found = archetypeIndex.find(signature);
+
+        if (found != archetypeIndex.end()) {
+            return found->second;
+        }
+
+        std::vector<ColumnType> columns;
+        signature.forEach([&](ComponentTypeId type) {
+            columns.push_back(*componentTypes[type]);
+        });
+
+        auto index = static_cast<std::uint32_t>(archetypes.size());
+        archetypes.push_back(
+            std::make_unique<Archetype>(signature, std::move(columns)));
+        archetypeIndex.emplace(signature, index);
+
+        return index;
+    }
+
+    auto neighbour(std::uint32_t from, ComponentTypeId type, bool add)
+        -> std::uint32_t {
+        auto &edges =
+            add ? archetypes[from]->addEdges : archetypes[from]->removeEdges;
+
+        if (edges[type] == Archetype::NoArchetype) {
+            auto signature = archetypes[from]->getSignature();
+            if (add) {
+                signature.set(type);
+            } else {
+                signature.unset(type);
+            }
+            // archetypeFor may grow archetypes, so look the edges up again.
+            auto to = archetypeFor(signature);
+            (add ? archetypes[from]->addEdges
+                 : archetypes[from]->removeEdges)[type] = to;
+            return to;
+        }
+
+        return edges[type];
+    }
+
+    auto setLocation(Entity entity, std::uint32_t archetype, std::size_t row)
+        -> void {
+        auto index = entityIndex(entity);
+        if (index >= locations.size()) {
+            locations.resize(static_cast<std::size_t>(index) + 1);
+        }
+        locations[index] = {entity, archetype, row};
+    }
+
+    auto clearLocation(Entity entity) -> void {
+        locations[entityIndex(entity)] = {};
+    }
+
+    auto fixMoved(Entity moved, Entity removed, std::size_t row) -> void {
+        if (moved != removed) {
+            locations[entityIndex(moved)].row = row;
+        }
+    }
+
+    /**
+     * @brief Move an entity into another archetype, relocating the columns
+     * both archetypes share and destroying the rest. Columns only the
+     * destination has are left for the caller to construct.
+     */
+    auto move(Entity entity, Location from, std::uint32_t to) -> std::size_t {
+        auto &source = *archetypes[from.archetype];
+        auto &destination = *archetypes[to];
+        auto row = destination.allocate(entity);
+
+        for (auto const &column : source.getColumns()) {
+            auto *element = source.at(source.column(column.type), from.row);
+            auto target = destination.column(column.type);
+
+            if (target == Archetype::NoColumn) {
+                if (!column.pod) {
+                    column.destroy(element);
+                }
+            } else {
+                column.move(destination.at(target, row), element);
+                destination.ticksAt(target, row) = source.ticksAt(
+                    source.column(column.type), from.row);
+            }
+        }
+
+        fixMoved(source.release(from.row), entity, from.row);
+        setLocation(entity, to, row);
+
+        return row;
+    }
+
+    template <typename T>
+    auto stored(Entity entity) const -> StoredComponent<T> * {
+        auto where = location(entity);
+
+        if (where.archetype == Archetype::NoArchetype) {
+            return nullptr;
+        }
+
+        auto &archetype = *archetypes[where.archetype];
+        auto column = archetype.column(componentTypeId<T>());
+
+        if (column == Archetype::NoColumn) {
+            return nullptr;
+        }
+
+        return static_cast<StoredComponent<T> *>(
+            archetype.at(column, where.row));
+    }
+
+    template <typename T> auto ticksOf(Entity entity) const -> ComponentTicks * {
+        auto where = location(entity);
+
+        if (where.archetype == Archetype::NoArchetype) {
+            return nullptr;
+        }
+
+        auto &archetype = *archetypes[where.archetype];
+        auto column = archetype.column(componentTypeId<T>());
+
+        return column == Archetype::NoColumn
+                   ? nullptr
+                   : &archetype.ticksAt(column, where.row);
+    }
+
+    // Mark a component as changed by mutable access.
+    template <typename T> auto touch(Entity entity) -> void {
+        if (auto *ticks = ticksOf<T>(entity)) {
+            ticks->changed = clock.now();
+        }
+    }
+
+    template <typename T>
+    auto insert(Entity entity, StoredComponent<T> component) -> T & {
+        auto type = checkRegistered<T>();
+        auto now = clock.now();
+
+        // Replace the component if the entity already had one.
+        if (auto *existing = stored<T>(entity); existing != nullptr) {
+            *existing = std::move(component);
+            *ticksOf<T>(entity) = {.added = now, .changed = now};
+            return derefStored<T>(*existing);
+        }
+
+        auto where = location(entity);
+        std::uint32_t to = 0;
+        std::size_t row = 0;
+
+        if (where.archetype == Archetype::NoArchetype) {
+            Signature signature;
+            signature.set(type);
+            to = archetypeFor(signature);
+            row = archetypes[to]->allocate(entity);
+            setLocation(entity, to, row);
+        } else {
+            to = neighbour(where.archetype, type, true);
+            row = move(entity, where, to);
+        }
+
+        auto column = archetypes[to]->column(type);
+        auto *created = new (archetypes[to]->at(column, row))
+            StoredComponent<T>(std::move(component));
+        archetypes[to]->ticksAt(column, row) = {.added = now, .changed = now};
+
+        return derefStored<T>(*created);
+    }
+
+  public:
+    ArchetypeComponentManager() = default;
+
+    template <typename T> auto registerComponent() -> void {
+        auto type = componentTypeId<T>();
+
+        if (type >= Signature::capacity) {
+            throw std::runtime_error(
+                fmt::format("Component '{}' does not fit in a {} bit "
+                            "signature, raise GIM_ECS_MAX_COMPONENTS.\n",
+                            typeid(T).name(), Signature::capacity)
+                    .data());
+        }
+
+        if (type < componentTypes.size() && componentTypes[type]) {
+            throw std::runtime_error(
+                fmt::format("Registering component type '{}' more than once.\n",
+                            typeid(T).name())
+                    .data());
+        }
+
+        if (type >= componentTypes.size()) {
+            componentTypes.resize(type + 1);
+        }
+
+        if constexpr (ComponentStorage<T>::value == Storage::Pod) {
+            componentTypes[type] = ColumnType::ofPod<T>(type);
+        } else {
+            componentTypes[type] = ColumnType::of<StoredComponent<T>>(type);
+        }
+    }
+
+    template <typename T> [[nodiscard]] auto isRegistered() const -> bool {
+        auto type = componentTypeId<T>();
+        return type < componentTypes.size() && componentTypes[type];
+    }
+
+    template <typename T>
+    auto addComponent(Entity entity, std::shared_ptr<T> component) -> void {
+        if constexpr (storedByValue<T>) {
+            insert<T>(entity, *component);
+        } else {
+            insert<T>(entity, std::move(component));
+        }
+    }
+
+    template <typename T, typename... Args>
+    auto emplace(Entity entity, Args &&...args) -> T & {
+        if constexpr (storedByValue<T>) {
+            return insert<T>(entity, T(std::forward<Args>(args)...));
+        } else {
+            return insert<T>(entity,
+                             std::make_shared<T>(std::forward<Args>(args)...));
+        }
+    }
+
+    /**
+     * @brief Give entities[i] the component values[i], replacing components
+     * they already have. Every entity moves archetype on its own.
+     */
+    template <typename T>
+    auto insertBulk(std::span<Entity const> entities,
+                    std::span<T const> values) -> void {
+        assert(entities.size() == values.size());
+        for (std::size_t i = 0; i < entities.size(); i++) {
+            emplace<T>(entities[i], values[i]);
+        }
+    }
+
+    template <typename T> auto removeComponent(Entity entity) -> void {
+        auto type = checkRegistered<T>();
+        auto where = location(entity);
+
+        if (stored<T>(entity) == nullptr) {
+            return;
+        }
+
+        auto &archetype = *archetypes[where.archetype];
+
+        // Removing the last component leaves the entity without a row.
+        if (archetype.getSignature().count() == 1) {
+            fixMoved(archetype.erase(where.row), entity, where.row);
+            clearLocation(entity);
+            return;
+        }
+
+        move(entity, where, neighbour(where.archetype, type, false));
+    }
+
+    template <typename T>
+    auto getComponent(Entity entity) -> std::shared_ptr<T> {
+        static_assert(!storedByValue<T>,
+                      "Components stored by value are accessed with get<T>().");
+        checkRegistered<T>();
+        auto *component = stored<T>(entity);
+
+        if (component == nullptr) {
+            return nullptr;
+        }
+
+        touch<T>(entity);
+        return *component;
+    }
+
+    template <typename T> auto get(Entity entity) -> T & {
+        checkRegistered<T>();
+        auto *component = stored<T>(entity);
+
+        if (component == nullptr) {
+            throw std::runtime_error(
+                fmt::format("Entity {} has no '{}' component.\n", entity,
+                            typeid(T).name())
+                    .data());
+        }
+
+        touch<T>(entity);
+        return derefStored<T>(*component);
+    }
+
+    template <typename T> auto hasComponent(Entity entity) -> bool {
+        checkRegistered<T>();
+        return stored<T>(entity) != nullptr;
+    }
+
+    /**
+     * @brief The added and changed ticks of an entity's component, nullptr
+     * if it has none. Reading them doesn't count as a change.
+     */
+    template <typename T> auto ticks(Entity entity) -> ComponentTicks const * {
+        checkRegistered<T>();
+        return ticksOf<T>(entity);
+    }
+
+    [[nodiscard]] auto currentTick() const -> Tick { return clock.now(); }
+
+    /**
+     * @brief Start a new tick, see SparseComponentManager::advanceTick.
+     */
+    auto advanceTick() -> Tick { return clock.advance(); }
+
+    auto entityDestroyed(Entity entity) -> void {
+        auto where = location(entity);
+
+        if (where.archetype == Archetype::NoArchetype) {
+            return;
+        }
+
+        auto &archetype = *archetypes[where.archetype];
+        fixMoved(archetype.erase(where.row), entity, where.row);
+        clearLocation(entity);
+    }
+
+    /**
+     * @brief A lazy query over every entity which has all of the components
+     * Ts, see ArchetypeView.
+     */
+    template <typename... Ts> auto view() -> ArchetypeView<Ts...> {
+        Signature required;
+        (required.set(checkRegistered<std::remove_const_t<Ts>>()), ...);
+        return ArchetypeView<Ts...>(archetypes, required, clock.now());
+    }
+
+    /**
+     * @brief Call fn(entity, components...) for every entity which has all
+     * of the requested components, chunk by chunk.
+     */
+    template <typename... Ts, typename Fn> auto each(Fn &&fn) -> void {
+        view<Ts...>().each(std::forward<Fn>(fn));
+    }
+
+    // Try to find a component in the list of entities
+    // and return the entity and component as a tuple.
+    template <typename Component>
+    auto getTComponentWithEntity(std::vector<gim::ecs::Entity> const &entities)
+        -> std::optional<
+            std::pair<gim::ecs::Entity, std::shared_ptr<Component>>> {
+        for (auto const &entity : entities) {
+            if (auto component = getComponent<Component>(entity)) {
+                return std::make_pair(entity, component);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    // Collect every entity in the list which has a component along with
+    // the component. The result lives in the calling thread's frame arena
+    // unless memory says otherwise, so by default it must not outlive the
+    // frame.
+    template <typename Component>
+    auto getAllTComponentsAndEntities(
+        std::vector<gim::ecs::Entity> const &entities,
+        std::pmr::memory_resource *memory =
+            &gim::library::memory::frameArena())
+        -> std::pmr::vector<
+            std::pair<gim::ecs::Entity, std::shared_ptr<Component>>> {
+        std::pmr::vector<std::pair<gim::ecs::Entity, std::shared_ptr<Component>>>
+            result(memory);
+
+        for (auto const &entity : entities) {
+            if (auto component = getComponent<Component>(entity)) {
+                result.emplace_back(entity, std::move(component));
+            }
+        }
+
+        return result;
+    }
+
+    [[nodiscard]] auto archetypeCount() const -> std::size_t {
+        return archetypes.size();
+    }
+};
+} // namespace gim::ecs
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <gim/ecs/engine/component_array.hpp>
+#include <gim/ecs/engine/component_manager.hpp>
+#include <gim/ecs/engine/component_type.hpp>
+#include <gim/ecs/engine/entity_manager.hpp>
+#include <gim/library/arena.hpp>
+#include <gim/library/jobs.hpp>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace gim::ecs {
+/**
+ * @brief An entity created through a CommandBuffer which only gets a real
+ * Entity when the buffer is applied. It can be used as the target of later
+ * commands in the same buffer.
+ */
+struct PendingEntity {
+    std::uint32_t thread = 0;
+    std::uint32_t index = 0;
+};
+
+/**
+ * @brief Records structural changes (creating and destroying entities,
+ * adding and removing components) so they can be made from inside system
+ * updates and parallel loops, then applies them all at once at a sync point.
+ *
+ * Every thread of the job system records into its own buffer so recording
+ * never takes a lock. Threads outside the pool share the buffer of the main
+ * thread, so only one of them should record at a time. Applying sorts the
+ * commands by entity, keeps the order each thread recorded them in, updates
+ * every touched entity's signature once and notifies the systems once per
+ * entity.
+ *
+ * @code
+ * commands.destroy(entity);
+ * auto bullet = commands.create();
+ * commands.emplace<Position>(bullet, position);
+ * @endcode
+ */
+class CommandBuffer {
+  private:
+    enum class Kind : std::uint8_t { Create, Destroy, Add, Remove };
+
+    static constexpr std::uint32_t NotPending =
+        std::numeric_limits<std::uint32_t>::max();
+
+    struct Command {
+        Kind kind;
+        ComponentTypeId type = 0;
+        // The entity, or the index of the pending entity created by
+        // pendingThread.
+        Entity entity = 0;
+        std::uint32_t pendingThread = NotPending;
+        std::move_only_function<void(ComponentManager &, Entity)> apply;
+    };
+
+    struct Queue {
+        std::vector<Command> commands;
+        std::uint32_t creates = 0;
+    };
+
+    // Which command of which thread touches an entity, sorted to apply all
+    // commands of an entity together.
+    struct Entry {
+        Entity entity;
+        std::uint32_t thread;
+        std::uint32_t command;
+    };
+
+    gim::library::jobs::JobSystem *jobs;
+    gim::library::jobs::PerThread<Queue> queues;
+
+    auto local() -> Queue & { return queues.local(); }
+
+    auto thread() const -> std::uint32_t {
+        return static_cast<std::uint32_t>(jobs->threadIndex());
+    }
+
+    auto record(Kind kind, Entity entity, ComponentTypeId type = 0,
+                std::move_only_function<void(ComponentManager &, Entity)>
+                    apply = nullptr) -> void {
+        local().commands.push_back(Command{.kind = kind,
+                                           .type = type,
+                                           .entity = entity,
+                                           .apply = std::move(apply)});
+    }
+
+    auto record(Kind kind, PendingEntity entity, ComponentTypeId type = 0,
+                std::move_only_function<void(ComponentManager &, Entity)>
+                    apply = nullptr) -> void {
+        local().commands.push_back(Command{.kind = kind,
+                                           .type = type,
+                                           .entity = entity.index,
+                                           .pendingThread = entity.thread,
+                                           .apply = std::move(apply)});
+    }
+
+  public:
+    explicit CommandBuffer(gim::library::jobs::JobSystem &jobs =
+                               gim::library::jobs::JobSystem::instance())
+        : jobs(&jobs), queues(jobs) {}
+
+    /**
+     * @brief Create an entity when the buffer is applied.
+     */
+    auto create() -> PendingEntity {
+        auto &queue = local();
+        queue.commands.push_back(
+            Command{.kind = Kind::Create, .apply = nullptr});
+        return {thread(), queue.creates++};
+    }
+
+    /**
+     * @brief Destroy an entity and all of its components when the buffer is
+     * applied. Commands recorded for the entity after this, and commands
+     * for entities which are already dead, are dropped.
+     */
+    template <typename Target> auto destroy(Target entity) -> void {
+        record(Kind::Destroy, entity);
+    }
+
+    template <typename T, typename Target>
+    auto addComponent(Target entity, std::shared_ptr<T> component) -> void {
+        record(Kind::Add, entity, componentTypeId<T>(),
+               [component = std::move(component)](
+                   ComponentManager &components, Entity entity) mutable {
+                   components.addComponent<T>(entity, std::move(component));
+               });
+    }
+
+    /**
+     * @brief Construct a component now and give it to the entity when the
+     * buffer is applied.
+     */
+    template <typename T, typename Target, typename... Args>
+    auto emplace(Target entity, Args &&...args) -> void {
+        if constexpr (storedByValue<T>) {
+            record(Kind::Add, entity, componentTypeId<T>(),
+                   [component = T(std::forward<Args>(args)...)](
+                       ComponentManager &components, Entity entity) mutable {
+                       components.emplace<T>(entity, std::move(component));
+                   });
+        } else {
+            addComponent<T>(entity,
+                            std::make_shared<T>(std::forward<Args>(args)...));
+        }
+    }
+
+    template <typename T, typename Target>
+    auto removeComponent(Target entity) -> void {
+        record(Kind::Remove, entity, componentTypeId<T>(),
+               [](ComponentManager &components, Entity entity) {
+                   components.removeComponent<T>(entity);
+               });
+    }
+
+    [[nodiscard]] auto empty() -> bool {
+        bool empty = true;
+        queues.each(
+            [&](Queue &queue) { empty = empty && queue.commands.empty(); });
+        return empty;
+    }
+
+    /**
+     * @brief Apply and clear every recorded command. Must not run while
+     * anything else records into or reads from the ECS. The scratch space
+     * lives in the calling thread's frame arena.
+     *
+     * If a command throws (adding a component whose type isn't registered,
+     * or whose constructor throws) the exception is rethrown once the
+     * systems know about every change already made, including those made to
+     * the entity of that command, and the buffer is cleared either way so
+     * no command is applied twice.
+     */
+    template <typename Entities, typename Systems>
+    auto apply(Entities &entityManager, ComponentManager &components,
+               Systems &systems) -> void {
+        struct Clear {
+            CommandBuffer &buffer;
+
+            ~Clear() {
+                buffer.queues.each([](Queue &queue) {
+                    queue.commands.clear();
+                    queue.creates = 0;
+                });
+            }
+        } clear{*this};
+
+        auto *memory = &gim::library::memory::frameArena();
+        std::pmr::vector<std::pmr::vector<Entity>> created(queues.size(),
+                                                           memory);
+        std::pmr::vector<Entry> entries(memory);
+
+        // Give pending entities real ones first, so commands recorded on one
+        // thread can target entities created on another.
+        for (std::size_t thread = 0; thread < queues.size(); thread++) {
+            for (auto const &command : queues[thread].commands) {
+                if (command.kind == Kind::Create) {
+                    created[thread].push_back(entityManager.createEntity());
+                }
+            }
+        }
+
+        for (std::uint32_t thread = 0; thread < queues.size(); thread++) {
+            auto const &commands = queues[thread].commands;
+
+            for (std::uint32_t index = 0; index < commands.size(); index++) {
+                auto const &command = commands[index];
+
+                if (command.kind == Kind::Create) {
+                    continue;
+                }
+
+                auto entity = command.pendingThread == NotPending
+                                  ? command.entity
+                                  : created[command.pendingThread]
+                                           [command.entity];
+                entries.push_back({entity, thread, index});
+            }
+        }
+
+        // Entries were collected thread by thread in recording order, so
+        // ordering by thread and command after the entity keeps that order
+        // for every entity without the buffer a stable sort would allocate.
+        std::ranges::sort(entries, {}, [](Entry const &entry) {
+            return std::tuple(entry.entity, entry.thread, entry.command);
+        });
+
+        for (std::size_t first = 0; first < entries.size();) {
+            auto entity = entries[first].entity;
+            auto signature = entityManager.getSignature(entity);
+            auto last = first;
+
+            while (last < entries.size() && entries[last].entity == entity) {
+                last++;
+            }
+
+            // Commands for entities destroyed before the buffer was applied
+            // are dropped.
+            if (signature == nullptr) {
+                first = last;
+                continue;
+            }
+
+            bool destroyed = false;
+            Signature changed;
+
+            try {
+                for (auto current = first; current < last && !destroyed;
+                     current++) {
+
+                    auto &entry = entries[current];
+                    auto &command =
+                        queues[entry.thread].commands[entry.command];
+
+                    switch (command.kind) {
+                    case Kind::Destroy:
+                        components.entityDestroyed(entity);
+                        entityManager.destroyEntity(entity);
+                        destroyed = true;
+                        break;
+                    case Kind::Add:
+                        command.apply(components, entity);
+                        signature->set(command.type);
+                        changed.set(command.type);
+                        break;
+                    case Kind::Remove:
+                        command.apply(components, entity);
+                        signature->unset(command.type);
+                        changed.set(command.type);
+                        break;
+                    case Kind::Create:
+                        assert(false && "Create commands are never sorted.");
+                        break;
+                    }
+                }
+            } catch (...) {
+                // The signature only holds the commands which went through.
+                if (!destroyed) {
+                    systems.entitySignatureChanged(entity, *signature,
+                                                   changed);
+                }
+                throw;
+            }
+
+            if (destroyed) {
+                systems.entityDestroyed(entity);
+            } else {
+                systems.entitySignatureChanged(entity, *signature, changed);
+            }
+
+            first = last;
+        }
+    }
+};
+} // namespace gim::ecs
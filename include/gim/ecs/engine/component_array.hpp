@@ -1,8 +1,19 @@
 #pragma once
 
 #include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <gim/ecs/engine/entity_manager.hpp>
+#include <gim/ecs/engine/sparse_set.hpp>
+#include <gim/ecs/engine/tick.hpp>
 #include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace gim::ecs {
@@ -19,7 +30,7 @@ class IComponent {
     virtual ~IComponent() = 0;
 };
 
-IComponent::~IComponent() = default;
+inline IComponent::~IComponent() = default;
 
 class IComponentArray {
   public:
@@ -30,57 +41,558 @@ class IComponentArray {
     // just a way to satisfy the compiler.
 };
 
+/**
+ * @brief How a component type is laid out in its ComponentArray.
+ *
+ * Shared: every component is a std::shared_ptr, the caller keeps ownership
+ * and may hold on to the component outside of the ECS. This is the default
+ * and is what GPU/Vulkan facing components which hand out handles use.
+ *
+ * Value: components live by value in the packed array, there is no per
+ * component heap allocation or reference count and iteration only touches
+ * contiguous memory. References returned from a value array are invalidated
+ * when a component of the same type is added or removed.
+ *
+ * Pod: like Value, for PodComponent types. Components live in a 64 byte
+ * aligned column which is grown, filled and compacted with memcpy, and
+ * archetypes relocate them with memcpy too. PodComponent types use this
+ * storage unless they declare another one.
+ */
+enum class Storage : std::uint8_t {
+    Shared,
+    Value,
+    Pod,
+};
+
+/**
+ * @brief Plain data components: trivially copyable, trivially destructible,
+ * default constructible and without an IComponent (or any virtual) base, so
+ * they can be copied around as bytes.
+ */
+template <typename T>
+concept PodComponent =
+    std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T> &&
+    std::is_default_constructible_v<T> && !std::is_polymorphic_v<T>;
+
+// The alignment of Pod component columns, a cache line so SIMD loads of the
+// first components never straddle one.
+constexpr std::size_t PodAlignment = 64;
+
+/**
+ * @brief The storage used for a component type, opt in to a different
+ * storage by declaring `static constexpr auto storage = Storage::Value;` on
+ * the component.
+ */
+template <typename T> struct ComponentStorage {
+    static constexpr Storage value =
+        PodComponent<T> ? Storage::Pod : Storage::Shared;
+};
+
+template <typename T>
+    requires requires {
+        { T::storage } -> std::convertible_to<Storage>;
+    }
+struct ComponentStorage<T> {
+    static constexpr Storage value = T::storage;
+};
+
+template <typename T>
+constexpr bool storedByValue = ComponentStorage<T>::value != Storage::Shared;
+
+/**
+ * @brief The type actually held in component storage for a component type.
+ */
+template <typename T>
+using StoredComponent =
+    std::conditional_t<storedByValue<T>, T, std::shared_ptr<T>>;
+
+template <typename T> auto derefStored(StoredComponent<T> &stored) -> T & {
+    if constexpr (storedByValue<T>) {
+        return stored;
+    } else {
+        return *stored;
+    }
+}
+
 /**
  * @brief A component array is a contiguous memory array of components of a
  * particular type.
+ *
+ * Components are kept in a sparse set, the entity at entities()[i] owns the
+ * component at components[i] so iteration over either stays contiguous while
+ * lookup, insertion and removal by entity are O(1). ticksAt(i) holds when
+ * that component was added and last changed, the array itself never stamps
+ * them, the component manager and views do.
  */
+template <typename ComponentType,
+          Storage = ComponentStorage<ComponentType>::value>
+class ComponentArray;
+
 template <typename ComponentType>
-class ComponentArray : public IComponentArray {
+class ComponentArray<ComponentType, Storage::Shared> : public IComponentArray {
   private:
+    // Map entities to their slot in the packed arrays.
+    SparseSet set;
     // Store the components in contiguous memory and make sure
     // that the ownership of the component remains at the component source.
     std::vector<std::shared_ptr<ComponentType>> components;
-    // Store the entities in contiguous memory.
-    std::vector<Entity> entities;
+    std::vector<ComponentTicks> ticks;
 
   public:
     ComponentArray() = default;
     ~ComponentArray() override = default;
 
     void insertData(Entity entity, std::shared_ptr<ComponentType> component) {
-        // Add the entity to the entity vector.
-        entities.push_back(entity);
-        // Add the component to the component vector.
-        components.push_back(component);
+        auto index = set.insert(entity);
+
+        // Replace the component if the entity already had one.
+        if (index < components.size()) {
+            components[index] = std::move(component);
+            return;
+        }
+
+        components.push_back(std::move(component));
+        ticks.emplace_back();
+    }
+
+    template <typename... Args>
+    auto emplace(Entity entity, Args &&...args) -> ComponentType & {
+        auto component =
+            std::make_shared<ComponentType>(std::forward<Args>(args)...);
+        auto &result = *component;
+        insertData(entity, std::move(component));
+        return result;
     }
 
     std::shared_ptr<ComponentType> getData(Entity entity) {
-        // Find the index of the entity.
-        auto it = std::find(entities.begin(), entities.end(), entity);
-        // Get the index of the entity.
-        auto index = std::distance(entities.begin(), it);
+        auto index = set.index(entity);
 
-        // Check if the index is valid.
-        if (index >= entities.size()) {
+        // Check if the entity has a component in this array.
+        if (index == SparseSet::npos) {
             return nullptr;
         }
 
-        // Return the component at the index.
         return components[index];
     }
 
+    /**
+     * @brief Get a pointer to the component of an entity without touching
+     * the reference count, nullptr if the entity has no component.
+     */
+    auto find(Entity entity) -> ComponentType * {
+        auto index = set.index(entity);
+        return index == SparseSet::npos ? nullptr : components[index].get();
+    }
+
+    [[nodiscard]] auto hasData(Entity entity) const -> bool {
+        return set.contains(entity);
+    }
+
+    /**
+     * @brief The index of an entity's component, SparseSet::npos if it has
+     * none.
+     */
+    [[nodiscard]] auto indexOf(Entity entity) const -> SparseSet::Index {
+        return set.index(entity);
+    }
+
+    [[nodiscard]] auto ticksAt(std::size_t index) -> ComponentTicks & {
+        return ticks[index];
+    }
+
+    auto findTicks(Entity entity) -> ComponentTicks * {
+        auto index = set.index(entity);
+        return index == SparseSet::npos ? nullptr : &ticks[index];
+    }
+
+    void removeData(Entity entity) {
+        // Move the last component into the vacated slot, the same way the
+        // sparse set moves the last entity.
+        auto index = set.erase(entity);
+
+        if (index == SparseSet::npos) {
+            return;
+        }
+
+        if (index != components.size() - 1) {
+            components[index] = std::move(components.back());
+            ticks[index] = ticks.back();
+        }
+        components.pop_back();
+        ticks.pop_back();
+    }
+
+    void entityDestroyed(Entity entity) override { removeData(entity); }
+
+    [[nodiscard]] auto size() const -> std::size_t { return set.size(); }
+
+    [[nodiscard]] auto getEntities() const -> std::vector<Entity> const & {
+        return set.entities();
+    }
+
+    [[nodiscard]] auto getComponents() const
+        -> std::vector<std::shared_ptr<ComponentType>> const & {
+        return components;
+    }
+
+    [[nodiscard]] auto componentAt(std::size_t index) const
+        -> ComponentType & {
+        return *components[index];
+    }
+};
+
+template <typename ComponentType>
+class ComponentArray<ComponentType, Storage::Value> : public IComponentArray {
+    static_assert(std::is_move_constructible_v<ComponentType> &&
+                      std::is_move_assignable_v<ComponentType>,
+                  "Components stored by value must be movable.");
+
+  private:
+    // Map entities to their slot in the packed arrays.
+    SparseSet set;
+    // The components themselves, owned by the array.
+    std::vector<ComponentType> components;
+    std::vector<ComponentTicks> ticks;
+
+  public:
+    ComponentArray() = default;
+    ~ComponentArray() override = default;
+
+    template <typename... Args>
+    auto emplace(Entity entity, Args &&...args) -> ComponentType & {
+        auto index = set.insert(entity);
+
+        // Replace the component if the entity already had one.
+        if (index < components.size()) {
+            components[index] = ComponentType(std::forward<Args>(args)...);
+            return components[index];
+        }
+
+        ticks.emplace_back();
+        return components.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void insertData(Entity entity, ComponentType component) {
+        emplace(entity, std::move(component));
+    }
+
+    auto find(Entity entity) -> ComponentType * {
+        auto index = set.index(entity);
+        return index == SparseSet::npos ? nullptr : &components[index];
+    }
+
+    [[nodiscard]] auto hasData(Entity entity) const -> bool {
+        return set.contains(entity);
+    }
+
+    /**
+     * @brief The index of an entity's component, SparseSet::npos if it has
+     * none.
+     */
+    [[nodiscard]] auto indexOf(Entity entity) const -> SparseSet::Index {
+        return set.index(entity);
+    }
+
+    [[nodiscard]] auto ticksAt(std::size_t index) -> ComponentTicks & {
+        return ticks[index];
+    }
+
+    auto findTicks(Entity entity) -> ComponentTicks * {
+        auto index = set.index(entity);
+        return index == SparseSet::npos ? nullptr : &ticks[index];
+    }
+
+    void removeData(Entity entity) {
+        auto index = set.erase(entity);
+
+        if (index == SparseSet::npos) {
+            return;
+        }
+
+        if (index != components.size() - 1) {
+            components[index] = std::move(components.back());
+            ticks[index] = ticks.back();
+        }
+        components.pop_back();
+        ticks.pop_back();
+    }
+
+    void entityDestroyed(Entity entity) override { removeData(entity); }
+
+    [[nodiscard]] auto size() const -> std::size_t { return set.size(); }
+
+    [[nodiscard]] auto getEntities() const -> std::vector<Entity> const & {
+        return set.entities();
+    }
+
+    [[nodiscard]] auto getComponents() -> std::vector<ComponentType> & {
+        return components;
+    }
+
+    [[nodiscard]] auto componentAt(std::size_t index) -> ComponentType & {
+        return components[index];
+    }
+};
+namespace detail {
+/**
+ * @brief A growable array of PodComponent values aligned to PodAlignment,
+ * which only ever copies its elements with memcpy.
+ */
+template <PodComponent T> class PodColumn {
+  private:
+    struct Deleter {
+        auto operator()(T *data) const -> void {
+            ::operator delete(data, std::align_val_t{PodAlignment});
+        }
+    };
+
+    std::unique_ptr<T, Deleter> data;
+    std::size_t count = 0;
+    std::size_t capacity = 0;
+
+    auto grow(std::size_t minimum) -> void {
+        auto next = std::max({minimum, capacity * 2,
+                              PodAlignment / sizeof(T) + 1});
+        std::unique_ptr<T, Deleter> grown(static_cast<T *>(::operator new(
+            next * sizeof(T), std::align_val_t{PodAlignment})));
+
+        if (count > 0) {
+            std::memcpy(grown.get(), data.get(), count * sizeof(T));
+        }
+
+        data = std::move(grown);
+        capacity = next;
+    }
+
+  public:
+    PodColumn() = default;
+
+    PodColumn(PodColumn const &other) { *this = other; }
+
+    PodColumn(PodColumn &&) noexcept = default;
+
+    auto operator=(PodColumn const &other) -> PodColumn & {
+        if (this != &other) {
+            count = 0;
+            append(other.data.get(), other.count);
+        }
+        return *this;
+    }
+
+    auto operator=(PodColumn &&) noexcept -> PodColumn & = default;
+
+    ~PodColumn() = default;
+
+    auto reserve(std::size_t minimum) -> void {
+        if (minimum > capacity) {
+            grow(minimum);
+        }
+    }
+
+    template <typename... Args> auto emplace_back(Args &&...args) -> T & {
+        reserve(count + 1);
+        return *new (data.get() + count++) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Copy n values to the end with a single memcpy.
+     */
+    auto append(T const *values, std::size_t n) -> void {
+        if (n == 0) {
+            return;
+        }
+
+        reserve(count + n);
+        std::memcpy(data.get() + count, values, n * sizeof(T));
+        count += n;
+    }
+
+    /**
+     * @brief Overwrite the element at index with the last one and drop the
+     * last one.
+     */
+    auto swapRemove(std::size_t index) -> void {
+        if (index != count - 1) {
+            std::memcpy(data.get() + index, data.get() + count - 1, sizeof(T));
+        }
+        count--;
+    }
+
+    auto clear() -> void { count = 0; }
+
+    /**
+     * @brief Drop every element from n on.
+     */
+    auto truncate(std::size_t n) -> void { count = std::min(count, n); }
+
+    [[nodiscard]] auto size() const -> std::size_t { return count; }
+
+    [[nodiscard]] auto empty() const -> bool { return count == 0; }
+
+    auto operator[](std::size_t index) const -> T & {
+        return data.get()[index];
+    }
+
+    [[nodiscard]] auto span() const -> std::span<T> {
+        return {data.get(), count};
+    }
+};
+} // namespace detail
+
+/**
+ * @brief The array of a PodComponent type. The same packed sparse set
+ * layout as Storage::Value, but the components sit in a cache line aligned
+ * column which is copied with memcpy: growing, bulk inserting, cloning and
+ * swap-and-pop removal never run a constructor or assignment operator.
+ * Every slot of the packed column is occupied, so presence is answered by
+ * the sparse set alone and there is no per-slot optional or flag.
+ */
+template <typename ComponentType>
+class ComponentArray<ComponentType, Storage::Pod> : public IComponentArray {
+    static_assert(PodComponent<ComponentType>,
+                  "Components stored as Pod must satisfy PodComponent.");
+
+  private:
+    // Map entities to their slot in the packed arrays.
+    SparseSet set;
+    detail::PodColumn<ComponentType> components;
+    std::vector<ComponentTicks> ticks;
+
+  public:
+    ComponentArray() = default;
+    ~ComponentArray() override = default;
+
+    template <typename... Args>
+    auto emplace(Entity entity, Args &&...args) -> ComponentType & {
+        auto index = set.insert(entity);
+
+        // Replace the component if the entity already had one.
+        if (index < components.size()) {
+            components[index] = ComponentType(std::forward<Args>(args)...);
+            return components[index];
+        }
+
+        ticks.emplace_back();
+        return components.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void insertData(Entity entity, ComponentType component) {
+        emplace(entity, component);
+    }
+
+    /**
+     * @brief Give entities[i] the component values[i] as emplace() would,
+     * stamping all of them as added at now. The values are copied in with a
+     * single memcpy and only entities which already have a component, or
+     * appear more than once (the last value wins), are patched up after.
+     */
+    auto insertBulk(std::span<Entity const> entities,
+                    std::span<ComponentType const> values, Tick now) -> void {
+        assert(entities.size() == values.size());
+
+        auto first = components.size();
+        set.reserve(first + entities.size());
+        components.append(values.data(), values.size());
+
+        auto end = first;
+        for (std::size_t i = 0; i < entities.size(); i++) {
+            auto index = set.insert(entities[i]);
+
+            if (index == end) {
+                // A new slot, the value only needs to move down when earlier
+                // entities didn't take one.
+                if (index != first + i) {
+                    components[index] = values[i];
+                }
+                end++;
+            } else {
+                components[index] = values[i];
+                if (index < first) {
+                    ticks[index] = {.added = now, .changed = now};
+                }
+            }
+        }
+
+        components.truncate(end);
+        ticks.resize(end, {.added = now, .changed = now});
+    }
+
+    /**
+     * @brief Give the entity to a copy of the component of from, replacing
+     * any component to already has.
+     *
+     * @return ComponentType * The copy, nullptr if from has no component.
+     */
+    auto clone(Entity from, Entity to) -> ComponentType * {
+        auto source = set.index(from);
+
+        if (source == SparseSet::npos) {
+            return nullptr;
+        }
+
+        // Copy out first, emplacing may grow and move the column.
+        auto copy = components[source];
+        return &emplace(to, copy);
+    }
+
+    auto find(Entity entity) -> ComponentType * {
+        auto index = set.index(entity);
+        return index == SparseSet::npos ? nullptr : &components[index];
+    }
+
+    [[nodiscard]] auto hasData(Entity entity) const -> bool {
+        return set.contains(entity);
+    }
+
+    /**
+     * @brief The index of an entity's component, SparseSet::npos if it has
+     * none.
+     */
+    [[nodiscard]] auto indexOf(Entity entity) const -> SparseSet::Index {
+        return set.index(entity);
+    }
+
+    [[nodiscard]] auto ticksAt(std::size_t index) -> ComponentTicks & {
+        return ticks[index];
+    }
+
+    auto findTicks(Entity entity) -> ComponentTicks * {
+        auto index = set.index(entity);
+        return index == SparseSet::npos ? nullptr : &ticks[index];
+    }
+
     void removeData(Entity entity) {
-        auto it = std::find(entities.begin(), entities.end(), entity);
-        auto index = std::distance(entities.begin(), it);
-        entities.erase(entities.begin() + index);
-        components.erase(components.begin() + index);
+        auto index = set.erase(entity);
+
+        if (index == SparseSet::npos) {
+            return;
+        }
+
+        components.swapRemove(index);
+        if (index != ticks.size() - 1) {
+            ticks[index] = ticks.back();
+        }
+        ticks.pop_back();
     }
 
-    void entityDestroyed(Entity entity) override {
-        auto it = std::find(entities.begin(), entities.end(), entity);
-        auto index = std::distance(entities.begin(), it);
-        entities.erase(entities.begin() + index);
-        components.erase(components.begin() + index);
+    void entityDestroyed(Entity entity) override { removeData(entity); }
+
+    [[nodiscard]] auto size() const -> std::size_t { return set.size(); }
+
+    [[nodiscard]] auto getEntities() const -> std::vector<Entity> const & {
+        return set.entities();
+    }
+
+    /**
+     * @brief The packed components, aligned to PodAlignment.
+     */
+    [[nodiscard]] auto getComponents() const -> std::span<ComponentType> {
+        return components.span();
+    }
+
+    [[nodiscard]] auto componentAt(std::size_t index) const
+        -> ComponentType & {
+        return components[index];
     }
 };
 } // namespace gim::ecs
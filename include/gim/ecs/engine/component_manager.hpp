@@ -4,22 +4,50 @@
 #include <exception>
 #include <fmt/printf.h>
 #include <format>
+#include <gim/ecs/engine/archetype_manager.hpp>
 #include <gim/ecs/engine/component_array.hpp>
+#include <gim/ecs/engine/component_type.hpp>
 #include <gim/ecs/engine/entity_manager.hpp>
+#include <gim/ecs/engine/signature.hpp>
+#include <gim/ecs/engine/tick.hpp>
+#include <gim/ecs/engine/view.hpp>
+#include <gim/library/arena.hpp>
 #include <iostream>
-#include <map>
 #include <memory>
-#include <ranges>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
-#include <string_view>
+#include <type_traits>
 #include <typeinfo>
+#include <utility>
+#include <vector>
 
 namespace gim::ecs {
-class ComponentManager {
+/**
+ * @brief A component manager which keeps one sparse set backed
+ * ComponentArray per component type.
+ */
+class SparseComponentManager {
   private:
-    std::map<std::string_view, std::shared_ptr<IComponentArray>>
-        componentArrays;
+    // Indexed by ComponentTypeId, unregistered types are null.
+    std::vector<std::shared_ptr<IComponentArray>> componentArrays;
+    TickClock clock;
+
+    // Mark a component as changed by mutable access.
+    template <typename T>
+    auto touch(ComponentArray<T> &array, Entity entity) -> void {
+        if (auto *ticks = array.findTicks(entity)) {
+            ticks->changed = clock.now();
+        }
+    }
+
+    template <typename T>
+    auto stampAdded(ComponentArray<T> &array, Entity entity) -> void {
+        auto now = clock.now();
+        *array.findTicks(entity) = {.added = now, .changed = now};
+    }
 
 #ifdef TEST
     // In order to test the private methods, we need to make them
@@ -27,39 +55,91 @@ class ComponentManager {
   public:
 #endif
     template <typename T> auto getComponentArray() -> ComponentArray<T> * {
-        std::string_view typeName = typeid(T).name();
+        auto type = componentTypeId<T>();
 
-        if (componentArrays.find(typeName) == componentArrays.end()) {
+        if (type >= componentArrays.size() || !componentArrays[type]) {
             throw std::runtime_error(
                 fmt::format("Component '{}' not registered before use.\n",
-                            typeName)
+                            typeid(T).name())
                     .data());
         }
 
-        return std::static_pointer_cast<ComponentArray<T>>(
-                   componentArrays.at(typeName))
-            .get();
+        return static_cast<ComponentArray<T> *>(componentArrays[type].get());
     }
 
   public:
-    ComponentManager() { componentArrays.clear(); }
+    SparseComponentManager() = default;
     template <typename T> auto registerComponent() -> void {
-        std::string_view typeName = typeid(T).name();
+        auto type = componentTypeId<T>();
 
-        if (componentArrays.find(typeName) != componentArrays.end()) {
+        if (type >= Signature::capacity) {
+            throw std::runtime_error(
+                fmt::format("Component '{}' does not fit in a {} bit "
+                            "signature, raise GIM_ECS_MAX_COMPONENTS.\n",
+                            typeid(T).name(), Signature::capacity)
+                    .data());
+        }
+
+        if (type < componentArrays.size() && componentArrays[type]) {
             throw std::runtime_error(
                 fmt::format("Registering component type '{}' more than once.\n",
-                            typeName)
+                            typeid(T).name())
                     .data());
         }
 
-        componentArrays.insert(
-            {typeName, std::make_shared<ComponentArray<T>>()});
+        if (type >= componentArrays.size()) {
+            componentArrays.resize(type + 1);
+        }
+
+        componentArrays[type] = std::make_shared<ComponentArray<T>>();
+    }
+
+    template <typename T> [[nodiscard]] auto isRegistered() const -> bool {
+        auto type = componentTypeId<T>();
+        return type < componentArrays.size() && componentArrays[type];
     }
 
     template <typename T>
     auto addComponent(Entity entity, std::shared_ptr<T> component) -> void {
-        getComponentArray<T>()->insertData(entity, component);
+        auto *array = getComponentArray<T>();
+
+        if constexpr (storedByValue<T>) {
+            array->insertData(entity, *component);
+        } else {
+            array->insertData(entity, std::move(component));
+        }
+        stampAdded(*array, entity);
+    }
+
+    /**
+     * @brief Construct a component in place for an entity, replacing any
+     * component of the same type it already has.
+     */
+    template <typename T, typename... Args>
+    auto emplace(Entity entity, Args &&...args) -> T & {
+        auto *array = getComponentArray<T>();
+        auto &component = array->emplace(entity, std::forward<Args>(args)...);
+        stampAdded(*array, entity);
+        return component;
+    }
+
+    /**
+     * @brief Give entities[i] the component values[i], replacing components
+     * they already have. Pod components are copied in with one memcpy.
+     */
+    template <typename T>
+    auto insertBulk(std::span<Entity const> entities,
+                    std::span<T const> values) -> void {
+        assert(entities.size() == values.size());
+        auto *array = getComponentArray<T>();
+
+        if constexpr (ComponentStorage<T>::value == Storage::Pod) {
+            array->insertBulk(entities, values, clock.now());
+        } else {
+            for (std::size_t i = 0; i < entities.size(); i++) {
+                emplace<T>(entities[i], values[i]);
+            }
+        }
     }
 
     template <typename T> auto removeComponent(Entity entity) -> void {
@@ -68,55 +148,128 @@ class ComponentManager {
 
     template <typename T>
     auto getComponent(Entity entity) -> std::shared_ptr<T> {
-        return getComponentArray<T>()->getData(entity);
+        static_assert(!storedByValue<T>,
+                      "Components stored by value are accessed with get<T>().");
+        auto *array = getComponentArray<T>();
+        touch(*array, entity);
+        return array->getData(entity);
     }
 
+    /**
+     * @brief Get a reference to the component of an entity, works for every
+     * storage type and never touches a reference count.
+     */
+    template <typename T> auto get(Entity entity) -> T & {
+        auto *array = getComponentArray<T>();
+        auto *component = array->find(entity);
+
+        if (component == nullptr) {
+            throw std::runtime_error(
+                fmt::format("Entity {} has no '{}' component.\n", entity,
+                            typeid(T).name())
+                    .data());
+        }
+
+        touch(*array, entity);
+        return *component;
+    }
+
+    template <typename T> auto hasComponent(Entity entity) -> bool {
+        return getComponentArray<T>()->hasData(entity);
+    }
+
+    /**
+     * @brief The added and changed ticks of an entity's component, nullptr
+     * if it has none. Reading them doesn't count as a change.
+     */
+    template <typename T> auto ticks(Entity entity) -> ComponentTicks const * {
+        return getComponentArray<T>()->findTicks(entity);
+    }
+
+    [[nodiscard]] auto currentTick() const -> Tick { return clock.now(); }
+
+    /**
+     * @brief Start a new tick, the SystemManager calls this whenever a
+     * system finishes and remembers the result as the system's last run.
+     */
+    auto advanceTick() -> Tick { return clock.advance(); }
+
     auto entityDestroyed(Entity entity) -> void {
-        for (auto const &[key, componentArray] : componentArrays) {
-            componentArray->entityDestroyed(entity);
+        for (auto const &componentArray : componentArrays) {
+            if (componentArray) {
+                componentArray->entityDestroyed(entity);
+            }
         }
     }
 
+    /**
+     * @brief A lazy query over every entity which has all of the components
+     * Ts, see SparseView.
+     */
+    template <typename... Ts> auto view() -> SparseView<Ts...> {
+        return SparseView<Ts...>(
+            clock.now(), getComponentArray<std::remove_const_t<Ts>>()...);
+    }
+
+    /**
+     * @brief Call fn(entity, components...) for every entity which has all
+     * of the requested components.
+     */
+    template <typename... Ts, typename Fn> auto each(Fn &&fn) -> void {
+        view<Ts...>().each(std::forward<Fn>(fn));
+    }
+
     // Try to find a component in the list of entities
     // and return the entity and component as a tuple.
     template <typename Component>
-    auto getTComponentWithEntity(const std::vector<gim::ecs::Entity> entities)
+    auto getTComponentWithEntity(std::vector<gim::ecs::Entity> const &entities)
         -> std::optional<
             std::pair<gim::ecs::Entity, std::shared_ptr<Component>>> {
+        auto *componentArray = getComponentArray<Component>();
 
-        // Try to find a component in the list of entities.
-        auto entity =
-            std::find_if(entities.begin(), entities.end(),
-                         [this](gim::ecs::Entity const &entity) -> bool {
-                             return getComponent<Component>(entity) != nullptr;
-                         });
-
-        if (entity == entities.end()) {
-            return std::nullopt;
+        for (auto const &entity : entities) {
+            if (auto component = componentArray->getData(entity)) {
+                touch(*componentArray, entity);
+                return std::make_pair(entity, component);
+            }
         }
 
-        auto result = std::make_pair(*entity, getComponent<Component>(*entity));
-
-        return std::make_optional(result);
+        return std::nullopt;
     }
 
+    // Collect every entity in the list which has a component along with
+    // the component. The result lives in the calling thread's frame arena
+    // unless memory says otherwise, so by default it must not outlive the
+    // frame.
     template <typename Component>
     auto getAllTComponentsAndEntities(
-        std::vector<std::shared_ptr<gim::ecs::Entity>> entities)
-        -> std::vector<
-            std::pair<gim::ecs::Entity *, std::shared_ptr<Component>>> {
-        return entities |
-               std::views::filter(
-                   [this](gim::ecs::Entity const &entity) -> bool {
-                       return getComponent<Component>(entity) != nullptr;
-                   }) |
-               std::views::transform(
-                   [this](gim::ecs::Entity const &entity)
-                       -> std::pair<gim::ecs::Entity *,
-                                    std::shared_ptr<Component>> {
-                       return std::make_pair(&entity,
-                                             getComponent<Component>(entity));
-                   });
+        std::vector<gim::ecs::Entity> const &entities,
+        std::pmr::memory_resource *memory =
+            &gim::library::memory::frameArena())
+        -> std::pmr::vector<
+            std::pair<gim::ecs::Entity, std::shared_ptr<Component>>> {
+        auto *componentArray = getComponentArray<Component>();
+        std::pmr::vector<std::pair<gim::ecs::Entity, std::shared_ptr<Component>>>
+            result(memory);
+
+        for (auto const &entity : entities) {
+            if (auto component = componentArray->getData(entity)) {
+                touch(*componentArray, entity);
+                result.emplace_back(entity, std::move(component));
+            }
+        }
+
+        return result;
     }
 };
+
+/**
+ * @brief The component storage backing the ECS, defining GIM_ECS_ARCHETYPES
+ * switches from per-type sparse arrays to archetype chunks.
+ */
+#ifdef GIM_ECS_ARCHETYPES
+using ComponentManager = ArchetypeComponentManager;
+#else
+using ComponentManager = SparseComponentManager;
+#endif
 } // namespace gim::ecs
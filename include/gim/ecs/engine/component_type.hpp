@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace gim::ecs {
+/**
+ * @brief A dense, per-process index identifying a component type.
+ *
+ * Ids are handed out in the order types are first seen, starting at 0, so
+ * they can address vectors and bitsets directly instead of keying maps by
+ * type name.
+ */
+using ComponentTypeId = std::uint32_t;
+
+namespace detail {
+inline auto nextComponentTypeId() -> ComponentTypeId {
+    static std::atomic<ComponentTypeId> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace detail
+
+/**
+ * @brief Get the type id of a component type, assigning one on first use.
+ *
+ * cv and reference qualifiers are ignored so `T`, `const T` and `T &` share
+ * the same id.
+ */
+template <typename T> auto componentTypeId() -> ComponentTypeId {
+    using Type = std::remove_cvref_t<T>;
+    if constexpr (!std::is_same_v<T, Type>) {
+        return componentTypeId<Type>();
+    } else {
+        static const ComponentTypeId id = detail::nextComponentTypeId();
+        return id;
+    }
+}
+} // namespace gim::ecs
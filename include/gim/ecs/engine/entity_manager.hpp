@@ -1,85 +1,182 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <gim/ecs/engine/signature.hpp>
 #include <memory>
+#include <vector>
 
 namespace gim::ecs {
+/**
+ * @brief A handle to an entity, the low EntityIndexBits are the slot the
+ * entity lives in and the remaining bits the generation of that slot.
+ *
+ * Every time a slot is freed its generation is bumped, so a handle kept
+ * around after its entity was destroyed no longer matches the slot and
+ * can't be mistaken for the entity which reuses it. A slot whose generation
+ * would wrap around is retired instead of reused.
+ */
 typedef uint32_t Entity;
+
+constexpr unsigned EntityIndexBits = 20;
+constexpr Entity EntityIndexMask = (Entity{1} << EntityIndexBits) - 1;
+constexpr Entity EntityGenerationMask = ~Entity{0} >> EntityIndexBits;
+
+// A handle which never refers to an entity. Its index is reserved, which
+// leaves room for EntityIndexMask live entities.
+constexpr Entity NullEntity = ~Entity{0};
+
+constexpr auto entityIndex(Entity entity) -> Entity {
+    return entity & EntityIndexMask;
+}
+
+constexpr auto entityGeneration(Entity entity) -> Entity {
+    return entity >> EntityIndexBits;
+}
+
+constexpr auto makeEntity(Entity index, Entity generation) -> Entity {
+    return (generation & EntityGenerationMask) << EntityIndexBits | index;
+}
+
 /**
  * @brief The entity manager class.
  *
- * @tparam ECS_MAX_ENTITIES The maximum number of entities that can exist at
- * any given time.
+ * Slots are allocated in pages of PageSize as entities are created, so
+ * memory and start up time follow the number of live entities and there is
+ * no maximum beyond what the entity index bits can address. Pages never
+ * move, so pointers returned by getSignature() stay valid while entities are
+ * created.
+ *
+ * Destroyed slots go on a LIFO free list threaded through the slots
+ * themselves, so creating and destroying entities is O(1) and recently
+ * freed (cache warm) slots are reused first. Slots which used up their
+ * last generation stay off the free list for good, costing one slot every
+ * 4096 reuses.
  */
-template <int ECS_MAX_ENTITIES> class EntityManager {
+class EntityManager {
+  public:
+    static constexpr std::size_t PageSize = 4096;
+
   private:
-    std::array<Entity, ECS_MAX_ENTITIES> entities;
-    std::array<std::shared_ptr<Signature>, ECS_MAX_ENTITIES> signatures;
-    int numEntities;
+    struct Page {
+        // The current handle of every slot, for free slots the index bits
+        // hold the next free slot instead.
+        std::array<Entity, PageSize> entities;
+        std::array<Signature, PageSize> signatures;
+    };
+
+    std::vector<std::unique_ptr<Page>> pages;
+    // Slots below this have been handed out at least once.
+    Entity used = 0;
+    Entity freeList = EntityIndexMask;
+    std::size_t numEntities = 0;
+
+    auto handle(Entity index) const -> Entity & {
+        return pages[index / PageSize]->entities[index % PageSize];
+    }
+
+    auto signature(Entity index) const -> Signature & {
+        return pages[index / PageSize]->signatures[index % PageSize];
+    }
 
   public:
-    /**
-     * @brief Construct a new Entity Manager object and initialize the
-     * entities array with all possible entities so that we can keep the
-     * memory contiguous and allow for fast iteration and data locality.
-     */
-    EntityManager() : entities(), signatures(), numEntities(0) {
-        for (int i = 0; i < ECS_MAX_ENTITIES; i++) {
-            entities[i] = i;
-            signatures[i] = std::make_shared<Signature>();
-        }
-    };
+    EntityManager() = default;
 
     /**
      * @brief Create an entity and return it.
      *
-     * @return Entity The created entity.
+     * @return Entity The created entity, or NullEntity if every entity index
+     * is in use.
      */
     auto createEntity() -> Entity {
-        // Check if there are any available entities.
-        if (numEntities == ECS_MAX_ENTITIES) {
-            return ECS_MAX_ENTITIES;
+        Entity index = 0;
+
+        if (freeList != EntityIndexMask) {
+            index = freeList;
+            freeList = entityIndex(handle(index));
+            handle(index) = makeEntity(index, entityGeneration(handle(index)));
+        } else if (used < EntityIndexMask) {
+            index = used++;
+            if (index / PageSize == pages.size()) {
+                pages.push_back(std::make_unique<Page>());
+            }
+            handle(index) = makeEntity(index, 0);
+        } else {
+            return NullEntity;
         }
 
-        // Return the next available entity.
-        return entities[numEntities++];
+        numEntities++;
+        return handle(index);
     };
 
     /**
-     * @brief Destroy an entity.
+     * @brief Whether a handle refers to a live entity.
+     */
+    [[nodiscard]] auto alive(Entity entity) const -> bool {
+        auto index = entityIndex(entity);
+        return index < used && handle(index) == entity;
+    }
+
+    /**
+     * @brief Destroy an entity, handles to it stop being alive(). Destroying
+     * a dead entity does nothing.
      *
      * @param entity The entity to destroy.
      */
     auto destroyEntity(Entity entity) -> void {
-        // Move the destroyed entity to the end of the array and decrease the
-        // numEntities, we also need to reset the signature of the entity.
-        signatures.at(entity).reset();
-        std::swap(entities.at(entity), entities.at(numEntities - 1));
+        if (!alive(entity)) {
+            return;
+        }
+
+        auto index = entityIndex(entity);
+        signature(index).reset();
         numEntities--;
+
+        // Reusing the slot would bring back the generation of its first
+        // entity. NullEntity's index is never a slot's, so no handle matches
+        // a retired slot.
+        if (entityGeneration(entity) == EntityGenerationMask) {
+            handle(index) = NullEntity;
+            return;
+        }
+
+        handle(index) = makeEntity(freeList, entityGeneration(entity) + 1);
+        freeList = index;
     };
 
+    [[nodiscard]] auto size() const -> std::size_t { return numEntities; }
+
+    /**
+     * @brief Reserve slots for at least capacity entities up front.
+     */
+    auto reserve(std::size_t capacity) -> void {
+        while (pages.size() * PageSize < capacity) {
+            pages.push_back(std::make_unique<Page>());
+        }
+    }
+
     /**
      * @brief Set the signature of an entity.
      *
      * @param entity The entity to set the signature of.
      * @param signature The signature to set.
      */
-    auto setSignature(Entity entity,
-                      const std::shared_ptr<Signature> &signature) -> void {
-        // Set the signature of the entity.
-        signatures.at(entity) = signature;
+    auto setSignature(Entity entity, const Signature &signature) -> void {
+        if (alive(entity)) {
+            this->signature(entityIndex(entity)) = signature;
+        }
     };
 
     /**
      * @brief Get the signature of an entity.
      *
      * @param entity The entity to get the signature of.
-     * @return Signature The signature of the entity.
+     * @return Signature The signature of the entity, nullptr if the entity
+     * isn't alive.
      */
-    auto getSignature(Entity entity) -> std::shared_ptr<Signature> {
-        // Return the signature of the entity.
-        return signatures.at(entity);
+    auto getSignature(Entity entity) -> Signature * {
+        return alive(entity) ? &signature(entityIndex(entity)) : nullptr;
     }
 };
 } // namespace gim::ecs
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace gim::ecs {
+/**
+ * @brief The events of type T sent during the current simulation tick,
+ * inserted as a resource. The system producing them clears the list at the
+ * start of its tick, systems running after it read them:
+ *
+ * @code
+ * for (auto const &event : resource<const Events<Input::Event>>().read()) {
+ * }
+ * @endcode
+ */
+template <typename T> class Events {
+  private:
+    std::vector<T> events;
+
+  public:
+    auto send(T event) -> void { events.push_back(std::move(event)); }
+
+    [[nodiscard]] auto read() const -> std::span<T const> { return events; }
+
+    [[nodiscard]] auto empty() const -> bool { return events.empty(); }
+
+    [[nodiscard]] auto size() const -> std::size_t { return events.size(); }
+
+    /**
+     * @brief Forget the last tick's events, keeping the memory.
+     */
+    auto clear() -> void { events.clear(); }
+};
+} // namespace gim::ecs
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <gim/ecs/engine/component_type.hpp>
+#include <gim/ecs/engine/tick.hpp>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace gim::ecs {
+/**
+ * @brief Engine wide singletons (the engine state, the camera, ...) which
+ * would otherwise be components on an entity that every system has to find
+ * again.
+ *
+ * Resources are indexed by their type id, so looking one up is a vector
+ * access. They share the id space with components, which lets a system
+ * declare the resources it reads and writes in the same Signature the
+ * scheduler uses for components. Like components, resources remember the
+ * tick they were added and last mutably accessed at.
+ */
+class ResourceManager {
+  private:
+    struct Slot {
+        std::shared_ptr<void> resource;
+        ComponentTicks ticks;
+    };
+
+    // Indexed by ComponentTypeId, missing resources are null.
+    std::vector<Slot> slots;
+
+    template <typename T> auto slot() -> Slot * {
+        auto type = componentTypeId<T>();
+        return type < slots.size() && slots[type].resource ? &slots[type]
+                                                          : nullptr;
+    }
+
+  public:
+    /**
+     * @brief Insert or replace the resource of type T.
+     */
+    template <typename T>
+    auto insert(std::shared_ptr<T> resource, Tick now) -> void {
+        static_assert(!std::is_const_v<T>, "Resources are inserted mutable.");
+        auto type = componentTypeId<T>();
+
+        if (type >= slots.size()) {
+            slots.resize(type + 1);
+        }
+
+        slots[type] = {.resource = std::move(resource),
+                       .ticks = {.added = now, .changed = now}};
+    }
+
+    /**
+     * @brief The resource of type T, request `const T` for read only access.
+     * Mutable access marks the resource as changed at now.
+     */
+    template <typename T> auto get(Tick now) -> T & {
+        auto *found = slot<T>();
+
+        if (found == nullptr) {
+            throw std::runtime_error(
+                fmt::format("Resource '{}' not inserted before use.\n",
+                            typeid(T).name())
+                    .data());
+        }
+
+        if constexpr (!std::is_const_v<T>) {
+            found->ticks.changed = now;
+        }
+
+        return *static_cast<std::remove_const_t<T> *>(found->resource.get());
+    }
+
+    /**
+     * @brief The ticks of the resource of type T, nullptr if there is none.
+     */
+    template <typename T> auto ticks() -> ComponentTicks const * {
+        auto *found = slot<T>();
+        return found != nullptr ? &found->ticks : nullptr;
+    }
+
+    template <typename T> [[nodiscard]] auto contains() -> bool {
+        return slot<T>() != nullptr;
+    }
+
+    template <typename T> auto remove() -> void {
+        if (auto *found = slot<T>()) {
+            *found = {};
+        }
+    }
+};
+} // namespace gim::ecs
@@ -1,86 +1,116 @@
 #pragma once
 
-#include <algorithm>
+#include <bitset>
 #include <cassert>
-#include <map>
+#include <cstddef>
+#include <functional>
+#include <gim/ecs/engine/component_type.hpp>
 #include <memory>
-#include <string_view>
-#include <typeinfo>
+
+// The number of component types a signature can describe, override at build
+// time with -DGIM_ECS_MAX_COMPONENTS=128 (or 256, ...) if you need more.
+#ifndef GIM_ECS_MAX_COMPONENTS
+#define GIM_ECS_MAX_COMPONENTS 64
+#endif
 
 namespace gim::ecs {
-class Signature {
+/**
+ * @brief A fixed width set of component types, one bit per ComponentTypeId.
+ *
+ * @tparam Bits The maximum number of component types.
+ */
+template <std::size_t Bits> class BasicSignature {
   private:
-	std::map<std::string_view, bool> signature;
+	std::bitset<Bits> signature;
 
   public:
-	Signature() { signature.clear(); }
+	static constexpr std::size_t capacity = Bits;
 
-	template <typename T> auto set() -> void {
-		std::string_view typeName = typeid(T).name();
+	BasicSignature() = default;
 
-		// Assert that the component has not been registered before.
-		assert(signature.find(typeName) == signature.end() &&
-			   "Registering component type more than once.");
+	auto set(ComponentTypeId type) -> void {
+		assert(type < Bits && "Component type id exceeds signature width.");
+		signature.set(type);
+	}
 
-		signature.insert({typeName, true});
+	auto unset(ComponentTypeId type) -> void {
+		assert(type < Bits && "Component type id exceeds signature width.");
+		signature.reset(type);
 	}
 
-	template <typename T> auto unset() -> void {
-		std::string_view typeName = typeid(T).name();
-		signature.insert({typeName, false});
+	[[nodiscard]] auto get(ComponentTypeId type) const -> bool {
+		return type < Bits && signature.test(type);
 	}
 
-	template <typename T> auto get() -> bool {
-		std::string_view typeName = typeid(T).name();
-		if (signature.find(typeName) == signature.end()) {
-			return false;
-		}
-		return signature.at(typeName);
+	template <typename T> auto set() -> void { set(componentTypeId<T>()); }
+
+	template <typename T> auto unset() -> void { unset(componentTypeId<T>()); }
+
+	template <typename T> [[nodiscard]] auto get() const -> bool {
+		return get(componentTypeId<T>());
 	}
 
-	auto reset() -> void { signature.clear(); }
+	auto reset() -> void { signature.reset(); }
 
-	auto empty() -> bool { return signature.empty(); }
+	[[nodiscard]] auto empty() const -> bool { return signature.none(); }
 
-	auto subsetOf(const std::shared_ptr<Signature> &other) -> bool {
-		return std::ranges::all_of(signature, [&](auto const &pair) {
-			if (other->signature.find(pair.first) == other->signature.end()) {
-				return false;
-			}
-			if (pair.second != other->signature.at(pair.first)) {
-				return false;
-			}
-			return true;
-		});
+	[[nodiscard]] auto count() const -> std::size_t {
+		return signature.count();
+	}
+
+	/**
+	 * @brief Check whether every component type in this signature is also in
+	 * the other signature.
+	 */
+	[[nodiscard]] auto subsetOf(BasicSignature const &other) const -> bool {
+		return (signature & other.signature) == signature;
+	}
+
+	[[nodiscard]] auto
+	subsetOf(const std::shared_ptr<BasicSignature> &other) const -> bool {
+		return subsetOf(*other);
+	}
+
+	[[nodiscard]] auto intersects(BasicSignature const &other) const -> bool {
+		return (signature & other.signature).any();
 	}
 
-	auto operator&(Signature const &other) -> Signature {
-		Signature result;
-		for (auto const &[key, value] : signature) {
-			if (other.signature.find(key) != other.signature.end()) {
-				result.signature.insert(
-					{key, value && other.signature.at(key)});
+	/**
+	 * @brief Call fn with the id of every component type in the signature.
+	 */
+	template <typename Fn> auto forEach(Fn &&fn) const -> void {
+		for (std::size_t type = 0; type < Bits; type++) {
+			if (signature.test(type)) {
+				fn(static_cast<ComponentTypeId>(type));
 			}
 		}
-		return result;
 	}
 
-	auto operator==(Signature const &other) -> bool {
-		return std::ranges::all_of(signature, [&](auto const &pair) {
-			if (other.signature.find(pair.first) == other.signature.end()) {
-				return false;
-			}
-			if (pair.second != other.signature.at(pair.first)) {
-				return false;
-			}
-			return true;
-		});
+	auto operator&(BasicSignature const &other) const -> BasicSignature {
+		BasicSignature result;
+		result.signature = signature & other.signature;
+		return result;
 	}
 
-	auto operator!=(Signature const &other) -> bool {
-		return !(*this == other);
+	auto operator|(BasicSignature const &other) const -> BasicSignature {
+		BasicSignature result;
+		result.signature = signature | other.signature;
+		return result;
 	}
 
-	auto operator=(Signature const &other) -> Signature & = default;
+	auto operator==(BasicSignature const &other) const -> bool = default;
+
+	[[nodiscard]] auto hash() const -> std::size_t {
+		return std::hash<std::bitset<Bits>>{}(signature);
+	}
 };
+
+using Signature = BasicSignature<GIM_ECS_MAX_COMPONENTS>;
 } // namespace gim::ecs
+
+template <std::size_t Bits> struct std::hash<gim::ecs::BasicSignature<Bits>> {
+	auto operator()(gim::ecs::BasicSignature<Bits> const &signature) const
+		-> std::size_t {
+		return signature.hash();
+	}
+};
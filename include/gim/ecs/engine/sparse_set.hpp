@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <gim/ecs/engine/entity_manager.hpp>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace gim::ecs {
+/**
+ * @brief A sparse set of entities.
+ *
+ * The sparse side maps an entity index to its position in the packed
+ * (dense) entity vector and is allocated in fixed size pages on demand so
+ * that large entity ids don't allocate memory for every id below them. The
+ * dense side is a contiguous vector of entity handles which is what gets
+ * iterated, comparing against it rejects handles from an older generation
+ * of the same slot without a further lookup.
+ *
+ * Lookup, insertion and removal are all O(1). Removal moves the last
+ * entity into the vacated slot (swap-and-pop) so the dense vector never has
+ * holes, owners of parallel payload arrays must mirror the move using the
+ * index returned from erase().
+ */
+class SparseSet {
+  public:
+    using Index = std::uint32_t;
+    static constexpr Index npos = std::numeric_limits<Index>::max();
+    static constexpr std::size_t PageSize = 4096;
+
+  private:
+    using Page = std::array<Index, PageSize>;
+
+    std::vector<std::unique_ptr<Page>> sparse;
+    std::vector<Entity> dense;
+
+    static auto pageOf(Entity entity) -> std::size_t {
+        return static_cast<std::size_t>(entityIndex(entity)) / PageSize;
+    }
+
+    static auto offsetOf(Entity entity) -> std::size_t {
+        return static_cast<std::size_t>(entityIndex(entity)) % PageSize;
+    }
+
+    auto slot(Entity entity) -> Index & {
+        auto page = pageOf(entity);
+
+        if (page >= sparse.size()) {
+            sparse.resize(page + 1);
+        }
+
+        if (!sparse[page]) {
+            sparse[page] = std::make_unique<Page>();
+            sparse[page]->fill(npos);
+        }
+
+        return (*sparse[page])[offsetOf(entity)];
+    }
+
+  public:
+    SparseSet() = default;
+
+    /**
+     * @brief Get the dense index of an entity.
+     *
+     * @return Index The index into entities(), or npos if the entity is not
+     * in the set.
+     */
+    [[nodiscard]] auto index(Entity entity) const -> Index {
+        auto page = pageOf(entity);
+
+        if (page >= sparse.size() || !sparse[page]) {
+            return npos;
+        }
+
+        auto position = (*sparse[page])[offsetOf(entity)];
+        return position != npos && dense[position] == entity ? position : npos;
+    }
+
+    [[nodiscard]] auto contains(Entity entity) const -> bool {
+        return index(entity) != npos;
+    }
+
+    /**
+     * @brief Add an entity to the set.
+     *
+     * @return Index The dense index of the entity, if the entity (or a
+     * stale handle to its slot) was already in the set that index is
+     * returned and now belongs to the entity.
+     */
+    auto insert(Entity entity) -> Index {
+        auto &position = slot(entity);
+
+        if (position == npos) {
+            position = static_cast<Index>(dense.size());
+            dense.push_back(entity);
+        } else {
+            dense[position] = entity;
+        }
+
+        return position;
+    }
+
+    /**
+     * @brief Remove an entity from the set.
+     *
+     * @return Index The dense index that was vacated and is now occupied by
+     * what used to be the last entity, or npos if the entity was not in the
+     * set.
+     */
+    auto erase(Entity entity) -> Index {
+        auto removed = index(entity);
+
+        if (removed == npos) {
+            return npos;
+        }
+
+        auto last = dense.back();
+        dense[removed] = last;
+        slot(last) = removed;
+        slot(entity) = npos;
+        dense.pop_back();
+
+        return removed;
+    }
+
+    auto clear() -> void {
+        sparse.clear();
+        dense.clear();
+    }
+
+    auto reserve(std::size_t capacity) -> void { dense.reserve(capacity); }
+
+    [[nodiscard]] auto size() const -> std::size_t { return dense.size(); }
+
+    [[nodiscard]] auto empty() const -> bool { return dense.empty(); }
+
+    [[nodiscard]] auto entities() const -> std::vector<Entity> const & {
+        return dense;
+    }
+
+    [[nodiscard]] auto begin() const { return dense.begin(); }
+    [[nodiscard]] auto end() const { return dense.end(); }
+};
+} // namespace gim::ecs
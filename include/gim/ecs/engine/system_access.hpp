@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <gim/ecs/engine/signature.hpp>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+
+namespace gim::ecs {
+/**
+ * @brief A list of component types used to declare what a system reads and
+ * writes.
+ */
+template <typename... Ts> struct Components {
+    static auto signature() -> Signature {
+        Signature signature;
+        (signature.set<Ts>(), ...);
+        return signature;
+    }
+};
+
+/**
+ * @brief A list of resource types used to declare which resources a system
+ * reads and writes.
+ */
+template <typename... Ts> struct Resources : Components<Ts...> {};
+
+/**
+ * @brief A list of system types used to declare which systems must have
+ * finished updating before a system runs.
+ */
+template <typename... Ts> struct Systems {
+    static auto types() -> std::vector<std::type_index> {
+        return {std::type_index(typeid(Ts))...};
+    }
+};
+
+/**
+ * @brief When a system runs in a frame. The engine loop runs the simulation
+ * stage at a fixed rate, possibly several times a frame, and the render
+ * stage once every frame.
+ */
+enum class Stage : std::uint8_t { Simulation, Render };
+
+/**
+ * @brief What a system touches and where it may run, read from optional
+ * declarations on the system class:
+ *
+ * @code
+ * class Physics : public ISystem {
+ *   public:
+ *     using Reads = gim::ecs::Components<Velocity>;
+ *     using Writes = gim::ecs::Components<Position>;
+ *     using After = gim::ecs::Systems<Input>;
+ *     using ReadsResources = gim::ecs::Resources<Time>;
+ *     static constexpr bool mainThreadOnly = false;
+ *     static constexpr auto stage = gim::ecs::Stage::Simulation;
+ * };
+ * @endcode
+ *
+ * Resources share the type id space with components, so both are tracked
+ * in the same signatures. Systems which declare none of Reads, Writes,
+ * ReadsResources and WritesResources are treated as touching everything, so
+ * they never run alongside another system.
+ */
+struct SystemAccess {
+    Signature reads;
+    Signature writes;
+    bool exclusive = false;
+    bool mainThreadOnly = false;
+    Stage stage = Stage::Simulation;
+    std::vector<std::type_index> after;
+
+    template <typename T> static auto of() -> SystemAccess {
+        SystemAccess access;
+
+        constexpr bool declaresReads = requires { typename T::Reads; };
+        constexpr bool declaresWrites = requires { typename T::Writes; };
+        constexpr bool declaresResourceReads =
+            requires { typename T::ReadsResources; };
+        constexpr bool declaresResourceWrites =
+            requires { typename T::WritesResources; };
+
+        if constexpr (declaresReads) {
+            access.reads = T::Reads::signature();
+        }
+        if constexpr (declaresWrites) {
+            access.writes = T::Writes::signature();
+        }
+        if constexpr (declaresResourceReads) {
+            access.reads = access.reads | T::ReadsResources::signature();
+        }
+        if constexpr (declaresResourceWrites) {
+            access.writes = access.writes | T::WritesResources::signature();
+        }
+        access.exclusive = !declaresReads && !declaresWrites &&
+                           !declaresResourceReads && !declaresResourceWrites;
+
+        if constexpr (requires { T::mainThreadOnly; }) {
+            access.mainThreadOnly = T::mainThreadOnly;
+        }
+        if constexpr (requires { T::stage; }) {
+            access.stage = T::stage;
+        }
+        if constexpr (requires { typename T::After; }) {
+            access.after = T::After::types();
+        }
+
+        return access;
+    }
+
+    /**
+     * @brief Whether two systems may not run at the same time because one
+     * of them writes something the other touches.
+     */
+    [[nodiscard]] auto conflictsWith(SystemAccess const &other) const -> bool {
+        return exclusive || other.exclusive ||
+               writes.intersects(other.reads | other.writes) ||
+               other.writes.intersects(reads | writes);
+    }
+};
+} // namespace gim::ecs
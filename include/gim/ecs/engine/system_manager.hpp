@@ -1,12 +1,25 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <exception>
+#include <functional>
+#include <gim/ecs/engine/command_buffer.hpp>
 #include <gim/ecs/engine/component_manager.hpp>
 #include <gim/ecs/engine/entity_manager.hpp>
+#include <gim/ecs/engine/resource_manager.hpp>
 #include <gim/ecs/engine/signature.hpp>
-#include <map>
+#include <gim/ecs/engine/sparse_set.hpp>
+#include <gim/ecs/engine/system_access.hpp>
+#include <gim/ecs/engine/tick.hpp>
+#include <gim/library/jobs.hpp>
+#include <gim/library/profiler.hpp>
 #include <memory>
-#include <string_view>
+#include <mutex>
+#include <stdexcept>
+#include <typeindex>
 #include <typeinfo>
 #include <utility>
 #include <vector>
@@ -14,17 +27,97 @@
 namespace gim::ecs {
 /**
  * @brief The ISystem class is the base class for all systems.
+ *
+ * The SystemManager keeps the entities whose signature contains the
+ * system's signature in a sparse set per system, so joining and leaving a
+ * system is O(1). Systems with an empty signature don't track entities.
  */
 class ISystem {
+  private:
+	CommandBuffer *commandBuffer = nullptr;
+	ResourceManager *resources = nullptr;
+	SparseSet entities;
+	// The tick after this system's last update, 0 if it never ran.
+	Tick lastRun = 0;
+
   public:
 	virtual ~ISystem() = default;
 	virtual auto getSignature() -> std::shared_ptr<Signature> = 0;
 	virtual void update() = 0;
-	virtual auto getEntities() -> std::vector<Entity> const & = 0;
-	virtual void insertEntity(Entity entity) = 0;
-	virtual void removeEntity(Entity entity) = 0;
 	virtual void setComponentManager(std::shared_ptr<ComponentManager> cm) = 0;
 	virtual auto getComponentManager() -> std::shared_ptr<ComponentManager> = 0;
+
+	[[nodiscard]] auto getEntities() const -> std::vector<Entity> const & {
+		return entities.entities();
+	}
+
+	[[nodiscard]] auto hasEntity(Entity entity) const -> bool {
+		return entities.contains(entity);
+	}
+
+	auto insertEntity(Entity entity) -> void { entities.insert(entity); }
+
+	auto removeEntity(Entity entity) -> void { entities.erase(entity); }
+
+	auto setCommandBuffer(CommandBuffer *commands) -> void {
+		commandBuffer = commands;
+	}
+
+	/**
+	 * @brief Where to record structural changes made during update(), they
+	 * are applied once every system has been updated.
+	 */
+	auto commands() -> CommandBuffer & {
+		assert(commandBuffer != nullptr &&
+			   "System is not registered with an ECS.");
+		return *commandBuffer;
+	}
+
+	auto setResourceManager(ResourceManager *resourceManager) -> void {
+		resources = resourceManager;
+	}
+
+	/**
+	 * @brief The resource of type T, request `const T` for read only access.
+	 * Declare the access with ReadsResources and WritesResources so the
+	 * scheduler can order the system.
+	 */
+	template <typename T> auto resource() -> T & {
+		assert(resources != nullptr && "System is not registered with an ECS.");
+		return resources->get<T>(getComponentManager()->currentTick());
+	}
+
+	/**
+	 * @brief Whether the resource of type T was inserted or mutably accessed
+	 * since this system last updated.
+	 */
+	template <typename T> auto resourceChanged() -> bool {
+		assert(resources != nullptr && "System is not registered with an ECS.");
+		auto const *ticks = resources->ticks<T>();
+		return ticks != nullptr && tickAtOrAfter(ticks->changed, lastRun);
+	}
+
+	[[nodiscard]] auto getLastRun() const -> Tick { return lastRun; }
+
+	auto setLastRun(Tick tick) -> void { lastRun = tick; }
+
+	/**
+	 * @brief The entities whose T was added or mutably accessed since this
+	 * system last updated, changes the system made itself are not included.
+	 */
+	template <typename T, typename... Ts> auto changed() {
+		return getComponentManager()->template view<T, Ts...>().changedSince(
+			lastRun);
+	}
+
+	/**
+	 * @brief The entities which were given a T since this system last
+	 * updated.
+	 */
+	template <typename T, typename... Ts> auto added() {
+		return getComponentManager()->template view<T, Ts...>().addedSince(
+			lastRun);
+	}
 };
 
 template <class T>
@@ -32,12 +125,43 @@ concept System = std::is_base_of_v<ISystem, T>;
 
 class SystemManager {
   private:
-	std::vector<std::unique_ptr<ISystem>> systems;
+	struct Node {
+		std::unique_ptr<ISystem> system;
+		std::type_index type;
+		// The zone name of the system's updates, only called when profiling.
+		const char *(*name)();
+		// Cached so membership checks don't call into the system.
+		Signature signature;
+		SystemAccess access;
+		// Systems which can only start once this one has finished.
+		std::vector<std::size_t> dependents;
+		std::size_t dependencies = 0;
+	};
+
+	std::vector<Node> systems;
+	// The systems whose signature contains each component type, indexed by
+	// ComponentTypeId.
+	std::array<std::vector<std::size_t>, Signature::capacity> systemsByComponent;
 	std::shared_ptr<ComponentManager> componentManager;
-	template <System T> auto findSystem() -> int {
+	gim::library::jobs::JobSystem *jobs;
+	CommandBuffer *commandBuffer = nullptr;
+	ResourceManager *resources = nullptr;
+
+	// The order systems run in when run one after another, respecting
+	// every After declaration.
+	std::vector<std::size_t> order;
+	bool scheduled = false;
+
+	// The state of the frame being updated.
+	std::unique_ptr<std::atomic<std::size_t>[]> remaining;
+	std::atomic<std::size_t> pending{0};
+	std::mutex errorMutex;
+	std::exception_ptr error;
+
+	template <System T> auto findSystem() -> std::size_t {
 		return std::find_if(systems.begin(), systems.end(),
-							[&](const std::unique_ptr<ISystem> &system) {
-								return typeid(system.get()) == typeid(T);
+							[&](const Node &node) {
+								return node.type == std::type_index(typeid(T));
 							}) -
 			   systems.begin();
 	}
@@ -45,36 +169,275 @@ class SystemManager {
 		return findSystem<T>() != systems.size();
 	}
 
+	/**
+	 * @brief Build the dependency graph between systems. Systems are first
+	 * ordered by their After declarations (keeping registration order
+	 * otherwise), then every pair of systems which conflict on a component
+	 * gets an edge in that order.
+	 */
+	auto schedule() -> void {
+		auto count = systems.size();
+		std::vector<std::vector<bool>> edges(count,
+											 std::vector<bool>(count, false));
+
+		for (std::size_t to = 0; to < count; to++) {
+			for (auto const &type : systems[to].access.after) {
+				for (std::size_t from = 0; from < count; from++) {
+					if (systems[from].type == type && from != to) {
+						edges[from][to] = true;
+					}
+				}
+			}
+		}
+
+		// Keep registration order, except that systems named in an After
+		// declaration are pulled in front of the system declaring it.
+		order.clear();
+		std::vector<int> state(count, 0); // 0 unvisited, 1 visiting, 2 placed
+		std::function<void(std::size_t)> visit = [&](std::size_t index) {
+			if (state[index] == 2) {
+				return;
+			}
+			if (state[index] == 1) {
+				throw std::runtime_error(
+					"System After declarations form a cycle.\n");
+			}
+			state[index] = 1;
+			for (std::size_t from = 0; from < count; from++) {
+				if (edges[from][index]) {
+					visit(from);
+				}
+			}
+			state[index] = 2;
+			order.push_back(index);
+		};
+		for (std::size_t index = 0; index < count; index++) {
+			visit(index);
+		}
+
+		for (std::size_t p = 0; p < count; p++) {
+			for (std::size_t q = p + 1; q < count; q++) {
+				auto from = order[p];
+				auto to = order[q];
+				if (systems[from].access.conflictsWith(systems[to].access)) {
+					edges[from][to] = true;
+				}
+			}
+		}
+
+		for (std::size_t from = 0; from < count; from++) {
+			systems[from].dependents.clear();
+			systems[from].dependencies = 0;
+		}
+		// Stages run one after another, so only systems in the same stage
+		// wait on each other.
+		for (std::size_t from = 0; from < count; from++) {
+			for (std::size_t to = 0; to < count; to++) {
+				if (edges[from][to] &&
+					systems[from].access.stage == systems[to].access.stage) {
+					systems[from].dependents.push_back(to);
+					systems[to].dependencies++;
+				}
+			}
+		}
+
+		remaining = std::make_unique<std::atomic<std::size_t>[]>(count);
+		scheduled = true;
+	}
+
+	static auto updateMembership(Node &node, Entity entity,
+								 const Signature &entitySignature) -> void {
+		if (!node.signature.empty() &&
+			node.signature.subsetOf(entitySignature)) {
+			node.system->insertEntity(entity);
+		} else {
+			node.system->removeEntity(entity);
+		}
+	}
+
+	auto dispatch(std::size_t index) -> void {
+		if (systems[index].access.mainThreadOnly) {
+			jobs->submitMain([this, index] { run(index); });
+		} else {
+			jobs->submit([this, index] { run(index); });
+		}
+	}
+
+	// Everything the system changed is stamped with an earlier tick than
+	// the one it records, so it doesn't see its own changes next update.
+	auto updateSystem(Node &node) -> void {
+		{
+			GIM_PROFILE_ZONE(node.name());
+			node.system->update();
+		}
+		node.system->setLastRun(componentManager->advanceTick());
+	}
+
+	auto run(std::size_t index) -> void {
+		try {
+			updateSystem(systems[index]);
+		} catch (...) {
+			std::lock_guard lock(errorMutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+
+		for (auto dependent : systems[index].dependents) {
+			if (remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) ==
+				1) {
+				dispatch(dependent);
+			}
+		}
+		pending.fetch_sub(1, std::memory_order_release);
+	}
+
   public:
-	explicit SystemManager(std::shared_ptr<ComponentManager> componentManager) {
+	explicit SystemManager(std::shared_ptr<ComponentManager> componentManager,
+						   gim::library::jobs::JobSystem &jobs =
+							   gim::library::jobs::JobSystem::instance())
+		: jobs(&jobs) {
 		this->componentManager = std::move(componentManager);
 	}
 
 	template <System T> auto registerSystem() -> void {
 		assert(!systemRegistered<T>() && "Registering system more than once.");
 
-		systems.emplace_back(std::make_unique<T>());
-		systems.back()->setComponentManager(componentManager);
+		auto system = std::make_unique<T>();
+		auto signature = *system->getSignature();
+
+		signature.forEach([&](ComponentTypeId type) {
+			systemsByComponent[type].push_back(systems.size());
+		});
+
+		systems.push_back(Node{
+			.system = std::move(system),
+			.type = std::type_index(typeid(T)),
+			.name = &gim::library::profiler::typeName<T>,
+			.signature = signature,
+			.access = SystemAccess::of<T>(),
+			.dependents = {},
+		});
+		systems.back().system->setComponentManager(componentManager);
+		systems.back().system->setCommandBuffer(commandBuffer);
+		systems.back().system->setResourceManager(resources);
+		scheduled = false;
 	}
 
-	auto
-	entitySignatureChanged(Entity entity,
-						   const std::shared_ptr<Signature> &entitySignature)
-		-> void {
-		for (auto const &system : systems) {
-			auto const &systemSignature = system->getSignature();
+	template <System T> auto getSystem() -> T & {
+		auto index = findSystem<T>();
+		assert(index != systems.size() && "System not registered.");
+		return static_cast<T &>(*systems[index].system);
+	}
+
+	/**
+	 * @brief Give every system, including ones registered later, a command
+	 * buffer to record structural changes into.
+	 */
+	auto setCommandBuffer(CommandBuffer *commands) -> void {
+		commandBuffer = commands;
+		for (auto &node : systems) {
+			node.system->setCommandBuffer(commands);
+		}
+	}
+
+	/**
+	 * @brief Give every system, including ones registered later, access to
+	 * the engine's resources.
+	 */
+	auto setResourceManager(ResourceManager *resourceManager) -> void {
+		resources = resourceManager;
+		for (auto &node : systems) {
+			node.system->setResourceManager(resourceManager);
+		}
+	}
 
-			if (entitySignature->subsetOf(systemSignature)) {
-				system->insertEntity(entity);
-			} else {
-				system->removeEntity(entity);
+	/**
+	 * @brief Re-evaluate which systems an entity belongs to, only looking at
+	 * the systems which require one of the changed component types.
+	 */
+	auto entitySignatureChanged(Entity entity, const Signature &entitySignature,
+								const Signature &changed) -> void {
+		changed.forEach([&](ComponentTypeId type) {
+			for (auto index : systemsByComponent[type]) {
+				updateMembership(systems[index], entity, entitySignature);
 			}
+		});
+	}
+
+	/**
+	 * @brief Re-evaluate every system for an entity.
+	 */
+	auto entitySignatureChanged(Entity entity, const Signature &entitySignature)
+		-> void {
+		for (auto &node : systems) {
+			updateMembership(node, entity, entitySignature);
+		}
+	}
+
+	auto entityDestroyed(Entity entity) -> void {
+		for (auto &node : systems) {
+			node.system->removeEntity(entity);
 		}
 	}
 
+	/**
+	 * @brief Update every system once, the simulation stage first.
+	 */
 	auto update() -> void {
-		for (auto const &system : systems) {
-			system->update();
+		update(Stage::Simulation);
+		update(Stage::Render);
+	}
+
+	/**
+	 * @brief Update every system of one stage once. Systems which don't
+	 * conflict on the components they declare run concurrently on the job
+	 * system, systems declared mainThreadOnly always run on its main thread,
+	 * which has to be the thread calling update().
+	 */
+	auto update(Stage stage) -> void {
+		GIM_PROFILE_ZONE(stage == Stage::Simulation ? "SystemManager::simulate"
+													: "SystemManager::render");
+
+		if (!scheduled) {
+			schedule();
+		}
+
+		std::size_t count = 0;
+		for (auto const &node : systems) {
+			count += node.access.stage == stage ? 1 : 0;
+		}
+
+		if (count < 2 || jobs->concurrency() == 1) {
+			for (auto index : order) {
+				if (systems[index].access.stage == stage) {
+					updateSystem(systems[index]);
+				}
+			}
+			return;
+		}
+
+		assert(jobs->isMainThread() &&
+			   "Systems are updated from the job system's main thread.");
+		pending.store(count, std::memory_order_relaxed);
+		error = nullptr;
+		for (std::size_t index = 0; index < systems.size(); index++) {
+			remaining[index].store(systems[index].dependencies,
+								   std::memory_order_relaxed);
+		}
+		for (auto index : order) {
+			if (systems[index].access.stage == stage &&
+				systems[index].dependencies == 0) {
+				dispatch(index);
+			}
+		}
+
+		// Helping runs the main thread lane, where mainThreadOnly systems go.
+		jobs->helpUntil(
+			[&] { return pending.load(std::memory_order_acquire) == 0; });
+
+		if (error) {
+			std::rethrow_exception(error);
 		}
 	}
 };
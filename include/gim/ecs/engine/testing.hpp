@@ -12,13 +12,20 @@ class TestComponent : public IComponent {
 	explicit TestComponent(int x) : x(x) {}
 };
 
+// A component which opts in to living by value in its component array.
+struct TestValueComponent {
+	static constexpr auto storage = Storage::Value;
+
+	int x = 0;
+};
+
 class TestSystem : public ISystem {
   private:
-	std::vector<Entity> entities;
 	std::shared_ptr<ComponentManager> componentManager;
 
   public:
-	auto self() -> TestSystem *const override { return this; }
+	using Writes = Components<TestComponent>;
+
 	auto getSignature() -> std::shared_ptr<Signature> override {
 		auto signature = std::make_shared<Signature>();
 		signature->set<TestComponent>();
@@ -26,26 +33,13 @@ class TestSystem : public ISystem {
 	}
 
 	auto update() -> void override {
-		for (auto const &entity : entities) {
+		for (auto const &entity : getEntities()) {
 			auto tc =
 				getComponentManager()->getComponent<TestComponent>(entity);
 			tc->x++;
 		}
 	}
 
-	auto insertEntity(Entity entity) -> void override {
-		entities.push_back(entity);
-	}
-
-	auto removeEntity(Entity entity) -> void override {
-		entities.erase(std::remove(entities.begin(), entities.end(), entity),
-					   entities.end());
-	}
-
-	auto getEntities() -> std::vector<Entity> const & override {
-		return entities;
-	}
-
 	auto setComponentManager(std::shared_ptr<ComponentManager> cm)
 		-> void override {
 		componentManager = cm;
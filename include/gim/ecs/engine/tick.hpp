@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace gim::ecs {
+/**
+ * @brief A point in the life of the ECS, advanced every time a system
+ * finishes updating. Component slots remember the tick they were added and
+ * last mutably accessed at, so a system can ask what changed since it last
+ * ran.
+ */
+using Tick = std::uint32_t;
+
+/**
+ * @brief Whether tick is at or after since. Ticks wrap around, so ticks
+ * more than 2^31 apart compare the wrong way round.
+ */
+constexpr auto tickAtOrAfter(Tick tick, Tick since) -> bool {
+    return static_cast<std::int32_t>(tick - since) >= 0;
+}
+
+struct ComponentTicks {
+    Tick added = 0;
+    Tick changed = 0;
+};
+
+/**
+ * @brief The tick counter of a component manager. Starts at 1 so everything
+ * counts as new to a system which hasn't run yet (last run 0).
+ */
+class TickClock {
+  private:
+    std::atomic<Tick> tick{1};
+
+  public:
+    [[nodiscard]] auto now() const -> Tick {
+        return tick.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Move on to the next tick.
+     *
+     * @return Tick The new tick, changes made before the call are older
+     * than it.
+     */
+    auto advance() -> Tick {
+        return tick.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+};
+} // namespace gim::ecs
@@ -0,0 +1,637 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <gim/ecs/engine/archetype.hpp>
+#include <gim/ecs/engine/component_array.hpp>
+#include <gim/ecs/engine/component_type.hpp>
+#include <gim/ecs/engine/entity_manager.hpp>
+#include <gim/ecs/engine/signature.hpp>
+#include <gim/ecs/engine/sparse_set.hpp>
+#include <gim/ecs/engine/tick.hpp>
+#include <gim/library/arena.hpp>
+#include <gim/library/jobs.hpp>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gim::ecs {
+namespace detail {
+/**
+ * @brief How many items each job of a parallel loop gets: about four ranges
+ * per thread so stealing can even out the load, never less than a few cache
+ * lines of work, and a multiple of the items spanning a whole number of
+ * cache lines. When the driving column starts on a cache line, as Pod
+ * columns do, range boundaries then fall on line boundaries and two threads
+ * never write to the same line of it. Value and Shared columns are plain
+ * vectors without that alignment, where this only keeps ranges line sized.
+ */
+template <typename Stored>
+auto parallelGrain(std::size_t count, std::size_t threads) -> std::size_t {
+    constexpr std::size_t line = library::jobs::CacheLine;
+    // The fewest items which end on a line boundary, lcm(size, line) / size.
+    constexpr std::size_t perLines = line / std::gcd(sizeof(Stored), line);
+    constexpr std::size_t minimum =
+        std::max<std::size_t>(line / sizeof(Stored), 1) * 16;
+
+    auto grain = std::max(count / (threads * 4), minimum);
+    return (grain + perLines - 1) / perLines * perLines;
+}
+
+/**
+ * @brief Combine the per thread partial results of a parallel reduction.
+ */
+template <typename T, typename Combine>
+auto combinePartials(library::jobs::PerThread<T> &partials, T identity,
+                     Combine &combine) -> T {
+    auto result = std::move(identity);
+    partials.each(
+        [&](T &partial) { result = combine(std::move(result), partial); });
+    return result;
+}
+
+/**
+ * @brief Restricts a view to the entities whose first component was added
+ * or changed at or after a tick.
+ */
+struct TickFilter {
+    enum class Kind : std::uint8_t { None, Added, Changed };
+
+    Kind kind = Kind::None;
+    Tick since = 0;
+
+    [[nodiscard]] auto passes(ComponentTicks const &ticks) const -> bool {
+        switch (kind) {
+        case Kind::Added:
+            return tickAtOrAfter(ticks.added, since);
+        case Kind::Changed:
+            return tickAtOrAfter(ticks.changed, since);
+        default:
+            return true;
+        }
+    }
+};
+} // namespace detail
+
+/**
+ * @brief A lazy query over every entity which has all of the components
+ * Ts, backed by per-type sparse component arrays.
+ *
+ * Iteration walks the packed entities of the smallest of the requested
+ * arrays and probes the others in O(1). Requesting `const T` yields a const
+ * reference. Views don't allocate, but adding or removing any of the viewed
+ * component types while iterating is not supported.
+ *
+ * Handing out a non-const component marks it as changed, addedSince() and
+ * changedSince() narrow a view down to entities whose first component was
+ * added or changed at or after a tick.
+ *
+ * @code
+ * for (auto [entity, position, velocity] : ecs.view<Position, const Velocity>())
+ *     position.x += velocity.x;
+ *
+ * ecs.view<Position, const Velocity>().each(
+ *     [](Entity entity, Position &position, const Velocity &velocity) {});
+ * @endcode
+ *
+ * parallelEach() and parallelReduce() split the driving array into ranges
+ * run on the job system, see ArchetypeView for the rules fn must follow.
+ */
+template <typename... Ts> class SparseView {
+    static_assert(sizeof...(Ts) > 0, "A view needs at least one component.");
+
+  public:
+    using Value = std::tuple<Entity, Ts &...>;
+
+  private:
+    using Slots = std::array<SparseSet::Index, sizeof...(Ts)>;
+
+    std::tuple<ComponentArray<std::remove_const_t<Ts>> *...> arrays;
+    // The smallest array, its entities are the ones iterated.
+    std::size_t driver = 0;
+    std::vector<Entity> const *driving = nullptr;
+    // Components handed out mutably are stamped as changed at this tick.
+    Tick now = 0;
+    detail::TickFilter filter;
+
+    template <std::size_t I>
+    using Type = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    auto slotsOf(Entity entity) const -> Slots {
+        return std::apply(
+            [&](auto *...array) { return Slots{array->indexOf(entity)...}; },
+            arrays);
+    }
+
+    // The slot of component I of the entity at index of the driving array K.
+    template <std::size_t I, std::size_t K>
+    auto slotOf(Entity entity, std::size_t index) const -> SparseSet::Index {
+        if constexpr (I == K) {
+            return static_cast<SparseSet::Index>(index);
+        } else {
+            return std::get<I>(arrays)->indexOf(entity);
+        }
+    }
+
+    template <std::size_t... I>
+    auto accepts(Slots const &slots, std::index_sequence<I...> /*unused*/) const
+        -> bool {
+        return ((slots[I] != SparseSet::npos) && ...) &&
+               filter.passes(std::get<0>(arrays)->ticksAt(slots[0]));
+    }
+
+    auto matches(Entity entity) const -> bool {
+        return accepts(slotsOf(entity), std::index_sequence_for<Ts...>{});
+    }
+
+    // Hand out component I, stamping it as changed unless it is const.
+    template <std::size_t I>
+    auto yield(SparseSet::Index slot) const -> Type<I> & {
+        auto *array = std::get<I>(arrays);
+        if constexpr (!std::is_const_v<Type<I>>) {
+            array->ticksAt(slot).changed = now;
+        }
+        return array->componentAt(slot);
+    }
+
+    template <std::size_t... I>
+    auto valueOf(Entity entity, std::index_sequence<I...> /*unused*/) const
+        -> Value {
+        auto slots = slotsOf(entity);
+        return Value(entity, yield<I>(slots[I])...);
+    }
+
+    // Visit the matching entities among [begin, end) of the driving array K.
+    template <std::size_t K, typename Fn, std::size_t... I>
+    auto eachDrivenBy(Fn &fn, std::size_t begin, std::size_t end,
+                      std::index_sequence<I...> sequence) const -> void {
+        auto const &entities = std::get<K>(arrays)->getEntities();
+
+        for (std::size_t index = begin; index < end; index++) {
+            auto entity = entities[index];
+            Slots slots{slotOf<I, K>(entity, index)...};
+
+            if (accepts(slots, sequence)) {
+                fn(entity, yield<I>(slots[I])...);
+            }
+        }
+    }
+
+    // Call fn with the index of the driving array as a compile time
+    // constant.
+    template <typename Fn> auto withDriver(Fn &&fn) const -> void {
+        [&]<std::size_t... K>(std::index_sequence<K...> /*unused*/) {
+            ((driver == K
+                  ? (fn(std::integral_constant<std::size_t, K>{}), true)
+                  : false) ||
+             ...);
+        }(std::index_sequence_for<Ts...>{});
+    }
+
+  public:
+    class Iterator {
+      private:
+        SparseView const *view = nullptr;
+        std::size_t index = 0;
+
+        auto skip() -> void {
+            auto const &entities = *view->driving;
+            while (index < entities.size() &&
+                   !view->matches(entities[index])) {
+                index++;
+            }
+        }
+
+      public:
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(SparseView const *view, std::size_t index)
+            : view(view), index(index) {
+            skip();
+        }
+
+        auto operator*() const -> Value {
+            return view->valueOf((*view->driving)[index],
+                                 std::index_sequence_for<Ts...>{});
+        }
+
+        auto operator++() -> Iterator & {
+            index++;
+            skip();
+            return *this;
+        }
+
+        auto operator++(int) -> Iterator {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        auto operator==(Iterator const &other) const -> bool {
+            return index == other.index;
+        }
+    };
+
+    explicit SparseView(Tick now,
+                        ComponentArray<std::remove_const_t<Ts>> *...arrays)
+        : arrays(arrays...), now(now) {
+        std::size_t sizes[] = {arrays->size()...};
+        std::vector<Entity> const *entities[] = {&arrays->getEntities()...};
+        driver = static_cast<std::size_t>(
+            std::min_element(std::begin(sizes), std::end(sizes)) -
+            std::begin(sizes));
+        driving = entities[driver];
+    }
+
+    /**
+     * @brief Call fn(entity, components...) for every matching entity.
+     */
+    template <typename Fn> auto each(Fn &&fn) const -> void {
+        withDriver([&](auto driver) {
+            eachDrivenBy<decltype(driver)::value>(
+                fn, 0, driving->size(), std::index_sequence_for<Ts...>{});
+        });
+    }
+
+    /**
+     * @brief Call fn(entity, components...) for every matching entity, in
+     * parallel on the job system.
+     */
+    template <typename Fn>
+    auto parallelEach(Fn &&fn, library::jobs::JobSystem &jobs =
+                                   library::jobs::JobSystem::instance()) const
+        -> void {
+        withDriver([&](auto driver) {
+            constexpr auto K = decltype(driver)::value;
+            auto count = driving->size();
+
+            jobs.parallelFor(
+                count,
+                detail::parallelGrain<StoredComponent<std::remove_const_t<
+                    Type<K>>>>(count, jobs.concurrency()),
+                [&](std::size_t begin, std::size_t end) {
+                    eachDrivenBy<K>(fn, begin, end,
+                                    std::index_sequence_for<Ts...>{});
+                });
+        });
+    }
+
+    /**
+     * @brief Fold map(entity, components...) over every matching entity in
+     * parallel, see ArchetypeView::parallelReduce.
+     */
+    template <typename T, typename Map, typename Combine>
+    auto parallelReduce(T identity, Map &&map, Combine &&combine,
+                        library::jobs::JobSystem &jobs =
+                            library::jobs::JobSystem::instance()) const -> T {
+        library::jobs::PerThread<T> partials(jobs, identity,
+                                             &library::memory::frameArena());
+
+        parallelEach(
+            [&](Entity entity, Ts &...components) {
+                auto &partial = partials.local();
+                partial = combine(std::move(partial), map(entity, components...));
+            },
+            jobs);
+
+        return detail::combinePartials(partials, std::move(identity), combine);
+    }
+
+    /**
+     * @brief The same view restricted to entities whose first component was
+     * added at or after since.
+     */
+    [[nodiscard]] auto addedSince(Tick since) const -> SparseView {
+        auto filtered = *this;
+        filtered.filter = {detail::TickFilter::Kind::Added, since};
+        return filtered;
+    }
+
+    /**
+     * @brief The same view restricted to entities whose first component was
+     * added or mutably accessed at or after since.
+     */
+    [[nodiscard]] auto changedSince(Tick since) const -> SparseView {
+        auto filtered = *this;
+        filtered.filter = {detail::TickFilter::Kind::Changed, since};
+        return filtered;
+    }
+
+    [[nodiscard]] auto begin() const -> Iterator { return {this, 0}; }
+
+    [[nodiscard]] auto end() const -> Iterator {
+        return {this, driving->size()};
+    }
+
+    [[nodiscard]] auto empty() const -> bool { return begin() == end(); }
+};
+
+/**
+ * @brief A lazy query over every entity which has all of the components
+ * Ts, backed by archetype chunks.
+ *
+ * Iteration visits every archetype containing the requested components and
+ * walks its columns chunk by chunk. Like SparseView it doesn't allocate,
+ * doesn't support structural changes while iterating and stamps the
+ * components it hands out mutably as changed.
+ *
+ * parallelEach() and parallelReduce() hand runs of whole chunks to the job
+ * system. fn is called from several threads at once: it may write to the
+ * components it is given but must not touch other entities' components or
+ * add or remove components.
+ */
+template <typename... Ts> class ArchetypeView {
+    static_assert(sizeof...(Ts) > 0, "A view needs at least one component.");
+
+  public:
+    using Value = std::tuple<Entity, Ts &...>;
+    using Archetypes = std::vector<std::unique_ptr<Archetype>>;
+
+  private:
+    Archetypes const *archetypes = nullptr;
+    Signature required;
+    // Components handed out mutably are stamped as changed at this tick.
+    Tick now = 0;
+    detail::TickFilter filter;
+
+    template <std::size_t I>
+    using Type = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    auto matches(std::size_t archetype) const -> bool {
+        auto const &candidate = *(*archetypes)[archetype];
+        return candidate.size() > 0 &&
+               required.subsetOf(candidate.getSignature());
+    }
+
+    auto passes(Archetype const &archetype, std::size_t chunk,
+                std::size_t row) const -> bool {
+        return filter.kind == detail::TickFilter::Kind::None ||
+               filter.passes(ticks<Type<0>>(archetype, chunk)[row]);
+    }
+
+    template <std::size_t I> auto stamp(ComponentTicks &ticks) const -> void {
+        if constexpr (!std::is_const_v<Type<I>>) {
+            ticks.changed = now;
+        }
+    }
+
+    template <std::size_t... I>
+    auto valueAt(Archetype const &archetype, std::size_t chunk,
+                 std::size_t row, std::index_sequence<I...> /*unused*/) const
+        -> Value {
+        (stamp<I>(ticks<Type<I>>(archetype, chunk)[row]), ...);
+        return Value(archetype.entities(chunk)[row],
+                     derefStored<std::remove_const_t<Ts>>(
+                         column<Ts>(archetype, chunk)[row])...);
+    }
+
+    template <typename Fn, std::size_t... I>
+    auto eachInChunk(Archetype const &archetype, std::size_t chunk, Fn &fn,
+                     std::index_sequence<I...> /*unused*/) const -> void {
+        auto rows = archetype.chunkSize(chunk);
+        auto *entities = archetype.entities(chunk);
+        auto columns = std::make_tuple(column<Ts>(archetype, chunk)...);
+        std::array<ComponentTicks *, sizeof...(Ts)> columnTicks{
+            ticks<Ts>(archetype, chunk)...};
+
+        for (std::size_t row = 0; row < rows; row++) {
+            if (!filter.passes(columnTicks[0][row])) {
+                continue;
+            }
+
+            (stamp<I>(columnTicks[I][row]), ...);
+            fn(entities[row], derefStored<std::remove_const_t<Ts>>(
+                                  std::get<I>(columns)[row])...);
+        }
+    }
+
+    template <typename Fn>
+    auto eachInChunk(Archetype const &archetype, std::size_t chunk,
+                     Fn &fn) const -> void {
+        eachInChunk(archetype, chunk, fn, std::index_sequence_for<Ts...>{});
+    }
+
+    template <typename T>
+    static auto column(Archetype const &archetype, std::size_t chunk)
+        -> StoredComponent<std::remove_const_t<T>> * {
+        return archetype
+            .template columnData<StoredComponent<std::remove_const_t<T>>>(
+                chunk, archetype.column(componentTypeId<T>()));
+    }
+
+    template <typename T>
+    static auto ticks(Archetype const &archetype, std::size_t chunk)
+        -> ComponentTicks * {
+        return archetype.ticksData(chunk,
+                                   archetype.column(componentTypeId<T>()));
+    }
+
+  public:
+    class Iterator {
+      private:
+        ArchetypeView const *view = nullptr;
+        std::size_t archetype = 0;
+        std::size_t chunk = 0;
+        std::size_t row = 0;
+
+        auto skip() -> void {
+            auto count = view->archetypes->size();
+            while (archetype < count && !view->matches(archetype)) {
+                archetype++;
+            }
+        }
+
+        auto step() -> void {
+            auto const &current = *(*view->archetypes)[archetype];
+
+            if (++row < current.chunkSize(chunk)) {
+                return;
+            }
+
+            row = 0;
+            if (++chunk < current.chunkCount()) {
+                return;
+            }
+
+            chunk = 0;
+            archetype++;
+            skip();
+        }
+
+        // Step over rows the view's tick filter rejects.
+        auto settle() -> void {
+            auto count = view->archetypes->size();
+            while (archetype < count &&
+                   !view->passes(*(*view->archetypes)[archetype], chunk, row)) {
+                step();
+            }
+        }
+
+      public:
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(ArchetypeView const *view, std::size_t archetype)
+            : view(view), archetype(archetype) {
+            skip();
+            settle();
+        }
+
+        auto operator*() const -> Value {
+            return view->valueAt(*(*view->archetypes)[archetype], chunk, row,
+                                 std::index_sequence_for<Ts...>{});
+        }
+
+        auto operator++() -> Iterator & {
+            step();
+            settle();
+            return *this;
+        }
+
+        auto operator++(int) -> Iterator {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        auto operator==(Iterator const &other) const -> bool {
+            return archetype == other.archetype && chunk == other.chunk &&
+                   row == other.row;
+        }
+    };
+
+    ArchetypeView(Archetypes const &archetypes, Signature required, Tick now)
+        : archetypes(&archetypes), required(required), now(now) {}
+
+    /**
+     * @brief Call fn(entity, components...) for every matching entity, chunk
+     * by chunk.
+     */
+    template <typename Fn> auto each(Fn &&fn) const -> void {
+        for (std::size_t index = 0; index < archetypes->size(); index++) {
+            if (!matches(index)) {
+                continue;
+            }
+
+            auto const &archetype = *(*archetypes)[index];
+
+            for (std::size_t chunk = 0; chunk < archetype.chunkCount();
+                 chunk++) {
+                eachInChunk(archetype, chunk, fn);
+            }
+        }
+    }
+
+    /**
+     * @brief Call fn(entity, components...) for every matching entity, in
+     * parallel on the job system. Work is split into runs of whole chunks,
+     * every chunk is an allocation of its own starting on a cache line, so
+     * threads never share a line of a column.
+     */
+    template <typename Fn>
+    auto parallelEach(Fn &&fn, library::jobs::JobSystem &jobs =
+                                   library::jobs::JobSystem::instance()) const
+        -> void {
+        std::size_t chunks = 0;
+        for (std::size_t index = 0; index < archetypes->size(); index++) {
+            if (matches(index)) {
+                chunks += (*archetypes)[index]->chunkCount();
+            }
+        }
+
+        auto grain = std::max<std::size_t>(chunks / (jobs.concurrency() * 4), 1);
+
+        jobs.parallelFor(chunks, grain, [&](std::size_t begin, std::size_t end) {
+            // Find the archetype holding chunk number begin of the matching
+            // chunks and walk from there.
+            std::size_t first = 0;
+
+            for (std::size_t index = 0;
+                 index < archetypes->size() && first < end; index++) {
+                if (!matches(index)) {
+                    continue;
+                }
+
+                auto const &archetype = *(*archetypes)[index];
+                auto count = archetype.chunkCount();
+
+                for (auto chunk = std::max(begin, first) - first;
+                     chunk < count && first + chunk < end; chunk++) {
+                    eachInChunk(archetype, chunk, fn);
+                }
+
+                first += count;
+            }
+        });
+    }
+
+    /**
+     * @brief Fold map(entity, components...) over every matching entity in
+     * parallel.
+     *
+     * Each thread folds into its own partial result starting from identity,
+     * which are then folded together with combine, so combine must be
+     * associative and the order entities are combined in is unspecified.
+     * The partial results live in the calling thread's frame arena.
+     *
+     * @code
+     * auto mass = view.parallelReduce(
+     *     0.0F, [](Entity, const Body &body) { return body.mass; },
+     *     std::plus<>{});
+     * @endcode
+     */
+    template <typename T, typename Map, typename Combine>
+    auto parallelReduce(T identity, Map &&map, Combine &&combine,
+                        library::jobs::JobSystem &jobs =
+                            library::jobs::JobSystem::instance()) const -> T {
+        library::jobs::PerThread<T> partials(jobs, identity,
+                                             &library::memory::frameArena());
+
+        parallelEach(
+            [&](Entity entity, Ts &...components) {
+                auto &partial = partials.local();
+                partial = combine(std::move(partial), map(entity, components...));
+            },
+            jobs);
+
+        return detail::combinePartials(partials, std::move(identity), combine);
+    }
+
+    /**
+     * @brief The same view restricted to entities whose first component was
+     * added at or after since.
+     */
+    [[nodiscard]] auto addedSince(Tick since) const -> ArchetypeView {
+        auto filtered = *this;
+        filtered.filter = {detail::TickFilter::Kind::Added, since};
+        return filtered;
+    }
+
+    /**
+     * @brief The same view restricted to entities whose first component was
+     * added or mutably accessed at or after since.
+     */
+    [[nodiscard]] auto changedSince(Tick since) const -> ArchetypeView {
+        auto filtered = *this;
+        filtered.filter = {detail::TickFilter::Kind::Changed, since};
+        return filtered;
+    }
+
+    [[nodiscard]] auto begin() const -> Iterator { return {this, 0}; }
+
+    [[nodiscard]] auto end() const -> Iterator {
+        return {this, archetypes->size()};
+    }
+
+    [[nodiscard]] auto empty() const -> bool { return begin() == end(); }
+};
+} // namespace gim::ecs
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <gim/ecs/components/camera.hpp>
+#include <gim/ecs/components/input.hpp>
+#include <gim/ecs/engine/system_manager.hpp>
+#include <gim/ecs/systems/input.hpp>
+#include <gim/library/loop.hpp>
+#include <memory>
+
+namespace gim::ecs::systems {
+/**
+ * @brief Moves the camera once every simulation step from the held WASD keys
+ * and the mouse motion of the tick, by its speed in units per second, so how
+ * fast it moves doesn't depend on the frame rate.
+ */
+class CameraSystem : public gim::ecs::ISystem {
+  private:
+    std::shared_ptr<ComponentManager> componentManager;
+
+  public:
+    using After = Systems<InputSystem>;
+    using ReadsResources = Resources<gim::library::loop::FrameTime,
+                                     gim::ecs::components::Input::State>;
+    using WritesResources = Resources<gim::ecs::components::Camera::Component>;
+
+    auto getSignature() -> std::shared_ptr<Signature> override;
+    auto update() -> void override;
+    auto setComponentManager(std::shared_ptr<ComponentManager> componentManager)
+        -> void override;
+    auto getComponentManager() -> std::shared_ptr<ComponentManager> override;
+};
+} // namespace gim::ecs::systems
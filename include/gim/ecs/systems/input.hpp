@@ -0,0 +1,32 @@
+#pragma once
+
+#include <gim/ecs/components/engine-state.hpp>
+#include <gim/ecs/components/input.hpp>
+#include <gim/ecs/engine/events.hpp>
+#include <gim/ecs/engine/system_manager.hpp>
+#include <memory>
+
+namespace gim::ecs::systems {
+/**
+ * @brief Drains the input queue at the start of every simulation tick into
+ * the tick's input events and the held keys and mouse motion of the
+ * Input::State resource. Systems reading input run after it.
+ */
+class InputSystem : public gim::ecs::ISystem {
+  private:
+    std::shared_ptr<ComponentManager> componentManager;
+
+  public:
+    using WritesResources =
+        Resources<gim::ecs::components::Input::Queue,
+                  Events<gim::ecs::components::Input::Event>,
+                  gim::ecs::components::Input::State,
+                  gim::ecs::components::EngineState::Component>;
+
+    auto getSignature() -> std::shared_ptr<Signature> override;
+    auto update() -> void override;
+    auto setComponentManager(std::shared_ptr<ComponentManager> componentManager)
+        -> void override;
+    auto getComponentManager() -> std::shared_ptr<ComponentManager> override;
+};
+} // namespace gim::ecs::systems
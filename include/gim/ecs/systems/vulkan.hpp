@@ -11,6 +11,7 @@
 #include <gim/ecs/engine/entity_manager.hpp>
 #include <gim/ecs/engine/system_manager.hpp>
 #include <gim/engine.hpp>
+#include <gim/library/loop.hpp>
 #include <gim/vulkan/instance.hpp>
 #include <gim/vulkan/utils.hpp>
 #include <glm/glm.hpp>
@@ -23,7 +24,6 @@ const int MAX_FRAMES_IN_FLIGHT = 2;
 class VulkanRendererSystem : public gim::ecs::ISystem {
   private:
     // ECS.
-    std::vector<Entity> entities;
     std::shared_ptr<ComponentManager> componentManager;
 
     // Vulkan.
@@ -32,11 +32,17 @@ class VulkanRendererSystem : public gim::ecs::ISystem {
     bool readyToFinishInitialization = false;
     VkDeviceMemory vertexBufferMemory;
 
-    // Engine.
-    std::shared_ptr<gim::ecs::components::Shader::ShaderBuilder> shaderBuilder;
-    std::shared_ptr<gim::ecs::components::Camera::Component> camera;
+    // Engine, looked up from the component manager every update.
+    gim::ecs::components::Shader::ShaderBuilder *shaderBuilder = nullptr;
 
   public:
+    // SDL and the Vulkan queues are only touched from the main thread.
+    static constexpr bool mainThreadOnly = true;
+    static constexpr auto stage = Stage::Render;
+    using Writes = Components<gim::ecs::components::Shader::ShaderBuilder>;
+    using ReadsResources = Resources<gim::library::loop::FrameTime>;
+    using WritesResources = Resources<gim::ecs::components::Camera::Component>;
+
     VulkanRendererSystem();
     VulkanRendererSystem(const VulkanRendererSystem &) = default;
     VulkanRendererSystem(VulkanRendererSystem &&) = delete;
@@ -48,12 +54,7 @@ class VulkanRendererSystem : public gim::ecs::ISystem {
 #pragma mark - ECS
 
     auto getSignature() -> std::shared_ptr<Signature> override;
-    auto processInput(SDL_Event &event) -> void;
-    auto handleMouseMotion(SDL_Event &event) -> void;
     auto update() -> void override;
-    auto insertEntity(Entity entity) -> void override;
-    auto removeEntity(Entity entity) -> void override;
-    auto getEntities() -> std::vector<Entity> const & override;
     auto setComponentManager(std::shared_ptr<ComponentManager> componentManager)
         -> void override;
     auto getComponentManager() -> std::shared_ptr<ComponentManager> override;
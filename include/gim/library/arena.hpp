@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <gim/library/jobs.hpp>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace gim::library::memory {
+/**
+ * @brief How much an arena handed out and how often it had to ask the heap
+ * for more memory.
+ */
+struct ArenaStats {
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;
+    // The most bytes in use between two resets.
+    std::size_t peakBytes = 0;
+    // Blocks allocated from the upstream resource, 0 in a steady state.
+    std::size_t upstreamAllocations = 0;
+
+    auto operator+=(ArenaStats const &other) -> ArenaStats & {
+        allocations += other.allocations;
+        bytes += other.bytes;
+        peakBytes += other.peakBytes;
+        upstreamAllocations += other.upstreamAllocations;
+        return *this;
+    }
+};
+
+/**
+ * @brief A bump allocator for data which only lives until the end of the
+ * frame, usable anywhere a std::pmr::memory_resource is:
+ *
+ * @code
+ * std::pmr::vector<Entity> visible(&gim::library::memory::frameArena());
+ * @endcode
+ *
+ * Allocating bumps a pointer and deallocating does nothing, reset() frees
+ * everything at once. When a frame needs more than the current block the
+ * arena chains another one, and the next reset() replaces the chain with a
+ * single block big enough for the whole frame, so once frames stop growing
+ * the arena never touches the heap again. Not thread safe, every thread
+ * uses its own arena (see FrameArenas).
+ */
+class FrameArena : public std::pmr::memory_resource {
+  public:
+    static constexpr std::size_t DefaultBlockSize = 64 * 1024;
+
+  private:
+    struct Block {
+        std::byte *data;
+        std::size_t size;
+    };
+
+    std::pmr::memory_resource *upstream;
+    std::vector<Block> blocks;
+    std::size_t blockSize;
+    // The free space of the last block.
+    std::byte *cursor = nullptr;
+    std::byte *end = nullptr;
+    std::size_t used = 0;
+    ArenaStats stats;
+
+    auto grow(std::size_t bytes, std::size_t alignment) -> void {
+        auto size = std::max(blockSize, bytes + alignment);
+        auto *data = static_cast<std::byte *>(
+            upstream->allocate(size, alignof(std::max_align_t)));
+        blocks.push_back({data, size});
+        cursor = data;
+        end = data + size;
+        stats.upstreamAllocations++;
+    }
+
+    auto release() -> void {
+        for (auto const &block : blocks) {
+            upstream->deallocate(block.data, block.size,
+                                 alignof(std::max_align_t));
+        }
+        blocks.clear();
+        cursor = end = nullptr;
+    }
+
+  protected:
+    auto do_allocate(std::size_t bytes, std::size_t alignment)
+        -> void * override {
+        auto aligned = [&] {
+            auto address = reinterpret_cast<std::uintptr_t>(cursor);
+            return reinterpret_cast<std::byte *>((address + alignment - 1) &
+                                                 ~(alignment - 1));
+        };
+
+        auto *start = aligned();
+        if (cursor == nullptr || start + bytes > end) {
+            grow(bytes, alignment);
+            start = aligned();
+        }
+
+        cursor = start + bytes;
+        used += bytes;
+        stats.allocations++;
+        stats.bytes += bytes;
+        stats.peakBytes = std::max(stats.peakBytes, used);
+        return start;
+    }
+
+    auto do_deallocate(void * /*pointer*/, std::size_t /*bytes*/,
+                       std::size_t /*alignment*/) -> void override {}
+
+    [[nodiscard]] auto do_is_equal(std::pmr::memory_resource const &other)
+        const noexcept -> bool override {
+        return this == &other;
+    }
+
+  public:
+    explicit FrameArena(
+        std::size_t blockSize = DefaultBlockSize,
+        std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+        : upstream(upstream), blockSize(blockSize) {}
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena(FrameArena &&) = delete;
+    auto operator=(const FrameArena &) -> FrameArena & = delete;
+    auto operator=(FrameArena &&) -> FrameArena & = delete;
+
+    ~FrameArena() override { release(); }
+
+    /**
+     * @brief Free everything allocated since the last reset. Memory from
+     * the arena must not be used afterwards.
+     */
+    auto reset() -> void {
+        if (blocks.size() > 1) {
+            std::size_t total = 0;
+            for (auto const &block : blocks) {
+                total += block.size;
+            }
+            release();
+            blockSize = std::max(blockSize, total);
+        }
+
+        if (blocks.empty()) {
+            cursor = end = nullptr;
+        } else {
+            cursor = blocks.front().data;
+            end = cursor + blocks.front().size;
+        }
+        used = 0;
+    }
+
+    [[nodiscard]] auto getStats() const -> ArenaStats { return stats; }
+
+    auto resetStats() -> void { stats = {}; }
+};
+
+/**
+ * @brief One FrameArena per thread of a job system, threads outside the
+ * pool other than its main thread get one of their own the first time they
+ * ask. Only reset() them while no thread is using its arena, the ECS does at
+ * the end of every frame.
+ */
+class FrameArenas {
+  private:
+    gim::library::jobs::JobSystem *jobs;
+    gim::library::jobs::PerThread<FrameArena> arenas;
+    std::mutex outsideMutex;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<FrameArena>>>
+        outside;
+
+    // Outside threads are rare, a lock and a search are cheap enough.
+    auto outsideArena() -> FrameArena & {
+        auto id = std::this_thread::get_id();
+        std::lock_guard lock(outsideMutex);
+        for (auto &[thread, arena] : outside) {
+            if (thread == id) {
+                return *arena;
+            }
+        }
+        return *outside.emplace_back(id, std::make_unique<FrameArena>())
+                    .second;
+    }
+
+    template <typename Fn> auto each(Fn &&fn) -> void {
+        arenas.each(fn);
+        std::lock_guard lock(outsideMutex);
+        for (auto &[thread, arena] : outside) {
+            fn(*arena);
+        }
+    }
+
+  public:
+    explicit FrameArenas(gim::library::jobs::JobSystem &jobs =
+                             gim::library::jobs::JobSystem::instance())
+        : jobs(&jobs), arenas(jobs) {}
+
+    /**
+     * @brief The arenas of the shared job system.
+     */
+    static auto instance() -> FrameArenas & {
+        static FrameArenas shared;
+        return shared;
+    }
+
+    /**
+     * @brief The arena of the calling thread.
+     */
+    auto local() -> FrameArena & {
+        // The pool's threads and its main thread have index 0 to themselves.
+        if (jobs->threadIndex() != 0 || jobs->isMainThread()) {
+            return arenas.local();
+        }
+        return outsideArena();
+    }
+
+    auto reset() -> void {
+        each([](FrameArena &arena) { arena.reset(); });
+    }
+
+    [[nodiscard]] auto getStats() -> ArenaStats {
+        ArenaStats total;
+        each([&](FrameArena &arena) { total += arena.getStats(); });
+        return total;
+    }
+
+    auto resetStats() -> void {
+        each([](FrameArena &arena) { arena.resetStats(); });
+    }
+};
+
+/**
+ * @brief The calling thread's arena for this frame.
+ */
+inline auto frameArena() -> FrameArena & {
+    return FrameArenas::instance().local();
+}
+} // namespace gim::library::memory
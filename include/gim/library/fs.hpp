@@ -1,7 +1,18 @@
 #pragma once
 
+#include <gim/library/jobs.hpp>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace gim::library::fs {
 std::vector<char> readFile(const std::string &filename);
-}
\ No newline at end of file
+
+/**
+ * @brief Read a file on a background job. The buffer is filled once counter
+ * reaches zero, a failed read is rethrown by JobSystem::wait(counter).
+ */
+auto readFileAsync(const std::string &filename, jobs::Counter &counter,
+                   jobs::JobSystem &jobs = jobs::JobSystem::instance())
+    -> std::shared_ptr<std::vector<char>>;
+} // namespace gim::library::fs
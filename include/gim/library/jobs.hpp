@@ -0,0 +1,714 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gim::library::jobs {
+using Job = std::function<void()>;
+
+// The size of a cache line, used to keep data written by different threads
+// apart.
+constexpr std::size_t CacheLine = 64;
+
+/**
+ * @brief Frame jobs are what the current frame waits on, background jobs
+ * (streaming, asset loads) only run when no frame job is queued and never on
+ * a thread helping while it waits unless the pool has no workers.
+ */
+enum class Priority : std::uint8_t { Frame, Background };
+
+constexpr std::size_t PriorityCount = 2;
+
+/**
+ * @brief A Chase-Lev work stealing deque. The owning thread pushes and pops
+ * at the bottom without locking, any other thread steals from the top.
+ *
+ * The ring grows when full, replaced rings are kept until the deque is
+ * destroyed since a thief may still be reading one.
+ */
+template <typename T> class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Deque items are copied through atomics.");
+
+  private:
+    struct Ring {
+        std::int64_t capacity;
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        explicit Ring(std::int64_t capacity)
+            : capacity(capacity),
+              items(std::make_unique<std::atomic<T>[]>(
+                  static_cast<std::size_t>(capacity))) {}
+
+        auto at(std::int64_t index) -> std::atomic<T> & {
+            return items[static_cast<std::size_t>(index & (capacity - 1))];
+        }
+    };
+
+    alignas(CacheLine) std::atomic<std::int64_t> top{0};
+    alignas(CacheLine) std::atomic<std::int64_t> bottom{0};
+    alignas(CacheLine) std::atomic<Ring *> ring;
+    std::vector<std::unique_ptr<Ring>> rings;
+
+  public:
+    explicit WorkStealingDeque(std::int64_t capacity = 256) {
+        rings.push_back(std::make_unique<Ring>(capacity));
+        ring.store(rings.back().get(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Owner only.
+     */
+    auto push(T item) -> void {
+        auto b = bottom.load(std::memory_order_relaxed);
+        auto t = top.load(std::memory_order_acquire);
+        auto *current = ring.load(std::memory_order_relaxed);
+
+        if (b - t > current->capacity - 1) {
+            rings.push_back(std::make_unique<Ring>(current->capacity * 2));
+            auto *grown = rings.back().get();
+            for (auto i = t; i < b; i++) {
+                grown->at(i).store(current->at(i).load(std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+            }
+            ring.store(grown, std::memory_order_release);
+            current = grown;
+        }
+
+        current->at(b).store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Owner only, takes the most recently pushed item.
+     */
+    auto pop() -> std::optional<T> {
+        auto b = bottom.load(std::memory_order_relaxed) - 1;
+        auto *current = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        auto item = current->at(b).load(std::memory_order_relaxed);
+        if (t == b) {
+            // The last item, race the thieves for it.
+            bool won = top.compare_exchange_strong(t, t + 1,
+                                                   std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            if (!won) {
+                return std::nullopt;
+            }
+        }
+        return item;
+    }
+
+    /**
+     * @brief Any thread, takes the oldest item. Also fails when losing a
+     * race with another thread.
+     */
+    auto steal() -> std::optional<T> {
+        auto t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b) {
+            return std::nullopt;
+        }
+
+        auto item = ring.load(std::memory_order_acquire)
+                        ->at(t)
+                        .load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+        return item;
+    }
+
+    [[nodiscard]] auto empty() const -> bool {
+        return bottom.load(std::memory_order_relaxed) <=
+               top.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Counts unfinished jobs, to wait on them or to start jobs once they
+ * are done. The first exception thrown by a counted job is kept and rethrown
+ * by JobSystem::wait(). A counter has to outlive its jobs, and can be reused
+ * once it reached zero.
+ */
+class Counter {
+  private:
+    std::atomic<std::size_t> count{0};
+    // Set by the last job once it is done with the counter, after count
+    // reached zero, since the owner may destroy the counter right after.
+    std::atomic<bool> idle{true};
+    std::mutex mutex;
+    std::vector<Job> continuations;
+    std::exception_ptr error;
+
+  public:
+    Counter() = default;
+    Counter(const Counter &) = delete;
+    Counter(Counter &&) = delete;
+    auto operator=(const Counter &) -> Counter & = delete;
+    auto operator=(Counter &&) -> Counter & = delete;
+    ~Counter() = default;
+
+    [[nodiscard]] auto done() const -> bool {
+        return idle.load(std::memory_order_acquire);
+    }
+
+    auto add(std::size_t jobs = 1) -> void {
+        count.fetch_add(jobs, std::memory_order_relaxed);
+        idle.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Mark one job as finished, running the continuations when it was
+     * the last. Must be the last use of the counter by that job.
+     */
+    auto finish() -> void {
+        if (count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        std::vector<Job> ready;
+        {
+            std::lock_guard lock(mutex);
+            ready.swap(continuations);
+        }
+        // The last use of the counter, the continuations are ours now.
+        idle.store(true, std::memory_order_release);
+        for (auto &continuation : ready) {
+            continuation();
+        }
+    }
+
+    /**
+     * @brief Call fn once the counter reaches zero, right away if it already
+     * has.
+     */
+    auto then(Job fn) -> void {
+        {
+            std::lock_guard lock(mutex);
+            // Not done(), which only turns true once finish() took the
+            // continuations and would miss this one.
+            if (count.load(std::memory_order_acquire) != 0) {
+                continuations.push_back(std::move(fn));
+                return;
+            }
+        }
+        fn();
+    }
+
+    auto fail(std::exception_ptr exception) -> void {
+        std::lock_guard lock(mutex);
+        if (!error) {
+            error = std::move(exception);
+        }
+    }
+
+    /**
+     * @brief Rethrow and forget the first exception of a counted job.
+     */
+    auto rethrow() -> void {
+        std::exception_ptr failed;
+        {
+            std::lock_guard lock(mutex);
+            failed = std::exchange(error, nullptr);
+        }
+        if (failed) {
+            std::rethrow_exception(failed);
+        }
+    }
+};
+
+/**
+ * @brief A pool of worker threads sharing work by stealing, shared by the
+ * whole engine (the ECS, terrain generation, asset loading).
+ *
+ * Every worker owns a Chase-Lev deque per priority. Jobs submitted from a
+ * worker go to the bottom of its own deque and are popped LIFO (cache warm),
+ * idle workers steal from the top of other deques. Jobs submitted from other
+ * threads go to a shared injection queue. Frame jobs always run before
+ * background jobs.
+ *
+ * The thread which created the pool is its main thread, submitMain() queues
+ * jobs only it runs (SDL and Vulkan calls), whenever it helps or calls
+ * runMainThreadJobs(). Threads waiting on jobs should help with helpUntil()
+ * or wait() rather than block so a pool with zero workers still makes
+ * progress on the calling thread.
+ */
+class JobSystem {
+  private:
+    struct Task {
+        Job job;
+        Counter *counter;
+    };
+
+    struct alignas(CacheLine) Worker {
+        std::array<WorkStealingDeque<Task *>, PriorityCount> deques;
+    };
+
+    // A FIFO which keeps its memory, unlike a std::deque which allocates
+    // and frees blocks as tasks pass through.
+    struct Injected {
+        std::mutex mutex;
+        std::vector<Task *> tasks;
+        // The next task to take.
+        std::size_t front = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::array<Injected, PriorityCount> injected;
+    Injected mainLane;
+    std::thread::id mainThread = std::this_thread::get_id();
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> queued{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable sleeping;
+    // Tasks which ran, reused so submitting only allocates while more jobs
+    // are in flight than ever before.
+    std::mutex poolMutex;
+    std::vector<Task *> pool;
+
+    // The index of the current thread in the pool, 0 outside of it.
+    static auto localIndex() -> std::size_t & {
+        thread_local std::size_t index = 0;
+        return index;
+    }
+
+    static auto localOwner() -> JobSystem *& {
+        thread_local JobSystem *owner = nullptr;
+        return owner;
+    }
+
+    auto ownWorker() const -> Worker * {
+        return localOwner() == this ? workers[localIndex() - 1].get()
+                                    : nullptr;
+    }
+
+    static auto take(Injected &queue) -> Task * {
+        std::lock_guard lock(queue.mutex);
+        if (queue.front == queue.tasks.size()) {
+            return nullptr;
+        }
+        auto *task = queue.tasks[queue.front++];
+        if (queue.front == queue.tasks.size()) {
+            queue.tasks.clear();
+            queue.front = 0;
+        }
+        return task;
+    }
+
+    auto makeTask(Job job, Counter *counter) -> Task * {
+        {
+            std::lock_guard lock(poolMutex);
+            if (!pool.empty()) {
+                auto *task = pool.back();
+                pool.pop_back();
+                task->job = std::move(job);
+                task->counter = counter;
+                return task;
+            }
+        }
+        return new Task{std::move(job), counter};
+    }
+
+    // Drops what the job captured right away, not when the task is reused.
+    auto recycle(Task *task) -> void {
+        task->job = nullptr;
+        std::lock_guard lock(poolMutex);
+        pool.push_back(task);
+    }
+
+    auto find(Priority priority) -> Task * {
+        auto lane = static_cast<std::size_t>(priority);
+        auto *own = ownWorker();
+
+        Task *task = nullptr;
+        if (own != nullptr) {
+            task = own->deques[lane].pop().value_or(nullptr);
+        }
+        if (task == nullptr) {
+            task = take(injected[lane]);
+        }
+
+        auto start = own != nullptr ? localIndex() : 0;
+        for (std::size_t i = 0; task == nullptr && i < workers.size(); i++) {
+            auto &victim = *workers[(start + i) % workers.size()];
+            if (&victim != own) {
+                task = victim.deques[lane].steal().value_or(nullptr);
+            }
+        }
+
+        if (task != nullptr) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    auto find() -> Task * {
+        if (auto *task = find(Priority::Frame)) {
+            return task;
+        }
+        // Helping threads stay responsive, long running background jobs are
+        // left to the workers.
+        if (localOwner() == this || workers.empty()) {
+            return find(Priority::Background);
+        }
+        return nullptr;
+    }
+
+    // A job without a counter which throws takes the program down, like an
+    // exception escaping a thread does.
+    auto execute(Task *task) -> void {
+        auto *counter = task->counter;
+        try {
+            task->job();
+        } catch (...) {
+            if (counter == nullptr) {
+                recycle(task);
+                throw;
+            }
+            counter->fail(std::current_exception());
+        }
+        recycle(task);
+
+        if (counter != nullptr) {
+            counter->finish();
+        }
+    }
+
+    auto push(Task *task, Priority priority) -> void {
+        auto lane = static_cast<std::size_t>(priority);
+
+        if (auto *own = ownWorker()) {
+            own->deques[lane].push(task);
+        } else {
+            std::lock_guard lock(injected[lane].mutex);
+            injected[lane].tasks.push_back(task);
+        }
+
+        {
+            std::lock_guard lock(sleepMutex);
+            queued.fetch_add(1, std::memory_order_release);
+        }
+        sleeping.notify_one();
+    }
+
+    auto work(std::size_t index) -> void {
+        localOwner() = this;
+        localIndex() = index;
+
+        while (!stopping.load(std::memory_order_acquire)) {
+            if (auto *task = find()) {
+                execute(task);
+                continue;
+            }
+
+            std::unique_lock lock(sleepMutex);
+            sleeping.wait(lock, [&] {
+                return stopping.load(std::memory_order_acquire) ||
+                       queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+  public:
+    /**
+     * @brief One worker per hardware thread, minus the main thread which
+     * helps while it waits.
+     */
+    static auto defaultWorkerCount() -> std::size_t {
+        auto hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 0;
+    }
+
+    explicit JobSystem(std::size_t workerCount = defaultWorkerCount()) {
+        for (std::size_t i = 0; i < workerCount; i++) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+
+        for (std::size_t i = 0; i < workerCount; i++) {
+            threads.emplace_back([this, i] { work(i + 1); });
+        }
+    }
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem(JobSystem &&) = delete;
+    auto operator=(const JobSystem &) -> JobSystem & = delete;
+    auto operator=(JobSystem &&) -> JobSystem & = delete;
+
+    ~JobSystem() {
+        {
+            std::lock_guard lock(sleepMutex);
+            stopping.store(true, std::memory_order_release);
+        }
+        sleeping.notify_all();
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        // Jobs nobody ran, their counters never reach zero.
+        for (auto &worker : workers) {
+            for (auto &deque : worker->deques) {
+                while (auto task = deque.steal()) {
+                    delete *task;
+                }
+            }
+        }
+        for (auto *queue : {&injected[0], &injected[1], &mainLane}) {
+            for (auto i = queue->front; i < queue->tasks.size(); i++) {
+                delete queue->tasks[i];
+            }
+        }
+        for (auto *task : pool) {
+            delete task;
+        }
+    }
+
+    /**
+     * @brief The pool shared by the whole engine, its main thread is the
+     * thread which first asks for it.
+     */
+    static auto instance() -> JobSystem & {
+        static JobSystem shared;
+        return shared;
+    }
+
+    /**
+     * @brief The number of threads which run jobs, counting the threads that
+     * help while waiting as one.
+     */
+    [[nodiscard]] auto concurrency() const -> std::size_t {
+        return threads.size() + 1;
+    }
+
+    /**
+     * @brief A stable index in [0, concurrency()) for the calling thread,
+     * 0 for threads outside the pool.
+     */
+    [[nodiscard]] auto threadIndex() const -> std::size_t {
+        return localOwner() == this ? localIndex() : 0;
+    }
+
+    [[nodiscard]] auto isMainThread() const -> bool {
+        return std::this_thread::get_id() == mainThread;
+    }
+
+    auto submit(Job job, Priority priority = Priority::Frame) -> void {
+        push(makeTask(std::move(job), nullptr), priority);
+    }
+
+    /**
+     * @brief Submit a job counted by counter.
+     */
+    auto submit(Job job, Counter &counter,
+                Priority priority = Priority::Frame) -> void {
+        counter.add();
+        push(makeTask(std::move(job), &counter), priority);
+    }
+
+    /**
+     * @brief Submit a job once every job counted by dependency finished. The
+     * job is counted by counter from now on, if there is one.
+     */
+    auto submitAfter(Counter &dependency, Job job, Counter *counter = nullptr,
+                     Priority priority = Priority::Frame) -> void {
+        if (counter != nullptr) {
+            counter->add();
+        }
+        auto *task = makeTask(std::move(job), counter);
+        dependency.then([this, task, priority] { push(task, priority); });
+    }
+
+    /**
+     * @brief Submit a job only the main thread runs, for APIs like SDL and
+     * Vulkan's presentation which have to be called from it.
+     */
+    auto submitMain(Job job, Counter *counter = nullptr) -> void {
+        if (counter != nullptr) {
+            counter->add();
+        }
+        auto *task = makeTask(std::move(job), counter);
+        std::lock_guard lock(mainLane.mutex);
+        mainLane.tasks.push_back(task);
+    }
+
+    /**
+     * @brief Run every job queued for the main thread, call once a frame
+     * from it. Does nothing on other threads.
+     *
+     * @return bool Whether a job was run.
+     */
+    auto runMainThreadJobs() -> bool {
+        if (!isMainThread()) {
+            return false;
+        }
+
+        bool ran = false;
+        while (auto *task = take(mainLane)) {
+            execute(task);
+            ran = true;
+        }
+        return ran;
+    }
+
+    /**
+     * @brief Run a single queued job on the calling thread if there is one,
+     * main thread jobs first when called from the main thread.
+     *
+     * @return bool Whether a job was run.
+     */
+    auto runOne() -> bool {
+        if (isMainThread()) {
+            if (auto *task = take(mainLane)) {
+                execute(task);
+                return true;
+            }
+        }
+
+        if (auto *task = find()) {
+            execute(task);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Run queued jobs on the calling thread until done() is true.
+     */
+    template <typename Done> auto helpUntil(Done &&done) -> void {
+        while (!done()) {
+            if (!runOne()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * @brief Help until every job counted by counter finished, then rethrow
+     * the first exception one of them threw.
+     */
+    auto wait(Counter &counter) -> void {
+        helpUntil([&] { return counter.done(); });
+        counter.rethrow();
+    }
+
+    /**
+     * @brief Call fn(begin, end) over [0, count) split into ranges of grain
+     * items, in parallel, returning once every range has been processed.
+     * The calling thread processes ranges too. The first exception thrown by
+     * fn is rethrown once every range has finished.
+     */
+    template <typename Fn>
+    auto parallelFor(std::size_t count, std::size_t grain, Fn &&fn,
+                     Priority priority = Priority::Frame) -> void {
+        if (count == 0) {
+            return;
+        }
+
+        grain = std::max<std::size_t>(grain, 1);
+        auto ranges = (count + grain - 1) / grain;
+
+        if (ranges == 1 || concurrency() == 1) {
+            fn(std::size_t{0}, count);
+            return;
+        }
+
+        auto process = [&](std::size_t range) {
+            auto begin = range * grain;
+            fn(begin, std::min(begin + grain, count));
+        };
+
+        Counter counter;
+        for (std::size_t range = 1; range < ranges; range++) {
+            submit([&process, range] { process(range); }, counter, priority);
+        }
+        try {
+            process(0);
+        } catch (...) {
+            counter.fail(std::current_exception());
+        }
+
+        wait(counter);
+    }
+};
+
+/**
+ * @brief One value per thread of a job system, each on its own cache line,
+ * for scratch memory and partial results in parallel loops without locks or
+ * false sharing.
+ *
+ * Threads outside the pool share the slot of the main thread, so only one
+ * of them should use a PerThread at a time.
+ */
+template <typename T> class PerThread {
+  private:
+    struct alignas(CacheLine) Slot {
+        T value;
+    };
+
+    JobSystem *jobs;
+    std::pmr::vector<Slot> slots;
+
+  public:
+    explicit PerThread(JobSystem &jobs = JobSystem::instance())
+        : jobs(&jobs), slots(jobs.concurrency()) {}
+
+    /**
+     * @brief Every thread's value starts as init, short lived ones used
+     * within a frame can take their slots from the frame arena.
+     */
+    PerThread(
+        JobSystem &jobs, T init,
+        std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+        : jobs(&jobs), slots(jobs.concurrency(), Slot{init}, memory) {}
+
+    /**
+     * @brief The value belonging to the calling thread.
+     */
+    auto local() -> T & { return slots[jobs->threadIndex()].value; }
+
+    /**
+     * @brief The value belonging to the thread with the given threadIndex().
+     */
+    auto operator[](std::size_t thread) -> T & { return slots[thread].value; }
+
+    [[nodiscard]] auto size() const -> std::size_t { return slots.size(); }
+
+    /**
+     * @brief Call fn with every thread's value.
+     */
+    template <typename Fn> auto each(Fn &&fn) -> void {
+        for (auto &slot : slots) {
+            fn(slot.value);
+        }
+    }
+};
+} // namespace gim::library::jobs
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+namespace gim::library::loop {
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+struct Settings {
+    // Simulation steps per second.
+    double simulationRate = 60.0;
+    // Frames per second, 0 renders as fast as presenting allows.
+    double maxFrameRate = 0.0;
+    // A slow frame runs at most this many steps to catch up, the rest of the
+    // backlog is dropped so the simulation slows down instead of spiralling.
+    std::size_t maxStepsPerFrame = 8;
+};
+
+/**
+ * @brief How far the loop is, handed to the simulation and the renderer.
+ */
+struct FrameTime {
+    // The fixed duration of a simulation step, in seconds.
+    double delta = 0.0;
+    // How far the frame is between the last two simulation steps, in
+    // [0, 1), for interpolating what is drawn.
+    double alpha = 0.0;
+    std::uint64_t steps = 0;
+    std::uint64_t frames = 0;
+};
+
+/**
+ * @brief A fixed timestep loop: the simulation advances in steps of exactly
+ * 1 / simulationRate seconds, however long frames take, and every frame is
+ * rendered once with how far it is between the last two steps.
+ *
+ * @code
+ * FixedTimestep loop({.simulationRate = 60.0, .maxFrameRate = 144.0});
+ * while (running) {
+ *     loop.frame([&](FrameTime const &time) { simulate(time.delta); },
+ *                [&](FrameTime const &time) { render(time.alpha); });
+ * }
+ * @endcode
+ *
+ * With a frame rate cap the loop sleeps until the next frame is due instead
+ * of spinning, only yielding for the last millisecond where sleeping would
+ * overshoot.
+ */
+class FixedTimestep {
+  private:
+    // Sleeping is only accurate to about this much.
+    static constexpr auto SleepSlack = std::chrono::milliseconds(1);
+    // How often idle() is called while waiting for the next frame.
+    static constexpr auto IdleInterval = std::chrono::milliseconds(1);
+
+    Settings settings;
+    Clock::duration step;
+    Clock::duration frameDuration{0};
+    Clock::duration accumulator{0};
+    Clock::time_point previous = Clock::now();
+    Clock::time_point nextFrame = previous;
+    FrameTime time;
+
+    template <typename Idle> auto pace(Idle &&idle) -> void {
+        if (frameDuration == Clock::duration::zero()) {
+            return;
+        }
+
+        nextFrame += frameDuration;
+        auto now = Clock::now();
+        // Too far behind to catch up, start pacing from now.
+        if (nextFrame < now - frameDuration) {
+            nextFrame = now;
+            return;
+        }
+
+        while (nextFrame - now > SleepSlack) {
+            idle();
+            std::this_thread::sleep_until(
+                std::min(now + IdleInterval, nextFrame - SleepSlack));
+            now = Clock::now();
+        }
+        while (Clock::now() < nextFrame) {
+            std::this_thread::yield();
+        }
+    }
+
+  public:
+    explicit FixedTimestep(Settings settings = {})
+        : settings(settings),
+          step(std::chrono::duration_cast<Clock::duration>(
+              Seconds(1.0 / settings.simulationRate))) {
+        if (settings.maxFrameRate > 0.0) {
+            frameDuration = std::chrono::duration_cast<Clock::duration>(
+                Seconds(1.0 / settings.maxFrameRate));
+        }
+        time.delta = Seconds(step).count();
+    }
+
+    /**
+     * @brief Run every simulation step due since the last frame, then render
+     * once and wait for the next frame if the frame rate is capped, calling
+     * idle() about every millisecond while waiting (to sample input).
+     */
+    template <typename Simulate, typename Render, typename Idle>
+    auto frame(Simulate &&simulate, Render &&render, Idle &&idle) -> void {
+        auto now = Clock::now();
+        accumulator += now - previous;
+        previous = now;
+
+        std::size_t steps = 0;
+        while (accumulator >= step && steps < settings.maxStepsPerFrame) {
+            simulate(std::as_const(time));
+            accumulator -= step;
+            time.steps++;
+            steps++;
+        }
+        if (accumulator >= step) {
+            accumulator %= step;
+        }
+
+        time.alpha = Seconds(accumulator).count() / time.delta;
+        render(std::as_const(time));
+        time.frames++;
+
+        pace(idle);
+    }
+
+    template <typename Simulate, typename Render>
+    auto frame(Simulate &&simulate, Render &&render) -> void {
+        frame(std::forward<Simulate>(simulate), std::forward<Render>(render),
+              [] {});
+    }
+
+    [[nodiscard]] auto getTime() const -> FrameTime const & { return time; }
+
+    [[nodiscard]] auto getSettings() const -> Settings const & {
+        return settings;
+    }
+};
+} // namespace gim::library::loop
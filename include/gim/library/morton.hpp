@@ -0,0 +1,182 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// pdep and pext are compiled in through target attributes and picked at
+// runtime, unless the whole build already targets BMI2.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define GIM_MORTON_BMI2
+#endif
+
+/**
+ * Morton (Z-order) codes interleave the bits of x, y and z, x lowest, so
+ * sorting by them keeps every octant of every size contiguous. The octree
+ * builds its levels from them, chunks store their voxels in their order and
+ * voxel.comp indexes its voxel buffer by them.
+ *
+ * On CPUs with BMI2 encoding and decoding are a pdep or pext per axis,
+ * otherwise they go through tables a byte at a time. Which one is checked
+ * once at startup, building with -mbmi2 (or -march=native on a CPU which
+ * has it) skips the check and inlines pdep and pext. In constant
+ * expressions they shift and mask.
+ */
+namespace gim::library::morton {
+// Bits per axis which fit in a 64-bit code.
+inline constexpr unsigned AxisBits = 21;
+
+// The bits of a code which hold x, y and z.
+inline constexpr std::uint64_t XMask = 0x1249249249249249ULL;
+inline constexpr std::uint64_t YMask = XMask << 1U;
+inline constexpr std::uint64_t ZMask = XMask << 2U;
+
+/**
+ * @brief Spread the low 21 bits of value out to every third bit.
+ */
+constexpr auto spread(std::uint32_t value) -> std::uint64_t {
+    std::uint64_t bits = value & 0x1FFFFFU;
+    bits = (bits | bits << 32U) & 0x1F00000000FFFFULL;
+    bits = (bits | bits << 16U) & 0x1F0000FF0000FFULL;
+    bits = (bits | bits << 8U) & 0x100F00F00F00F00FULL;
+    bits = (bits | bits << 4U) & 0x10C30C30C30C30C3ULL;
+    bits = (bits | bits << 2U) & XMask;
+    return bits;
+}
+
+/**
+ * @brief Gather every third bit of bits back together, undoing spread().
+ */
+constexpr auto compact(std::uint64_t bits) -> std::uint32_t {
+    bits &= XMask;
+    bits = (bits | bits >> 2U) & 0x10C30C30C30C30C3ULL;
+    bits = (bits | bits >> 4U) & 0x100F00F00F00F00FULL;
+    bits = (bits | bits >> 8U) & 0x1F0000FF0000FFULL;
+    bits = (bits | bits >> 16U) & 0x1F00000000FFFFULL;
+    bits = (bits | bits >> 32U) & 0x1FFFFFULL;
+    return static_cast<std::uint32_t>(bits);
+}
+
+namespace detail {
+// Every byte spread out to every third bit.
+inline constexpr auto SpreadTable = [] {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < table.size(); i++) {
+        table[i] = static_cast<std::uint32_t>(spread(i));
+    }
+    return table;
+}();
+
+// The x, y and z of every 9 bits of a code, 3 bits each.
+inline constexpr auto CompactTable = [] {
+    std::array<std::uint16_t, 512> table{};
+    for (std::uint32_t i = 0; i < table.size(); i++) {
+        table[i] = static_cast<std::uint16_t>(
+            compact(i) | compact(i >> 1U) << 3U | compact(i >> 2U) << 6U);
+    }
+    return table;
+}();
+
+inline auto encodeTable(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+    -> std::uint64_t {
+    std::uint64_t code = 0;
+    for (unsigned shift = 0; shift < AxisBits; shift += 8) {
+        auto bits = std::uint64_t{SpreadTable[(x >> shift) & 0xFFU]} |
+                    std::uint64_t{SpreadTable[(y >> shift) & 0xFFU]} << 1U |
+                    std::uint64_t{SpreadTable[(z >> shift) & 0xFFU]} << 2U;
+        code |= bits << (3 * shift);
+    }
+    return code & (XMask | YMask | ZMask);
+}
+
+inline auto decodeTable(std::uint64_t code) -> std::array<std::uint32_t, 3> {
+    std::array<std::uint32_t, 3> position{};
+    for (unsigned shift = 0; shift < AxisBits; shift += 3) {
+        auto bits = CompactTable[(code >> (3 * shift)) & 0x1FFU];
+        position[0] |= static_cast<std::uint32_t>(bits & 7U) << shift;
+        position[1] |= static_cast<std::uint32_t>((bits >> 3U) & 7U) << shift;
+        position[2] |= static_cast<std::uint32_t>(bits >> 6U) << shift;
+    }
+    return position;
+}
+
+#if defined(GIM_MORTON_BMI2)
+// Read before it is initialised (from another static initialiser) this is
+// false, which only means the tables get used.
+inline bool const HasBmi2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2") != 0;
+}();
+
+[[gnu::target("bmi2")]] inline auto
+encodeBmi2(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+    -> std::uint64_t {
+    return _pdep_u64(x, XMask) | _pdep_u64(y, YMask) | _pdep_u64(z, ZMask);
+}
+
+[[gnu::target("bmi2")]] inline auto decodeBmi2(std::uint64_t code)
+    -> std::array<std::uint32_t, 3> {
+    return {static_cast<std::uint32_t>(_pext_u64(code, XMask)),
+            static_cast<std::uint32_t>(_pext_u64(code, YMask)),
+            static_cast<std::uint32_t>(_pext_u64(code, ZMask))};
+}
+#endif
+} // namespace detail
+
+/**
+ * @brief Whether encode() and decode() use pdep and pext.
+ */
+inline auto usesBmi2() -> bool {
+#if defined(__BMI2__)
+    return true;
+#elif defined(GIM_MORTON_BMI2)
+    return detail::HasBmi2;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief The Z-order code of a voxel, the low 21 bits of every axis.
+ */
+constexpr auto encode(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+    -> std::uint64_t {
+    if consteval {
+        return spread(x) | spread(y) << 1U | spread(z) << 2U;
+    } else {
+#if defined(__BMI2__)
+        return detail::encodeBmi2(x, y, z);
+#else
+#if defined(GIM_MORTON_BMI2)
+        if (detail::HasBmi2) {
+            return detail::encodeBmi2(x, y, z);
+        }
+#endif
+        return detail::encodeTable(x, y, z);
+#endif
+    }
+}
+
+constexpr auto decode(std::uint64_t code) -> std::array<std::uint32_t, 3> {
+    if consteval {
+        return {compact(code), compact(code >> 1U), compact(code >> 2U)};
+    } else {
+#if defined(__BMI2__)
+        return detail::decodeBmi2(code);
+#else
+#if defined(GIM_MORTON_BMI2)
+        if (detail::HasBmi2) {
+            return detail::decodeBmi2(code);
+        }
+#endif
+        return detail::decodeTable(code);
+#endif
+    }
+}
+
+static_assert(encode(1, 0, 0) == 1 && encode(0, 1, 0) == 2 &&
+              encode(0, 0, 1) == 4 && encode(3, 3, 3) == 63);
+static_assert(decode(encode(0x1FFFFF, 12345, 7)) ==
+              std::array<std::uint32_t, 3>{0x1FFFFF, 12345, 7});
+} // namespace gim::library::morton
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fmt/core.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+namespace gim::library::profiler {
+/**
+ * @brief A timed scope. name must outlive the profiler, string literals and
+ * intern()ed strings do.
+ */
+struct ZoneEvent {
+    const char *name = nullptr;
+    std::uint64_t begin = 0;
+    std::uint64_t end = 0;
+    std::uint32_t thread = 0;
+};
+
+/**
+ * @brief The recent durations of one zone name.
+ */
+struct ZoneSummary {
+    std::string_view name;
+    std::size_t count = 0;
+    double minMicroseconds = 0;
+    double avgMicroseconds = 0;
+    double p99Microseconds = 0;
+};
+
+/**
+ * @brief Collects scoped zones from every thread.
+ *
+ * Every thread writes finished zones into its own fixed size ring buffer
+ * without locking, collect() drains the rings from one thread (once a frame)
+ * into the trace and the rolling per-zone statistics. Zones recorded while a
+ * ring is full are dropped and counted. Use the GIM_PROFILE_* macros rather
+ * than this class directly so instrumentation compiles out when GIM_PROFILE
+ * isn't defined.
+ */
+class Profiler {
+  public:
+    static constexpr std::size_t RingSize = 1 << 14;
+    // How many durations of every zone the summary is computed over.
+    static constexpr std::size_t Window = 240;
+    // The trace keeps this many of the most recent zones.
+    static constexpr std::size_t TraceLimit = 1 << 20;
+
+  private:
+    struct Ring {
+        std::uint32_t thread = 0;
+        std::array<ZoneEvent, RingSize> events;
+        alignas(64) std::atomic<std::size_t> head{0};
+        alignas(64) std::atomic<std::size_t> tail{0};
+    };
+
+    struct Durations {
+        std::vector<double> samples;
+        std::size_t next = 0;
+        std::size_t count = 0;
+    };
+
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::deque<std::string> interned;
+    std::mutex collectMutex;
+    std::deque<ZoneEvent> trace;
+    std::unordered_map<std::string_view, Durations> durations;
+    std::atomic<std::size_t> dropped{0};
+    std::uint64_t epoch = clock();
+
+    // Nanoseconds from the profiler's creation to a zone's begin, zones
+    // which began before it was created start at 0.
+    [[nodiscard]] auto since(std::uint64_t begin) const -> std::uint64_t {
+        return begin > epoch ? begin - epoch : 0;
+    }
+
+    auto localRing() -> Ring & {
+        thread_local Ring *ring = nullptr;
+        thread_local Profiler *owner = nullptr;
+
+        if (owner != this) {
+            std::lock_guard lock(ringsMutex);
+            rings.push_back(std::make_unique<Ring>());
+            rings.back()->thread = static_cast<std::uint32_t>(rings.size() - 1);
+            ring = rings.back().get();
+            owner = this;
+        }
+
+        return *ring;
+    }
+
+    auto summarise(std::string_view name, Durations const &zone) const
+        -> ZoneSummary {
+        auto sorted = zone.samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        double total = 0;
+        for (auto sample : sorted) {
+            total += sample;
+        }
+
+        auto p99 = sorted.size() * 99 / 100;
+        return {.name = name,
+                .count = zone.count,
+                .minMicroseconds = sorted.front(),
+                .avgMicroseconds = total / static_cast<double>(sorted.size()),
+                .p99Microseconds = sorted[std::min(p99, sorted.size() - 1)]};
+    }
+
+  public:
+    static auto instance() -> Profiler & {
+        static Profiler shared;
+        return shared;
+    }
+
+    /**
+     * @brief Nanoseconds on a monotonic clock.
+     */
+    static auto clock() -> std::uint64_t {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    /**
+     * @brief Keep a copy of a runtime string alive for use as a zone name.
+     */
+    auto intern(std::string name) -> const char * {
+        std::lock_guard lock(ringsMutex);
+        return interned.emplace_back(std::move(name)).c_str();
+    }
+
+    /**
+     * @brief Record a finished zone on the calling thread's ring.
+     */
+    auto record(const char *name, std::uint64_t begin, std::uint64_t end)
+        -> void {
+        auto &ring = localRing();
+        auto head = ring.head.load(std::memory_order_relaxed);
+
+        if (head - ring.tail.load(std::memory_order_acquire) == RingSize) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        ring.events[head % RingSize] = {
+            .name = name, .begin = begin, .end = end, .thread = ring.thread};
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Move every recorded zone into the trace and the per-zone
+     * statistics.
+     */
+    auto collect() -> void {
+        std::lock_guard lock(collectMutex);
+        std::vector<Ring *> current;
+        {
+            std::lock_guard ringsLock(ringsMutex);
+            for (auto &ring : rings) {
+                current.push_back(ring.get());
+            }
+        }
+
+        for (auto *ring : current) {
+            auto tail = ring->tail.load(std::memory_order_relaxed);
+            auto head = ring->head.load(std::memory_order_acquire);
+
+            for (; tail != head; tail++) {
+                auto const &event = ring->events[tail % RingSize];
+                auto &zone = durations[event.name];
+
+                if (zone.samples.size() < Window) {
+                    zone.samples.push_back(0);
+                }
+                zone.samples[zone.next] =
+                    static_cast<double>(event.end - event.begin) / 1000.0;
+                zone.next = (zone.next + 1) % Window;
+                zone.count++;
+
+                trace.push_back(event);
+                if (trace.size() > TraceLimit) {
+                    trace.pop_front();
+                }
+            }
+
+            ring->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief min/avg/p99 of the last Window durations of every zone, in
+     * microseconds, as of the last collect().
+     */
+    auto summary() -> std::vector<ZoneSummary> {
+        std::lock_guard lock(collectMutex);
+        std::vector<ZoneSummary> zones;
+
+        for (auto const &[name, zone] : durations) {
+            zones.push_back(summarise(name, zone));
+        }
+
+        std::sort(zones.begin(), zones.end(), [](auto const &a, auto const &b) {
+            return a.avgMicroseconds > b.avgMicroseconds;
+        });
+        return zones;
+    }
+
+    /**
+     * @brief The number of zones dropped because a ring was full.
+     */
+    [[nodiscard]] auto droppedZones() const -> std::size_t {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Write the collected zones in the Chrome trace event format, to
+     * load in chrome://tracing or Perfetto.
+     *
+     * @return bool Whether the file could be written.
+     */
+    auto writeChromeTrace(const std::string &path) -> bool {
+        std::lock_guard lock(collectMutex);
+        auto *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+
+        fmt::print(file, "{{\"traceEvents\":[");
+        bool first = true;
+        std::string name;
+        for (auto const &event : trace) {
+            name.clear();
+            for (auto const *c = event.name; *c != '\0'; c++) {
+                if (*c == '"' || *c == '\\') {
+                    name += '\\';
+                }
+                name += *c;
+            }
+
+            fmt::print(file,
+                       "{}\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,"
+                       "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                       first ? "" : ",", name, event.thread,
+                       static_cast<double>(since(event.begin)) / 1000.0,
+                       static_cast<double>(event.end - event.begin) / 1000.0);
+            first = false;
+        }
+        fmt::print(file, "\n]}}\n");
+
+        return std::fclose(file) == 0;
+    }
+
+    /**
+     * @brief Forget every collected zone.
+     */
+    auto clear() -> void {
+        std::lock_guard lock(collectMutex);
+        trace.clear();
+        durations.clear();
+    }
+};
+
+/**
+ * @brief Records the time between its construction and destruction.
+ */
+class Zone {
+  private:
+    const char *name;
+    std::uint64_t begin = 0;
+
+  public:
+    // The profiler is created before taking the time, so the first zone
+    // doesn't begin before the trace's epoch.
+    explicit Zone(const char *name) : name(name) {
+        Profiler::instance();
+        begin = Profiler::clock();
+    }
+
+    Zone(const Zone &) = delete;
+    Zone(Zone &&) = delete;
+    auto operator=(const Zone &) -> Zone & = delete;
+    auto operator=(Zone &&) -> Zone & = delete;
+
+    ~Zone() { Profiler::instance().record(name, begin, Profiler::clock()); }
+};
+
+/**
+ * @brief A readable, interned name for a type to use as a zone name.
+ */
+template <typename T> auto typeName() -> const char * {
+    static const char *name = [] {
+        std::string readable = typeid(T).name();
+#if defined(__GNUC__) || defined(__clang__)
+        int status = 0;
+        char *demangled =
+            abi::__cxa_demangle(readable.c_str(), nullptr, nullptr, &status);
+        if (status == 0 && demangled != nullptr) {
+            readable = demangled;
+        }
+        std::free(demangled);
+#endif
+        return Profiler::instance().intern(std::move(readable));
+    }();
+    return name;
+}
+} // namespace gim::library::profiler
+
+#define GIM_PROFILE_CAT_(a, b) a##b
+#define GIM_PROFILE_CAT(a, b) GIM_PROFILE_CAT_(a, b)
+
+#ifdef GIM_PROFILE
+// Time the rest of the enclosing scope as a zone called name.
+#define GIM_PROFILE_ZONE(name)                                                 \
+    const gim::library::profiler::Zone GIM_PROFILE_CAT(gimProfileZone,        \
+                                                       __LINE__)(name)
+// Drain every thread's zones, call once a frame.
+#define GIM_PROFILE_COLLECT()                                                  \
+    gim::library::profiler::Profiler::instance().collect()
+#else
+#define GIM_PROFILE_ZONE(name) static_cast<void>(0)
+#define GIM_PROFILE_COLLECT() static_cast<void>(0)
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <gim/library/jobs.hpp>
+#include <optional>
+#include <utility>
+
+namespace gim::library::queue {
+/**
+ * @brief A bounded lock-free queue any number of threads push into and one
+ * thread pops from.
+ *
+ * Every slot carries a sequence number telling producers whether it is free
+ * for their turn and the consumer whether it was filled (Vyukov's bounded
+ * queue), so pushing is one compare and swap and popping takes no atomic
+ * read-modify-write at all. A full ring drops new items rather than block a
+ * producer, dropped() counts them.
+ */
+template <typename T, std::size_t Capacity> class MpscRing {
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0,
+                  "The capacity has to be a power of two.");
+
+  private:
+    static constexpr std::size_t Mask = Capacity - 1;
+
+    struct alignas(jobs::CacheLine) Slot {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::array<Slot, Capacity> slots;
+    alignas(jobs::CacheLine) std::atomic<std::size_t> head{0};
+    alignas(jobs::CacheLine) std::size_t tail = 0;
+    std::atomic<std::size_t> droppedCount{0};
+
+  public:
+    MpscRing() {
+        for (std::size_t i = 0; i < Capacity; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing &) = delete;
+    MpscRing(MpscRing &&) = delete;
+    auto operator=(const MpscRing &) -> MpscRing & = delete;
+    auto operator=(MpscRing &&) -> MpscRing & = delete;
+    ~MpscRing() = default;
+
+    /**
+     * @brief Any thread.
+     *
+     * @return bool False when the ring was full and the item dropped.
+     */
+    auto push(T value) -> bool {
+        auto position = head.load(std::memory_order_relaxed);
+
+        for (;;) {
+            auto &slot = slots[position & Mask];
+            auto sequence = slot.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::intptr_t>(sequence) -
+                              static_cast<std::intptr_t>(position);
+
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(position + 1,
+                                        std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief The consumer thread only.
+     */
+    auto pop() -> std::optional<T> {
+        auto &slot = slots[tail & Mask];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1) {
+            return std::nullopt;
+        }
+
+        std::optional<T> value(std::move(slot.value));
+        slot.sequence.store(tail + Capacity, std::memory_order_release);
+        tail++;
+        return value;
+    }
+
+    /**
+     * @brief The consumer thread only, pops every item pushed so far into
+     * fn in push order.
+     *
+     * @return std::size_t The number of items popped.
+     */
+    template <typename Fn> auto drain(Fn &&fn) -> std::size_t {
+        std::size_t count = 0;
+        while (auto value = pop()) {
+            fn(std::move(*value));
+            count++;
+        }
+        return count;
+    }
+
+    [[nodiscard]] auto dropped() const -> std::size_t {
+        return droppedCount.load(std::memory_order_relaxed);
+    }
+
+    static constexpr auto capacity() -> std::size_t { return Capacity; }
+};
+} // namespace gim::library::queue
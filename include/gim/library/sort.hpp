@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <gim/library/jobs.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace gim::library::sort {
+// Keys sorted per radix pass, 8 bits each.
+inline constexpr unsigned RadixBits = 8;
+inline constexpr std::size_t Buckets = std::size_t{1} << RadixBits;
+// Fewer keys than this per thread aren't worth splitting up.
+inline constexpr std::size_t ParallelGrain = 16 * 1024;
+
+namespace detail {
+// Sorting keys alone.
+struct NoValues {};
+
+template <std::unsigned_integral Key, typename Values>
+auto radixSort(std::span<Key> keys, Values values, unsigned bits,
+               jobs::JobSystem &jobs) -> void {
+    constexpr bool HasValues = !std::same_as<Values, NoValues>;
+    assert(bits <= sizeof(Key) * 8 && "Keys don't have that many bits.");
+    auto count = keys.size();
+    if (count < 2) {
+        return;
+    }
+
+    auto chunks = std::clamp<std::size_t>(count / ParallelGrain, 1,
+                                          jobs.concurrency());
+    auto chunkSize = (count + chunks - 1) / chunks;
+    auto forChunks = [&](auto &&fn) {
+        jobs.parallelFor(chunks, 1, [&](std::size_t begin, std::size_t end) {
+            for (auto chunk = begin; chunk < end; chunk++) {
+                fn(chunk, chunk * chunkSize,
+                   std::min(count, (chunk + 1) * chunkSize));
+            }
+        });
+    };
+
+    std::vector<Key> scratch(count);
+    std::span<Key> from = keys;
+    std::span<Key> to = scratch;
+    auto valueScratch = [&] {
+        if constexpr (HasValues) {
+            return std::vector<typename Values::value_type>(count);
+        } else {
+            return NoValues{};
+        }
+    }();
+    auto valuesFrom = values;
+    auto valuesTo = [&] {
+        if constexpr (HasValues) {
+            return Values(valueScratch);
+        } else {
+            return NoValues{};
+        }
+    }();
+    std::vector<std::array<std::size_t, Buckets>> histograms(chunks);
+
+    for (unsigned shift = 0; shift < bits; shift += RadixBits) {
+        // The last digit only takes the bits below bits.
+        auto mask = (std::size_t{1} << std::min(RadixBits, bits - shift)) - 1;
+        auto digitOf = [shift, mask](Key key) {
+            return static_cast<std::size_t>(key >> shift) & mask;
+        };
+
+        forChunks([&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            std::array<std::size_t, Buckets> histogram{};
+            auto const *source = from.data();
+            for (auto i = begin; i < end; i++) {
+                histogram[digitOf(source[i])]++;
+            }
+            histograms[chunk] = histogram;
+        });
+
+        // Turn the counts into where every chunk writes each digit, digits
+        // first so the chunks stay in order.
+        std::size_t offset = 0;
+        bool sorted = false;
+        for (std::size_t digit = 0; digit < Buckets; digit++) {
+            auto start = offset;
+            for (auto &histogram : histograms) {
+                offset += std::exchange(histogram[digit], offset);
+            }
+            sorted = sorted || offset - start == count;
+        }
+        if (sorted) {
+            continue;
+        }
+
+        forChunks([&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto histogram = histograms[chunk];
+            auto const *source = from.data();
+            auto *target = to.data();
+            for (auto i = begin; i < end; i++) {
+                auto key = source[i];
+                auto index = histogram[digitOf(key)]++;
+                target[index] = key;
+                if constexpr (HasValues) {
+                    valuesTo[index] = std::move(valuesFrom[i]);
+                }
+            }
+        });
+        std::swap(from, to);
+        std::swap(valuesFrom, valuesTo);
+    }
+
+    if (from.data() != keys.data()) {
+        std::copy(from.begin(), from.end(), keys.begin());
+        if constexpr (HasValues) {
+            std::move(valuesFrom.begin(), valuesFrom.end(), values.begin());
+        }
+    }
+}
+} // namespace detail
+
+/**
+ * @brief Sort unsigned keys by their low bits with a least significant
+ * digit radix sort, 8 bits per pass.
+ *
+ * Every pass counts the digits of each chunk of keys in parallel, then
+ * scatters the chunks in parallel to where the counts say, so the sort is
+ * stable and bound by memory bandwidth rather than comparisons. Passes
+ * where every key has the same digit are skipped, so keys which only use a
+ * few of their bits (Morton codes of a small region) cost little more than
+ * those bits. Only the low `bits` bits are sorted on, the last pass masks
+ * off what is above them, so keys which agree on them keep their input
+ * order whatever their higher bits hold. bits can't exceed the key's.
+ */
+template <std::unsigned_integral Key>
+auto radixSort(std::span<Key> keys, unsigned bits = sizeof(Key) * 8,
+               jobs::JobSystem &jobs = jobs::JobSystem::instance()) -> void {
+    detail::radixSort(keys, detail::NoValues{}, bits, jobs);
+}
+
+/**
+ * @brief Sort keys the same way, moving values[i] along with keys[i], for
+ * sorting things by a key computed for each of them (voxels by their
+ * Morton code). Values need to be default constructible.
+ */
+template <std::unsigned_integral Key, typename Value>
+auto radixSort(std::span<Key> keys, std::span<Value> values,
+               unsigned bits = sizeof(Key) * 8,
+               jobs::JobSystem &jobs = jobs::JobSystem::instance()) -> void {
+    assert(keys.size() == values.size() && "Every key needs a value.");
+    detail::radixSort(keys, values, bits, jobs);
+}
+} // namespace gim::library::sort
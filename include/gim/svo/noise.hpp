@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vendor/fastnoiselite.hpp>
+
+namespace gim::svo {
+/**
+ * @brief What batch noise is evaluated with, from one point at a time to 16
+ * points per instruction.
+ */
+enum class Simd : std::uint8_t { Scalar, Sse2, Avx2, Avx512 };
+
+/**
+ * @brief The widest instruction set the CPU supports.
+ */
+auto detectSimd() -> Simd;
+} // namespace gim::svo
+
+/**
+ * @brief 3D OpenSimplex2S noise with FastNoiseLite's default seed and
+ * frequency.
+ *
+ * getNoise() evaluates a single point through FastNoiseLite, generate() and
+ * generateGrid() evaluate many at once with the widest SIMD kernel the CPU
+ * supports, picked when the noise is created. Batches match getNoise() bit
+ * for bit, noise.cpp is built without fused multiply-adds.
+ */
+class SimplexNoise {
+  public:
+    static constexpr int Seed = 1337;
+    static constexpr float Frequency = 0.01f;
+
+  private:
+    FastNoiseLite noise;
+    gim::svo::Simd simd;
+
+  public:
+    SimplexNoise();
+
+    [[nodiscard]] float getNoise(float x, float y, float z) const;
+
+    /**
+     * @brief The noise at every position, out needs as many values.
+     */
+    void generate(std::span<const glm::vec3> positions,
+                  std::span<float> out) const;
+
+    /**
+     * @brief The noise at origin + step * (x, y, z) for every (x, y, z) up
+     * to size, x first then y then z, so the value of (x, y, z) is
+     * out[x + size.x * (y + size.y * z)].
+     */
+    void generateGrid(glm::vec3 origin, glm::ivec3 size, float step,
+                      std::span<float> out) const;
+
+    [[nodiscard]] gim::svo::Simd getSimd() const { return simd; }
+
+    /**
+     * @brief Evaluate batches with a narrower instruction set than detected,
+     * for comparing kernels. Wider ones than the CPU supports are ignored.
+     */
+    void setSimd(gim::svo::Simd simd);
+};
@@ -0,0 +1,685 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <gim/library/jobs.hpp>
+#include <gim/library/morton.hpp>
+#include <gim/library/sort.hpp>
+#include <memory_resource>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace gim::svo {
+/**
+ * @brief An octree node: which of its 8 children exist, which of those are
+ * leaves, and where the nodes of the others start.
+ *
+ * Child i covers the octant with x offset i & 1, y offset i & 2 and z offset
+ * i & 4. A leaf is a completely solid octant, a single voxel at the lowest
+ * level or a solid region above it, so it needs no node of its own. The
+ * other children are nodes stored contiguously from firstChild, in child
+ * order.
+ */
+struct Node {
+    std::uint8_t childMask = 0;
+    std::uint8_t leafMask = 0;
+    std::uint16_t reserved = 0;
+    std::uint32_t firstChild = 0;
+
+    // The children which have a node of their own.
+    [[nodiscard]] constexpr auto nodeMask() const -> std::uint8_t {
+        return static_cast<std::uint8_t>(childMask & ~leafMask);
+    }
+
+    // Where the node of child is stored.
+    [[nodiscard]] constexpr auto childNode(unsigned child) const
+        -> std::uint32_t {
+        return firstChild + static_cast<std::uint32_t>(std::popcount(
+                                static_cast<unsigned>(nodeMask()) &
+                                ((1U << child) - 1U)));
+    }
+
+    [[nodiscard]] constexpr auto full() const -> bool {
+        return childMask == 0xFF && leafMask == 0xFF;
+    }
+
+    friend constexpr auto operator==(Node const &, Node const &)
+        -> bool = default;
+};
+
+static_assert(sizeof(Node) == 8, "Nodes are packed into 8 bytes.");
+
+/**
+ * @brief A sparse voxel octree over a cube of 2^depth voxels a side, storing
+ * which voxels are solid.
+ *
+ * Empty octants take no memory and solid octants collapse into a leaf bit
+ * of their parent, so memory grows with the surface of the terrain rather
+ * than its volume. Changing the tree moves a node's children to the end of
+ * the node array when they have to grow, the space they leave behind is
+ * reclaimed by compact(), which also lays the tree out breadth first. The
+ * root is always the first node.
+ *
+ * Whole regions are faster to build() at once than to insert voxel by voxel,
+ * the result is the same as inserting them and calling compact().
+ */
+class SparseVoxelOctree {
+  public:
+    // Morton codes of the coordinates have to fit in 64 bits.
+    static constexpr std::uint32_t MaxDepth = 21;
+    static constexpr std::uint32_t DefaultDepth = 9;
+
+  private:
+    std::pmr::vector<Node> nodes;
+    std::uint32_t depth;
+    // Node slots which are no longer part of the tree.
+    std::size_t garbage = 0;
+
+    struct Step {
+        std::uint32_t node;
+        unsigned child;
+    };
+
+    [[nodiscard]] auto inBounds(std::uint32_t x, std::uint32_t y,
+                                std::uint32_t z) const -> bool {
+        auto side = size();
+        return x < side && y < side && z < side;
+    }
+
+    // The voxel an axis of a position falls in, or size() if that is out of
+    // bounds. The range is checked before converting, converting a negative
+    // or too large float to an unsigned is undefined.
+    template <typename Axis>
+    [[nodiscard]] auto voxelAxis(Axis value) const -> std::uint32_t {
+        auto side = size();
+        if constexpr (std::floating_point<Axis>) {
+            // Also false for NaN.
+            auto voxel = std::floor(value);
+            return voxel >= Axis{0} && voxel < static_cast<Axis>(side)
+                       ? static_cast<std::uint32_t>(voxel)
+                       : side;
+        } else {
+            return std::cmp_greater_equal(value, 0) &&
+                           std::cmp_less(value, side)
+                       ? static_cast<std::uint32_t>(value)
+                       : side;
+        }
+    }
+
+    // The child of a node at level which contains the voxel, the root's
+    // level is depth and voxels are the children of level 1 nodes.
+    static auto childAt(std::uint32_t x, std::uint32_t y, std::uint32_t z,
+                        std::uint32_t level) -> unsigned {
+        auto shift = level - 1;
+        return ((x >> shift) & 1U) | (((y >> shift) & 1U) << 1U) |
+               (((z >> shift) & 1U) << 2U);
+    }
+
+    /**
+     * @brief Give child of parent the node value, moving the parent's
+     * children to the end of the array unless they are the last block.
+     */
+    auto insertChildNode(std::uint32_t parent, unsigned child, Node value)
+        -> std::uint32_t {
+        auto node = nodes[parent];
+        auto count = static_cast<std::uint32_t>(
+            std::popcount(static_cast<unsigned>(node.nodeMask())));
+        auto position = node.childNode(child) - node.firstChild;
+
+        if (count == 0 || node.firstChild + count == nodes.size()) {
+            // The children already end the array, grow the block in place.
+            auto first = count == 0 ? static_cast<std::uint32_t>(nodes.size())
+                                    : node.firstChild;
+            nodes.insert(nodes.begin() + first + position, value);
+            node.firstChild = first;
+        } else {
+            auto first = static_cast<std::uint32_t>(nodes.size());
+            for (std::uint32_t i = 0; i < count + 1; i++) {
+                auto moved =
+                    i == position
+                        ? value
+                        : nodes[node.firstChild + i - (i > position ? 1 : 0)];
+                nodes.push_back(moved);
+            }
+            garbage += count;
+            node.firstChild = first;
+        }
+
+        node.childMask |= static_cast<std::uint8_t>(1U << child);
+        node.leafMask &= static_cast<std::uint8_t>(~(1U << child));
+        nodes[parent] = node;
+        return node.childNode(child);
+    }
+
+    /**
+     * @brief Drop the node of child of parent and everything below it,
+     * leaving the child's bits to the caller.
+     */
+    auto removeChildNode(std::uint32_t parent, unsigned child) -> void {
+        auto node = nodes[parent];
+        auto count = static_cast<std::uint32_t>(
+            std::popcount(static_cast<unsigned>(node.nodeMask())));
+        auto removed = node.childNode(child);
+
+        garbage += subtreeSize(removed);
+        for (auto i = removed; i + 1 < node.firstChild + count; i++) {
+            nodes[i] = nodes[i + 1];
+        }
+
+        node.leafMask |= static_cast<std::uint8_t>(1U << child);
+        if (count == 1) {
+            node.firstChild = 0;
+        }
+        nodes[parent] = node;
+    }
+
+    [[nodiscard]] auto subtreeSize(std::uint32_t index) const -> std::size_t {
+        auto const &node = nodes[index];
+        std::size_t size = 1;
+        auto mask = static_cast<unsigned>(node.nodeMask());
+        for (unsigned child = 0; child < 8; child++) {
+            if ((mask & (1U << child)) != 0) {
+                size += subtreeSize(node.childNode(child));
+            }
+        }
+        return size;
+    }
+
+    auto compactIfWasteful() -> void {
+        if (garbage > 1024 && garbage > nodes.size() / 2) {
+            compact();
+        }
+    }
+
+    // Fewer entries than this per thread aren't worth building in parallel.
+    static constexpr std::size_t BuildGrain = 4096;
+
+    /**
+     * @brief The nodes of one level of a build, sorted by the Morton code
+     * of their position at that level.
+     */
+    struct Level {
+        std::vector<std::uint64_t> keys;
+        std::vector<std::uint8_t> childMasks;
+        std::vector<std::uint8_t> leafMasks;
+        // Where the children of every node start on the level below, with
+        // one past the last at the end.
+        std::vector<std::uint32_t> starts;
+        // Where every node which isn't a leaf is stored among its level.
+        std::vector<std::uint32_t> ranks;
+        std::uint32_t stored = 0;
+
+        [[nodiscard]] auto full(std::size_t i) const -> bool {
+            return childMasks[i] == 0xFF && leafMasks[i] == 0xFF;
+        }
+    };
+
+    /**
+     * @brief Call fn(begin, end) for about even ranges of count items, one
+     * range per thread, with prefix sums over them kept in order by the
+     * range index it is also passed.
+     */
+    template <typename Fn>
+    static auto forRanges(std::size_t count, std::size_t ranges,
+                          library::jobs::JobSystem &jobs, Fn &&fn) -> void {
+        auto size = (count + ranges - 1) / ranges;
+        jobs.parallelFor(ranges, 1, [&](std::size_t begin, std::size_t end) {
+            for (auto range = begin; range < end; range++) {
+                fn(range, std::min(count, range * size),
+                   std::min(count, (range + 1) * size));
+            }
+        });
+    }
+
+    /**
+     * @brief Group the sorted nodes of a level into their parents, with the
+     * prefix sums of parents and stored children per range giving every
+     * parent and child its index without a serial pass.
+     */
+    template <typename Full>
+    static auto buildParents(std::span<std::uint64_t const> keys, Full &&full,
+                             std::vector<std::uint32_t> *ranks,
+                             std::uint32_t &stored,
+                             library::jobs::JobSystem &jobs) -> Level {
+        auto count = keys.size();
+        auto ranges = std::clamp<std::size_t>(count / BuildGrain, 1,
+                                              jobs.concurrency());
+        auto head = [&](std::size_t i) {
+            return i == 0 || (keys[i] >> 3U) != (keys[i - 1] >> 3U);
+        };
+
+        std::vector<std::uint32_t> heads(ranges);
+        std::vector<std::uint32_t> storedBefore(ranges);
+        forRanges(count, ranges, jobs,
+                  [&](std::size_t range, std::size_t begin, std::size_t end) {
+                      std::uint32_t parents = 0;
+                      std::uint32_t nodes = 0;
+                      for (auto i = begin; i < end; i++) {
+                          parents += head(i) ? 1 : 0;
+                          nodes += full(i) ? 0 : 1;
+                      }
+                      heads[range] = parents;
+                      storedBefore[range] = nodes;
+                  });
+
+        std::uint32_t parents = 0;
+        stored = 0;
+        for (std::size_t range = 0; range < ranges; range++) {
+            parents += std::exchange(heads[range], parents);
+            stored += std::exchange(storedBefore[range], stored);
+        }
+
+        Level level;
+        level.keys.resize(parents);
+        level.childMasks.resize(parents);
+        level.leafMasks.resize(parents);
+        level.starts.resize(parents + 1);
+        level.starts[parents] = static_cast<std::uint32_t>(count);
+        if (ranks != nullptr) {
+            ranks->resize(count);
+        }
+
+        forRanges(count, ranges, jobs,
+                  [&](std::size_t range, std::size_t begin, std::size_t end) {
+                      auto parent = heads[range];
+                      auto rank = storedBefore[range];
+                      for (auto i = begin; i < end; i++) {
+                          if (head(i)) {
+                              level.keys[parent] = keys[i] >> 3U;
+                              level.starts[parent] =
+                                  static_cast<std::uint32_t>(i);
+                              parent++;
+                          }
+                          if (ranks != nullptr) {
+                              (*ranks)[i] = rank;
+                          }
+                          rank += full(i) ? 0 : 1;
+                      }
+                  });
+
+        forRanges(parents, std::clamp<std::size_t>(parents / BuildGrain, 1,
+                                                   jobs.concurrency()),
+                  jobs,
+                  [&](std::size_t, std::size_t begin, std::size_t end) {
+                      for (auto parent = begin; parent < end; parent++) {
+                          std::uint8_t children = 0;
+                          std::uint8_t leaves = 0;
+                          for (auto i = level.starts[parent];
+                               i < level.starts[parent + 1]; i++) {
+                              auto bit =
+                                  static_cast<std::uint8_t>(1U << (keys[i] & 7U));
+                              children |= bit;
+                              leaves |= full(i) ? bit : 0;
+                          }
+                          level.childMasks[parent] = children;
+                          level.leafMasks[parent] = leaves;
+                      }
+                  });
+
+        return level;
+    }
+
+    /**
+     * @brief Insert the sorted, distinct cubes of a level among its nodes
+     * as full ones without children.
+     */
+    static auto addCubes(Level &level, std::span<std::uint64_t const> cubes)
+        -> void {
+        if (cubes.empty()) {
+            return;
+        }
+
+        Level merged;
+        auto count = level.keys.size() + cubes.size();
+        merged.keys.reserve(count);
+        merged.childMasks.reserve(count);
+        merged.leafMasks.reserve(count);
+        merged.starts.reserve(count + 1);
+        std::size_t i = 0;
+        for (auto cube : cubes) {
+            for (; i < level.keys.size() && level.keys[i] < cube; i++) {
+                merged.keys.push_back(level.keys[i]);
+                merged.childMasks.push_back(level.childMasks[i]);
+                merged.leafMasks.push_back(level.leafMasks[i]);
+                merged.starts.push_back(level.starts[i]);
+            }
+            merged.keys.push_back(cube);
+            merged.childMasks.push_back(0xFF);
+            merged.leafMasks.push_back(0xFF);
+            merged.starts.push_back(level.starts[i]);
+        }
+        for (; i < level.keys.size(); i++) {
+            merged.keys.push_back(level.keys[i]);
+            merged.childMasks.push_back(level.childMasks[i]);
+            merged.leafMasks.push_back(level.leafMasks[i]);
+            merged.starts.push_back(level.starts[i]);
+        }
+        merged.starts.push_back(level.starts.back());
+        level = std::move(merged);
+    }
+
+    /**
+     * @brief Replace the tree with the sorted cubes of every level, see
+     * buildCubes().
+     */
+    auto buildSorted(std::span<std::vector<std::uint64_t> const> cubes,
+                     library::jobs::JobSystem &jobs) -> void {
+        assert(cubes.size() <= depth && "The root can't be a cube.");
+        nodes.assign(1, Node{});
+        garbage = 0;
+        if (std::ranges::all_of(
+                cubes, [](auto const &level) { return level.empty(); })) {
+            return;
+        }
+        auto cubesAt = [&](std::uint32_t l) {
+            return l < cubes.size() ? std::span<std::uint64_t const>(cubes[l])
+                                    : std::span<std::uint64_t const>();
+        };
+
+        // levels[l] are the nodes at level l, the voxels have no level.
+        std::vector<Level> levels(depth + 1);
+        std::uint32_t stored = 0;
+        levels[1] = buildParents(
+            cubesAt(0), [](std::size_t) { return true; }, nullptr, stored,
+            jobs);
+        addCubes(levels[1], cubesAt(1));
+        for (std::uint32_t l = 2; l <= depth; l++) {
+            auto &children = levels[l - 1];
+            levels[l] = buildParents(
+                children.keys,
+                [&](std::size_t i) { return children.full(i); },
+                &children.ranks, children.stored, jobs);
+            addCubes(levels[l], cubesAt(l));
+        }
+
+        // Breadth first every level follows the one above, in key order.
+        std::vector<std::uint32_t> offsets(depth + 1);
+        std::uint32_t total = 1;
+        for (auto l = depth - 1; l >= 1; l--) {
+            offsets[l] = total;
+            total += levels[l].stored;
+        }
+        nodes.resize(total);
+
+        auto write = [&](std::uint32_t l, std::size_t i, std::uint32_t index) {
+            auto const &level = levels[l];
+            Node node{.childMask = level.childMasks[i],
+                      .leafMask = level.leafMasks[i]};
+            if (node.nodeMask() != 0) {
+                node.firstChild = offsets[l - 1] +
+                                  levels[l - 1].ranks[level.starts[i]];
+            }
+            nodes[index] = node;
+        };
+
+        write(depth, 0, 0);
+        for (std::uint32_t l = 1; l < depth; l++) {
+            auto const &level = levels[l];
+            jobs.parallelFor(level.keys.size(), BuildGrain,
+                             [&](std::size_t begin, std::size_t end) {
+                                 for (auto i = begin; i < end; i++) {
+                                     if (!level.full(i)) {
+                                         write(l, i,
+                                               offsets[l] + level.ranks[i]);
+                                     }
+                                 }
+                             });
+        }
+    }
+
+  public:
+    /**
+     * @brief An empty octree 2^depth voxels a side, trees which are only
+     * built for one frame can pass the frame arena as memory.
+     */
+    explicit SparseVoxelOctree(
+        std::uint32_t depth = DefaultDepth,
+        std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+        : nodes(memory), depth(depth) {
+        assert(depth >= 1 && depth <= MaxDepth && "Unsupported octree depth.");
+        nodes.emplace_back();
+    }
+
+    [[nodiscard]] auto getDepth() const -> std::uint32_t { return depth; }
+
+    /**
+     * @brief The number of voxels along every side.
+     */
+    [[nodiscard]] auto size() const -> std::uint32_t { return 1U << depth; }
+
+    /**
+     * @brief Make the voxel solid.
+     *
+     * @return bool False if it was solid already or is out of bounds.
+     */
+    auto insert(std::uint32_t x, std::uint32_t y, std::uint32_t z) -> bool {
+        if (!inBounds(x, y, z)) {
+            return false;
+        }
+
+        std::array<Step, MaxDepth + 1> path{};
+        std::uint32_t index = 0;
+        for (auto level = depth; level >= 1; level--) {
+            auto child = childAt(x, y, z, level);
+            auto bit = static_cast<std::uint8_t>(1U << child);
+            auto node = nodes[index];
+            path[level] = {index, child};
+
+            if ((node.leafMask & bit) != 0) {
+                return false;
+            }
+            if (level == 1) {
+                nodes[index].childMask |= bit;
+                nodes[index].leafMask |= bit;
+                break;
+            }
+            index = (node.childMask & bit) != 0
+                        ? node.childNode(child)
+                        : insertChildNode(index, child, Node{});
+        }
+
+        // Octants which became completely solid turn into leaves.
+        for (std::uint32_t level = 1; level < depth; level++) {
+            if (!nodes[path[level].node].full()) {
+                break;
+            }
+            removeChildNode(path[level + 1].node, path[level + 1].child);
+        }
+
+        compactIfWasteful();
+        return true;
+    }
+
+    /**
+     * @brief Make the voxel empty.
+     *
+     * @return bool False if it was empty already or is out of bounds.
+     */
+    auto remove(std::uint32_t x, std::uint32_t y, std::uint32_t z) -> bool {
+        if (!inBounds(x, y, z)) {
+            return false;
+        }
+
+        std::array<Step, MaxDepth + 1> path{};
+        std::uint32_t index = 0;
+        for (auto level = depth; level >= 1; level--) {
+            auto child = childAt(x, y, z, level);
+            auto bit = static_cast<std::uint8_t>(1U << child);
+            auto node = nodes[index];
+            path[level] = {index, child};
+
+            if ((node.childMask & bit) == 0) {
+                return false;
+            }
+            if (level == 1) {
+                nodes[index].childMask &= static_cast<std::uint8_t>(~bit);
+                nodes[index].leafMask &= static_cast<std::uint8_t>(~bit);
+                break;
+            }
+            // Carving into a solid octant splits it into solid children.
+            index = (node.leafMask & bit) != 0
+                        ? insertChildNode(index, child,
+                                          Node{.childMask = 0xFF,
+                                               .leafMask = 0xFF})
+                        : node.childNode(child);
+        }
+
+        // Octants which became empty are dropped.
+        for (std::uint32_t level = 1; level < depth; level++) {
+            if (nodes[path[level].node].childMask != 0) {
+                break;
+            }
+            auto parent = path[level + 1];
+            removeChildNode(parent.node, parent.child);
+            nodes[parent.node].childMask &=
+                static_cast<std::uint8_t>(~(1U << parent.child));
+            nodes[parent.node].leafMask &=
+                static_cast<std::uint8_t>(~(1U << parent.child));
+        }
+
+        compactIfWasteful();
+        return true;
+    }
+
+    /**
+     * @brief Whether the voxel is solid, false out of bounds.
+     */
+    [[nodiscard]] auto lookup(std::uint32_t x, std::uint32_t y,
+                                std::uint32_t z) const -> bool {
+        if (!inBounds(x, y, z)) {
+            return false;
+        }
+
+        std::uint32_t index = 0;
+        for (auto level = depth; level >= 1; level--) {
+            auto child = childAt(x, y, z, level);
+            auto bit = 1U << child;
+            auto const &node = nodes[index];
+
+            if ((node.childMask & bit) == 0) {
+                return false;
+            }
+            if ((node.leafMask & bit) != 0) {
+                return true;
+            }
+            index = node.childNode(child);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Drop unused node slots and lay the tree out breadth first,
+     * every level after the one above it and children in child order.
+     */
+    auto compact() -> void {
+        std::pmr::vector<Node> packed(nodes.get_allocator());
+        std::vector<std::uint32_t> from;
+        packed.reserve(nodes.size() - garbage);
+        packed.push_back(nodes[0]);
+        from.push_back(0);
+
+        for (std::size_t i = 0; i < packed.size(); i++) {
+            auto node = nodes[from[i]];
+            auto count = static_cast<std::uint32_t>(
+                std::popcount(static_cast<unsigned>(node.nodeMask())));
+
+            packed[i].firstChild =
+                count == 0 ? 0 : static_cast<std::uint32_t>(packed.size());
+            for (std::uint32_t child = 0; child < count; child++) {
+                packed.push_back(nodes[node.firstChild + child]);
+                from.push_back(node.firstChild + child);
+            }
+        }
+
+        nodes = std::move(packed);
+        garbage = 0;
+    }
+
+    /**
+     * @brief Replace the tree with the given solid voxels, anything with a
+     * position.x, .y and .z, integers or floats rounded down. Voxels out of
+     * bounds are skipped and duplicates don't matter.
+     *
+     * The voxels are sorted by their Morton codes, which puts the children
+     * of every node next to each other on every level, so the tree is built
+     * bottom up one level at a time without searching, every step spread
+     * over the job system.
+     */
+    template <typename Voxel>
+    auto build(std::span<Voxel const> voxels,
+               library::jobs::JobSystem &jobs =
+                   library::jobs::JobSystem::instance()) -> void {
+        auto bits = 3 * depth;
+        // Out of bounds voxels sort after every valid code.
+        auto outOfBounds = std::uint64_t{1} << bits;
+
+        std::vector<std::vector<std::uint64_t>> cubes(1);
+        auto &codes = cubes[0];
+        codes.resize(voxels.size());
+        jobs.parallelFor(
+            voxels.size(), BuildGrain,
+            [&](std::size_t begin, std::size_t end) {
+                for (auto i = begin; i < end; i++) {
+                    auto const &position = voxels[i].position;
+                    auto x = voxelAxis(position.x);
+                    auto y = voxelAxis(position.y);
+                    auto z = voxelAxis(position.z);
+                    codes[i] = inBounds(x, y, z)
+                                   ? library::morton::encode(x, y, z)
+                                   : outOfBounds;
+                }
+            });
+        library::sort::radixSort(std::span(codes), bits + 1, jobs);
+        codes.erase(std::lower_bound(codes.begin(), codes.end(), outOfBounds),
+                    codes.end());
+        buildSorted(cubes, jobs);
+    }
+
+    /**
+     * @brief Replace the tree with solid cubes, cubes[l] holding the Morton
+     * codes of cubes 2^l voxels a side, of their position divided by 2^l.
+     * Building from voxels is cubes[0] alone. Every level is sorted in
+     * place, cubes may repeat but must not overlap those of other levels.
+     *
+     * A region which is solid throughout takes a single cube instead of all
+     * its voxels, so terrain filled in from the surface down costs about as
+     * much as its surface.
+     */
+    auto buildCubes(std::span<std::vector<std::uint64_t>> cubes,
+                    library::jobs::JobSystem &jobs =
+                        library::jobs::JobSystem::instance()) -> void {
+        for (std::uint32_t l = 0; l < cubes.size(); l++) {
+            auto &level = cubes[l];
+            auto bits = 3 * (depth - l);
+            library::sort::radixSort(std::span(level), bits, jobs);
+            level.erase(std::unique(level.begin(), level.end()), level.end());
+            assert((level.empty() || level.back() >> bits == 0) &&
+                   "Cubes need to be inside the tree.");
+        }
+        buildSorted(cubes, jobs);
+    }
+
+    /**
+     * @brief Every node, the root first, including unused slots until the
+     * next compact().
+     */
+    [[nodiscard]] auto getNodes() const -> std::span<Node const> {
+        return nodes;
+    }
+
+    [[nodiscard]] auto nodeCount() const -> std::size_t {
+        return nodes.size() - garbage;
+    }
+
+    [[nodiscard]] auto memoryUsage() const -> std::size_t {
+        return nodes.capacity() * sizeof(Node);
+    }
+};
+} // namespace gim::svo
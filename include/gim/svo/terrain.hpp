@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <gim/library/jobs.hpp>
+#include <gim/svo/noise.hpp>
+#include <gim/svo/octree.hpp>
+#include <span>
+#include <vector>
+
+namespace gim::svo {
+/**
+ * @brief One column of terrain: solid from the bottom up to floor, then
+ * voxel floor + i is solid where bit i of band is set, and nothing is solid
+ * above the band.
+ */
+struct Column {
+    std::int32_t floor = 0;
+    std::uint32_t band = 0;
+};
+} // namespace gim::svo
+
+/**
+ * @brief Terrain as a heightfield with overhangs: 2D noise gives the height
+ * of every column, 3D noise only carves the band of voxels around it.
+ *
+ * Noise is evaluated once per column plus BandHeight times per column for
+ * the band, and everything below the band is filled in with the largest
+ * cubes which fit under it, so generating terrain costs about as much as
+ * its surface rather than its volume.
+ */
+class TerrainGenerator {
+  public:
+    // Where the surface is on average and how far it strays from that.
+    static constexpr float BaseHeight = 64.0f;
+    static constexpr float HeightAmplitude = 32.0f;
+    // Voxels this close to the surface, half of them above it and half
+    // below, are solid where the 3D noise doesn't carve them out.
+    static constexpr int BandHeight = 16;
+    static constexpr float BandAmplitude = 8.0f;
+    // Noise coordinates per voxel, the band noise is finer than the height.
+    static constexpr float HeightScale = 1.0f;
+    static constexpr float BandScale = 4.0f;
+
+    static_assert(BandHeight <= 32, "The band needs to fit Column::band.");
+
+  private:
+    SimplexNoise noise;
+
+  public:
+    /**
+     * @brief The columns of a square of side by side columns from the
+     * origin, x first, which are side voxels high. One row per job.
+     */
+    [[nodiscard]] auto generateColumns(
+        std::uint32_t side, gim::library::jobs::JobSystem &jobs =
+                                gim::library::jobs::JobSystem::instance()) const
+        -> std::vector<gim::svo::Column>;
+
+    /**
+     * @brief The cubes which make up the columns of a tree of depth, for
+     * SparseVoxelOctree::buildCubes(). Every square of 2^l columns gets the
+     * cubes of level l which fit below all of their floors and aren't in a
+     * larger cube already, and the band is made of single voxels.
+     */
+    [[nodiscard]] static auto
+    solidCubes(std::span<gim::svo::Column const> columns, std::uint32_t depth)
+        -> std::vector<std::vector<std::uint64_t>>;
+
+    /**
+     * @brief Replace the octree with terrain filling its whole base.
+     */
+    auto generate(gim::svo::SparseVoxelOctree &octree,
+                  gim::library::jobs::JobSystem &jobs =
+                      gim::library::jobs::JobSystem::instance()) const -> void;
+};
@@ -1,3 +0,0 @@
-#include <cstddef>
-
-constexpr size_t MaxEntities = 1024;
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fmt/core.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gim::bench {
+/**
+ * @brief Keep the compiler from optimising away a value a benchmark
+ * computes but never uses.
+ */
+template <typename T> inline auto doNotOptimize(T const &value) -> void {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile auto sink = value;
+    sink = value;
+#endif
+}
+
+struct Result {
+    // The GIM_BENCHMARK the measurement belongs to.
+    std::string benchmark;
+    std::string name;
+    std::size_t entities;
+    std::size_t ops;
+    std::size_t samples;
+    double nanosecondsPerOp;
+    double fastestNanosecondsPerOp;
+};
+
+using Benchmark = void (*)();
+
+inline auto registry() -> std::vector<std::pair<std::string, Benchmark>> & {
+    static std::vector<std::pair<std::string, Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+inline auto results() -> std::vector<Result> & {
+    static std::vector<Result> measured;
+    return measured;
+}
+
+// The name of the GIM_BENCHMARK being run.
+inline auto currentBenchmark() -> std::string & {
+    static std::string name;
+    return name;
+}
+
+struct Registration {
+    Registration(const char *name, Benchmark benchmark) {
+        registry().emplace_back(name, benchmark);
+    }
+};
+
+/**
+ * @brief Time fn, which performs ops operations over a world of the given
+ * number of entities, and record the median time per operation.
+ *
+ * fn is run once to warm up and then repeatedly for at least
+ * minimumSamples runs and roughly 200ms.
+ */
+template <typename Fn>
+auto measure(const std::string &name, std::size_t entities, std::size_t ops,
+             Fn &&fn, std::size_t minimumSamples = 5) -> void {
+    using Clock = std::chrono::steady_clock;
+    const auto budget = std::chrono::milliseconds(200);
+
+    fn();
+
+    std::vector<double> samples;
+    auto started = Clock::now();
+    while (samples.size() < minimumSamples || Clock::now() - started < budget) {
+        auto begin = Clock::now();
+        fn();
+        auto elapsed = std::chrono::duration<double, std::nano>(
+                           Clock::now() - begin)
+                           .count();
+        samples.push_back(elapsed / static_cast<double>(std::max<std::size_t>(
+                                        ops, 1)));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto median = samples[samples.size() / 2];
+
+    results().push_back({.benchmark = currentBenchmark(),
+                         .name = name,
+                         .entities = entities,
+                         .ops = ops,
+                         .samples = samples.size(),
+                         .nanosecondsPerOp = median,
+                         .fastestNanosecondsPerOp = samples.front()});
+    fmt::print("{:<56} {:>9} {:>12.3f} ns/op\n", name, entities, median);
+}
+
+namespace detail {
+inline auto jsonString(std::string_view text) -> std::string {
+    std::string quoted = "\"";
+    for (auto c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            // JSON doesn't allow control characters in strings.
+            quoted += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+} // namespace detail
+
+/**
+ * @brief Write every result as JSON, along with how the benchmarks were
+ * built, so runs can be compared between releases.
+ *
+ * @return bool Whether the file could be written.
+ */
+inline auto writeJson(const std::string &path) -> bool {
+    auto *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+#ifdef GIM_ECS_ARCHETYPES
+    constexpr std::string_view storage = "archetypes";
+#else
+    constexpr std::string_view storage = "sparse";
+#endif
+#ifdef NDEBUG
+    constexpr bool assertions = false;
+#else
+    constexpr bool assertions = true;
+#endif
+
+    fmt::print(file, "{{\n  \"storage\": {},\n", detail::jsonString(storage));
+    fmt::print(file, "  \"compiler\": {},\n",
+               detail::jsonString(
+#if defined(__clang__)
+                   "clang " __clang_version__
+#elif defined(__GNUC__)
+                   "gcc " __VERSION__
+#else
+                   "unknown"
+#endif
+                   ));
+    fmt::print(file, "  \"assertions\": {},\n  \"results\": [", assertions);
+
+    auto const &measured = results();
+    for (std::size_t i = 0; i < measured.size(); i++) {
+        auto const &result = measured[i];
+        fmt::print(file,
+                   "{}\n    {{\"benchmark\": {}, \"name\": {}, "
+                   "\"entities\": {}, \"ops\": {}, \"samples\": {}, "
+                   "\"ns_per_op\": {:.3f}, \"fastest_ns_per_op\": {:.3f}}}",
+                   i == 0 ? "" : ",", detail::jsonString(result.benchmark),
+                   detail::jsonString(result.name), result.entities,
+                   result.ops, result.samples, result.nanosecondsPerOp,
+                   result.fastestNanosecondsPerOp);
+    }
+
+    fmt::print(file, "\n  ]\n}}\n");
+    return std::fclose(file) == 0;
+}
+} // namespace gim::bench
+
+#define GIM_BENCH_CAT_(a, b) a##b
+#define GIM_BENCH_CAT(a, b) GIM_BENCH_CAT_(a, b)
+#define GIM_BENCHMARK(name)                                                    \
+    static void GIM_BENCH_CAT(gimBenchmark, __LINE__)();                       \
+    static const gim::bench::Registration GIM_BENCH_CAT(gimRegistration,       \
+                                                        __LINE__)(             \
+        name, GIM_BENCH_CAT(gimBenchmark, __LINE__));                          \
+    static void GIM_BENCH_CAT(gimBenchmark, __LINE__)()
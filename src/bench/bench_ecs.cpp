@@ -0,0 +1,231 @@
+#include "bench.hpp"
+#include <cstdint>
+#include <gim/ecs/ecs.hpp>
+#include <gim/ecs/engine/signature.hpp>
+#include <memory>
+#include <vector>
+
+using namespace gim::ecs;
+
+// Benchmarks of the public ECS API, with whichever storage backend the
+// target was configured with. Every benchmark runs at the same world sizes
+// and only uses deterministic data so runs can be compared.
+
+namespace {
+constexpr std::size_t Sizes[] = {1'000U, 100'000U, 1'000'000U};
+
+struct Position {
+    float x = 0.F, y = 0.F, z = 0.F;
+};
+
+struct Velocity {
+    float x = 1.F, y = 1.F, z = 1.F;
+};
+
+struct Health {
+    int value = 100;
+};
+
+template <typename Self> class BenchSystem : public ISystem {
+  private:
+    std::shared_ptr<ComponentManager> componentManager;
+
+  public:
+    auto getSignature() -> std::shared_ptr<Signature> override {
+        return std::make_shared<Signature>();
+    }
+    auto setComponentManager(std::shared_ptr<ComponentManager> cm)
+        -> void override {
+        componentManager = std::move(cm);
+    }
+    auto getComponentManager() -> std::shared_ptr<ComponentManager> override {
+        return componentManager;
+    }
+};
+
+class Integrate : public BenchSystem<Integrate> {
+  public:
+    using Reads = Components<Velocity>;
+    using Writes = Components<Position>;
+
+    auto update() -> void override {
+        getComponentManager()->view<Position, const Velocity>().each(
+            [](Entity, Position &position, const Velocity &velocity) {
+                position.x += velocity.x;
+                position.y += velocity.y;
+                position.z += velocity.z;
+            });
+    }
+};
+
+class Decay : public BenchSystem<Decay> {
+  public:
+    using Writes = Components<Health>;
+
+    auto update() -> void override {
+        getComponentManager()->view<Health>().each(
+            [](Entity, Health &health) { health.value--; });
+    }
+};
+
+// Touches nothing, so it only costs what scheduling a system costs.
+template <int N> class Idle : public BenchSystem<Idle<N>> {
+  public:
+    using Reads = Components<>;
+
+    auto update() -> void override {}
+};
+
+auto makeWorld() -> std::unique_ptr<ECS> {
+    auto ecs = std::make_unique<ECS>();
+    ecs->registerComponent<Position>();
+    ecs->registerComponent<Velocity>();
+    ecs->registerComponent<Health>();
+    return ecs;
+}
+
+// Every entity has a Position, every other one a Velocity and every third
+// one Health.
+auto populate(ECS &ecs, std::size_t count) -> std::vector<Entity> {
+    std::vector<Entity> entities;
+    entities.reserve(count);
+
+    for (std::size_t i = 0; i < count; i++) {
+        auto entity = ecs.createEntity();
+        ecs.emplace<Position>(entity);
+        if (i % 2 == 0) {
+            ecs.emplace<Velocity>(entity);
+        }
+        if (i % 3 == 0) {
+            ecs.emplace<Health>(entity);
+        }
+        entities.push_back(entity);
+    }
+
+    return entities;
+}
+} // namespace
+
+GIM_BENCHMARK("ecs/create-destroy") {
+    for (auto count : Sizes) {
+        auto ecs = makeWorld();
+        std::vector<Entity> entities(count);
+
+        gim::bench::measure("create+destroy", count, count * 2, [&] {
+            for (auto &entity : entities) {
+                entity = ecs->createEntity();
+            }
+            for (auto entity : entities) {
+                ecs->destroyEntity(entity);
+            }
+        });
+    }
+}
+
+GIM_BENCHMARK("ecs/add-remove-component") {
+    for (auto count : Sizes) {
+        auto ecs = makeWorld();
+        std::vector<Entity> entities(count);
+        for (auto &entity : entities) {
+            entity = ecs->createEntity();
+            ecs->emplace<Position>(entity);
+        }
+
+        gim::bench::measure("emplace+remove", count, count * 2, [&] {
+            for (auto entity : entities) {
+                ecs->emplace<Velocity>(entity);
+            }
+            for (auto entity : entities) {
+                ecs->removeComponent<Velocity>(entity);
+            }
+        });
+    }
+}
+
+GIM_BENCHMARK("ecs/iterate") {
+    for (auto count : Sizes) {
+        auto ecs = makeWorld();
+        populate(*ecs, count);
+
+        gim::bench::measure("view<Position>", count, count, [&] {
+            ecs->view<Position>().each(
+                [](Entity, Position &position) { position.x += 1.F; });
+        });
+
+        gim::bench::measure("view<Position, const Velocity>", count,
+                            count / 2, [&] {
+                                ecs->view<Position, const Velocity>().each(
+                                    [](Entity, Position &position,
+                                       const Velocity &velocity) {
+                                        position.x += velocity.x;
+                                        position.y += velocity.y;
+                                        position.z += velocity.z;
+                                    });
+                            });
+
+        gim::bench::measure("view<Position, Velocity, Health>", count,
+                            count / 6, [&] {
+                                ecs->view<Position, Velocity, Health>().each(
+                                    [](Entity, Position &position,
+                                       Velocity &velocity, Health &health) {
+                                        position.x += velocity.x;
+                                        health.value--;
+                                    });
+                            });
+    }
+}
+
+GIM_BENCHMARK("ecs/signature-match") {
+    Signature system;
+    system.set<Position>();
+    system.set<Velocity>();
+
+    for (auto count : Sizes) {
+        // A fixed seed, so every run matches the same signatures.
+        std::uint32_t state = 0x9E3779B9U;
+        std::vector<Signature> signatures(count);
+        for (auto &signature : signatures) {
+            state = state * 1664525U + 1013904223U;
+            for (ComponentTypeId type = 0; type < 8; type++) {
+                if (state >> (24 + type) & 1U) {
+                    signature.set(type);
+                }
+            }
+        }
+
+        gim::bench::measure("subsetOf", count, count, [&] {
+            std::size_t matched = 0;
+            for (auto const &signature : signatures) {
+                matched += system.subsetOf(signature) ? 1 : 0;
+            }
+            gim::bench::doNotOptimize(matched);
+        });
+    }
+}
+
+GIM_BENCHMARK("ecs/system-dispatch") {
+    {
+        auto ecs = makeWorld();
+        ecs->registerSystem<Idle<0>>();
+        ecs->registerSystem<Idle<1>>();
+        ecs->registerSystem<Idle<2>>();
+        ecs->registerSystem<Idle<3>>();
+        ecs->registerSystem<Idle<4>>();
+        ecs->registerSystem<Idle<5>>();
+        ecs->registerSystem<Idle<6>>();
+        ecs->registerSystem<Idle<7>>();
+
+        gim::bench::measure("update 8 idle systems", 0, 8,
+                            [&] { ecs->update(); });
+    }
+
+    for (auto count : Sizes) {
+        auto ecs = makeWorld();
+        ecs->registerSystem<Integrate>();
+        ecs->registerSystem<Decay>();
+        populate(*ecs, count);
+
+        gim::bench::measure("update integrate+decay", count, count,
+                            [&] { ecs->update(); });
+    }
+}
@@ -0,0 +1,42 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+/**
+ * Usage: gim-bench [filter] [--json results.json]
+ *
+ * Only the benchmarks whose name contains filter are run, --json writes
+ * every measurement to a file for comparing runs.
+ */
+auto main(int argc, char **argv) -> int {
+    std::string_view filter;
+    std::string json;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view argument = argv[i];
+
+        if (argument == "--json" && i + 1 < argc) {
+            json = argv[++i];
+        } else {
+            filter = argument;
+        }
+    }
+
+    for (auto const &[name, benchmark] : gim::bench::registry()) {
+        if (name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        fmt::print("\n# {}\n", name);
+        gim::bench::currentBenchmark() = name;
+        benchmark();
+    }
+
+    if (!json.empty() && !gim::bench::writeJson(json)) {
+        fmt::print(stderr, "Couldn't write results to {}\n", json);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
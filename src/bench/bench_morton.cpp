@@ -0,0 +1,101 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gim/library/jobs.hpp>
+#include <gim/library/morton.hpp>
+#include <gim/library/sort.hpp>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace gim::library;
+
+namespace {
+template <typename Key> auto randomKeys(std::size_t count) -> std::vector<Key> {
+    std::mt19937_64 random(42);
+    std::vector<Key> keys(count);
+    for (auto &key : keys) {
+        key = static_cast<Key>(random());
+    }
+    return keys;
+}
+
+template <typename Key> auto compareSorts(const char *width) -> void {
+    for (std::size_t count : {10'000U, 1'000'000U}) {
+        auto keys = randomKeys<Key>(count);
+        std::vector<Key> sorted(count);
+
+        gim::bench::measure(fmt::format("std::sort {}-bit", width), count,
+                            count, [&] {
+                                sorted = keys;
+                                std::sort(sorted.begin(), sorted.end());
+                                gim::bench::doNotOptimize(sorted.front());
+                            });
+
+        gim::bench::measure(fmt::format("radixSort {}-bit", width), count,
+                            count, [&] {
+                                sorted = keys;
+                                sort::radixSort(std::span(sorted));
+                                gim::bench::doNotOptimize(sorted.front());
+                            });
+
+        std::vector<std::uint32_t> values(count);
+        gim::bench::measure(
+            fmt::format("radixSort {}-bit with payload", width), count, count,
+            [&] {
+                sorted = keys;
+                sort::radixSort(std::span(sorted), std::span(values));
+                gim::bench::doNotOptimize(values.front());
+            });
+    }
+}
+} // namespace
+
+GIM_BENCHMARK("morton/encode-decode") {
+    constexpr std::size_t Count = 1'000'000;
+    auto coordinates = randomKeys<std::uint32_t>(Count * 3);
+    std::vector<std::uint64_t> codes(Count);
+
+    gim::bench::measure("shift and mask", Count, Count, [&] {
+        for (std::size_t i = 0; i < Count; i++) {
+            codes[i] = morton::spread(coordinates[3 * i]) |
+                       morton::spread(coordinates[3 * i + 1]) << 1U |
+                       morton::spread(coordinates[3 * i + 2]) << 2U;
+        }
+        gim::bench::doNotOptimize(codes.back());
+    });
+
+    gim::bench::measure("encode tables", Count, Count, [&] {
+        for (std::size_t i = 0; i < Count; i++) {
+            codes[i] = morton::detail::encodeTable(coordinates[3 * i],
+                                                   coordinates[3 * i + 1],
+                                                   coordinates[3 * i + 2]);
+        }
+        gim::bench::doNotOptimize(codes.back());
+    });
+
+    gim::bench::measure(morton::usesBmi2() ? "encode (pdep)" : "encode (tables)",
+                        Count, Count, [&] {
+                            for (std::size_t i = 0; i < Count; i++) {
+                                codes[i] = morton::encode(
+                                    coordinates[3 * i], coordinates[3 * i + 1],
+                                    coordinates[3 * i + 2]);
+                            }
+                            gim::bench::doNotOptimize(codes.back());
+                        });
+
+    gim::bench::measure(morton::usesBmi2() ? "decode (pext)" : "decode (tables)",
+                        Count, Count, [&] {
+                            std::uint32_t total = 0;
+                            for (auto code : codes) {
+                                auto [x, y, z] = morton::decode(code);
+                                total += x + y + z;
+                            }
+                            gim::bench::doNotOptimize(total);
+                        });
+}
+
+GIM_BENCHMARK("sort/radix-vs-std") {
+    compareSorts<std::uint32_t>("32");
+    compareSorts<std::uint64_t>("64");
+}
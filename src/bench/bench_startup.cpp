@@ -0,0 +1,35 @@
+#include "bench.hpp"
+#include <gim/ecs/ecs.hpp>
+#include <gim/ecs/engine/entity_manager.hpp>
+#include <memory>
+
+using namespace gim::ecs;
+
+// What the engine pays before the first frame: constructing the ECS should
+// not depend on how many entities could exist, only on how many do.
+GIM_BENCHMARK("startup/ecs") {
+    gim::bench::measure("construct ECS", 0, 1, [] {
+        auto ecs = std::make_unique<ECS>();
+        gim::bench::doNotOptimize(ecs.get());
+    });
+
+    for (std::size_t count : {1'000U, 100'000U, 1'000'000U}) {
+        gim::bench::measure("create entities", count, count, [&] {
+            EntityManager entities;
+            for (std::size_t i = 0; i < count; i++) {
+                gim::bench::doNotOptimize(entities.createEntity());
+            }
+        });
+
+        gim::bench::measure("create and recycle entities", count, count, [&] {
+            EntityManager entities;
+            for (std::size_t i = 0; i < count; i++) {
+                auto entity = entities.createEntity();
+                if (i % 2 == 0) {
+                    entities.destroyEntity(entity);
+                }
+            }
+            gim::bench::doNotOptimize(entities.size());
+        });
+    }
+}
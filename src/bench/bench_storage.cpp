@@ -0,0 +1,170 @@
+#include "bench.hpp"
+#include <gim/ecs/engine/archetype_manager.hpp>
+#include <gim/ecs/engine/component_manager.hpp>
+#include <numeric>
+#include <span>
+#include <vector>
+
+using namespace gim::ecs;
+
+namespace {
+struct Position {
+    static constexpr auto storage = Storage::Value;
+    float x = 0.F, y = 0.F, z = 0.F;
+};
+
+struct Velocity {
+    static constexpr auto storage = Storage::Value;
+    float x = 1.F, y = 1.F, z = 1.F;
+};
+
+struct Health {
+    static constexpr auto storage = Storage::Value;
+    int value = 100;
+};
+
+// The same data as Position without a declared storage, so it is stored as
+// Pod.
+struct PodPosition {
+    float x = 0.F, y = 0.F, z = 0.F;
+};
+
+template <typename Manager> auto populate(Manager &manager, Entity count) {
+    manager.template registerComponent<Position>();
+    manager.template registerComponent<Velocity>();
+    manager.template registerComponent<Health>();
+
+    for (Entity entity = 0; entity < count; entity++) {
+        manager.template emplace<Position>(entity);
+        manager.template emplace<Velocity>(entity);
+        // Spread entities over a few archetypes like a real world would.
+        if (entity % 3 == 0) {
+            manager.template emplace<Health>(entity);
+        }
+    }
+}
+} // namespace
+
+GIM_BENCHMARK("storage/iterate-position-velocity") {
+    for (Entity count : {1'000U, 100'000U}) {
+        SparseComponentManager sparse;
+        populate(sparse, count);
+        std::vector<Entity> entities(count);
+        std::iota(entities.begin(), entities.end(), 0);
+
+        // What systems do with per-type arrays, walk their entity list and
+        // look every component type up per entity.
+        gim::bench::measure("sparse per-type arrays", count, count, [&] {
+            for (auto entity : entities) {
+                auto &position = sparse.get<Position>(entity);
+                auto &velocity = sparse.get<Velocity>(entity);
+                position.x += velocity.x;
+                position.y += velocity.y;
+                position.z += velocity.z;
+            }
+            gim::bench::doNotOptimize(sparse.get<Position>(0));
+        });
+
+        gim::bench::measure("sparse view", count, count, [&] {
+            sparse.each<Position, const Velocity>(
+                [](Entity, Position &position, const Velocity &velocity) {
+                    position.x += velocity.x;
+                    position.y += velocity.y;
+                    position.z += velocity.z;
+                });
+            gim::bench::doNotOptimize(sparse.get<Position>(0));
+        });
+
+        ArchetypeComponentManager archetypes;
+        populate(archetypes, count);
+        gim::bench::measure("archetype chunks", count, count, [&] {
+            archetypes.each<Position, Velocity>(
+                [](Entity, Position &position, Velocity &velocity) {
+                    position.x += velocity.x;
+                    position.y += velocity.y;
+                    position.z += velocity.z;
+                });
+            gim::bench::doNotOptimize(archetypes.get<Position>(0));
+        });
+    }
+}
+
+GIM_BENCHMARK("storage/random-access-three-components") {
+    for (Entity count : {1'000U, 100'000U}) {
+        SparseComponentManager sparse;
+        populate(sparse, count);
+        gim::bench::measure("sparse get<T> x3", count, count / 3, [&] {
+            int total = 0;
+            for (Entity entity = 0; entity < count; entity += 3) {
+                total += sparse.get<Health>(entity).value;
+                total += static_cast<int>(sparse.get<Position>(entity).x);
+                total += static_cast<int>(sparse.get<Velocity>(entity).x);
+            }
+            gim::bench::doNotOptimize(total);
+        });
+
+        ArchetypeComponentManager archetypes;
+        populate(archetypes, count);
+        gim::bench::measure("archetype get<T> x3", count, count / 3, [&] {
+            int total = 0;
+            for (Entity entity = 0; entity < count; entity += 3) {
+                total += archetypes.get<Health>(entity).value;
+                total += static_cast<int>(archetypes.get<Position>(entity).x);
+                total += static_cast<int>(archetypes.get<Velocity>(entity).x);
+            }
+            gim::bench::doNotOptimize(total);
+        });
+    }
+}
+
+GIM_BENCHMARK("storage/add-remove-component") {
+    for (Entity count : {1'000U, 100'000U}) {
+        SparseComponentManager sparse;
+        populate(sparse, count);
+        gim::bench::measure("sparse add+remove", count, count, [&] {
+            for (Entity entity = 0; entity < count; entity++) {
+                sparse.removeComponent<Velocity>(entity);
+                sparse.emplace<Velocity>(entity);
+            }
+        });
+
+        ArchetypeComponentManager archetypes;
+        populate(archetypes, count);
+        gim::bench::measure("archetype add+remove", count, count, [&] {
+            for (Entity entity = 0; entity < count; entity++) {
+                archetypes.removeComponent<Velocity>(entity);
+                archetypes.emplace<Velocity>(entity);
+            }
+        });
+    }
+}
+
+GIM_BENCHMARK("storage/pod-vs-value-insert") {
+    for (Entity count : {1'000U, 100'000U}) {
+        std::vector<Entity> entities(count);
+        std::iota(entities.begin(), entities.end(), 0);
+        std::vector<PodPosition> positions(count);
+
+        gim::bench::measure("value emplace", count, count, [&] {
+            ComponentArray<Position> array;
+            for (auto entity : entities) {
+                array.emplace(entity);
+            }
+            gim::bench::doNotOptimize(array.size());
+        });
+
+        gim::bench::measure("pod emplace", count, count, [&] {
+            ComponentArray<PodPosition> array;
+            for (auto entity : entities) {
+                array.emplace(entity);
+            }
+            gim::bench::doNotOptimize(array.size());
+        });
+
+        gim::bench::measure("pod insertBulk", count, count, [&] {
+            ComponentArray<PodPosition> array;
+            array.insertBulk(entities, positions, 1);
+            gim::bench::doNotOptimize(array.size());
+        });
+    }
+}
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <cmath>
+#include <gim/ecs/systems/camera.hpp>
+
+namespace gim::ecs::systems {
+auto CameraSystem::getSignature() -> std::shared_ptr<Signature> {
+    // The camera is a resource, the system doesn't iterate entities.
+    return std::make_shared<Signature>();
+}
+
+auto CameraSystem::update() -> void {
+    auto const &time = resource<const gim::library::loop::FrameTime>();
+    auto const &input = resource<const gim::ecs::components::Input::State>();
+    auto const &current =
+        resource<const gim::ecs::components::Camera::Component>();
+
+    auto held = [&](char key) { return input.isHeld(key) ? 1.F : 0.F; };
+    glm::vec2 movement(held('d') - held('a'), held('w') - held('s'));
+    bool looking = input.mouseX != 0.F || input.mouseY != 0.F;
+
+    // Standing still, leave the camera unchanged so the renderer doesn't
+    // rebuild its UBO.
+    if (movement == glm::vec2(0.F) && !looking && !current.moving()) {
+        return;
+    }
+
+    auto &camera = resource<gim::ecs::components::Camera::Component>();
+    camera.previousPosition = camera.position;
+    camera.movement = movement;
+
+    if (looking) {
+        camera.yaw += input.mouseX * camera.sensitivity;
+        // Screen y grows downwards.
+        camera.pitch -= input.mouseY * camera.sensitivity;
+        // Clamp pitch to prevent flipping.
+        camera.pitch = std::clamp(camera.pitch, -89.F, 89.F);
+
+        glm::vec3 front;
+        front.x = cos(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch));
+        front.y = sin(glm::radians(camera.pitch));
+        front.z = sin(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch));
+        camera.front = glm::normalize(front);
+    }
+
+    auto right = glm::normalize(glm::cross(camera.front, camera.up));
+    auto step = camera.speed * static_cast<float>(time.delta);
+    camera.position += camera.front * camera.movement.y * step;
+    camera.position += right * camera.movement.x * step;
+}
+
+auto CameraSystem::setComponentManager(
+    std::shared_ptr<ComponentManager> componentManager) -> void {
+    this->componentManager = std::move(componentManager);
+}
+
+auto CameraSystem::getComponentManager() -> std::shared_ptr<ComponentManager> {
+    return componentManager;
+}
+} // namespace gim::ecs::systems
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <gim/ecs/systems/input.hpp>
+
+namespace gim::ecs::systems {
+namespace Input = gim::ecs::components::Input;
+
+auto InputSystem::getSignature() -> std::shared_ptr<Signature> {
+    // Input lives in resources, the system doesn't iterate entities.
+    return std::make_shared<Signature>();
+}
+
+auto InputSystem::update() -> void {
+    auto &events = resource<Events<Input::Event>>();
+    auto &state = resource<Input::State>();
+    events.clear();
+    state.mouseX = 0.F;
+    state.mouseY = 0.F;
+    state.latency = 0;
+
+    auto now = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+
+    resource<Input::Queue>().drain([&](Input::Event event) {
+        switch (event.type) {
+        case Input::KeyDown:
+            if (!state.isHeld(event.key)) {
+                state.held.push_back(event.key);
+            }
+            break;
+        case Input::KeyUp:
+            std::erase(state.held, event.key);
+            break;
+        case Input::MouseMotion:
+            state.mouseX += event.x;
+            state.mouseY += event.y;
+            break;
+        case Input::Quit:
+            resource<gim::ecs::components::EngineState::Component>().state =
+                gim::ecs::components::EngineState::Quitting;
+            break;
+        }
+
+        if (now > event.timestamp) {
+            state.latency = std::max(state.latency, now - event.timestamp);
+        }
+        events.send(event);
+    });
+}
+
+auto InputSystem::setComponentManager(
+    std::shared_ptr<ComponentManager> componentManager) -> void {
+    this->componentManager = std::move(componentManager);
+}
+
+auto InputSystem::getComponentManager() -> std::shared_ptr<ComponentManager> {
+    return componentManager;
+}
+} // namespace gim::ecs::systems
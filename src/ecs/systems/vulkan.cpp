@@ -1,4 +1,5 @@
 #include <gim/ecs/systems/vulkan.hpp>
+#include <gim/library/profiler.hpp>
 
 namespace gim::ecs::systems {
 VulkanRendererSystem::VulkanRendererSystem() {
@@ -9,89 +10,22 @@ VulkanRendererSystem::~VulkanRendererSystem() { instance.destroy(); }
 
 auto VulkanRendererSystem::getSignature() -> std::shared_ptr<Signature> {
     auto signature = std::make_shared<Signature>();
-    signature->set<gim::ecs::components::Camera::Component>();
-    signature->set<gim::ecs::components::EngineState::Component>();
     signature->set<gim::ecs::components::Shader::ShaderBuilder>();
 
     return signature;
 }
 
-auto VulkanRendererSystem::processInput(SDL_Event &event) -> void {
-    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-        if (event.key.keysym.sym == SDLK_w)
-            camera->position += camera->speed * camera->front;
-        if (event.key.keysym.sym == SDLK_s)
-            camera->position -= camera->speed * camera->front;
-        if (event.key.keysym.sym == SDLK_a)
-            camera->position -=
-                glm::normalize(glm::cross(camera->front, camera->up)) *
-                camera->speed;
-        if (event.key.keysym.sym == SDLK_d)
-            camera->position +=
-                glm::normalize(glm::cross(camera->front, camera->up)) *
-                camera->speed;
-    }
-}
-
-auto VulkanRendererSystem::handleMouseMotion(SDL_Event &event) -> void {
-    // Update cameraYaw and cameraPitch based on mouse movement
-    if (event.type == SDL_MOUSEMOTION) {
-        float xoffset = event.motion.xrel * camera->sensitivity;
-        float yoffset = -event.motion.yrel *
-                        camera->sensitivity; // y-coordinates are reversed
-
-        std::cout << "X offset: " << xoffset << " y offset: " << yoffset
-                  << std::endl;
-        camera->yaw += xoffset;
-        camera->pitch += yoffset;
-
-        // Clamp pitch to prevent flipping
-        if (camera->pitch > 89.0f)
-            camera->pitch = 89.0f;
-        if (camera->pitch < -89.0f)
-            camera->pitch = -89.0f;
-
-        glm::vec3 front;
-        front.x =
-            cos(glm::radians(camera->yaw)) * cos(glm::radians(camera->pitch));
-        front.y = sin(glm::radians(camera->pitch));
-        front.z =
-            sin(glm::radians(camera->yaw)) * cos(glm::radians(camera->pitch));
-        camera->front = glm::normalize(front);
-    }
-}
-
 auto VulkanRendererSystem::update() -> void {
-    auto engineStatePair = componentManager->getTComponentWithEntity<
-        gim::ecs::components::EngineState::Component>(getEntities());
-    auto triangleShaderPair = componentManager->getTComponentWithEntity<
-        gim::ecs::components::Shader::ShaderBuilder>(getEntities());
-    auto cameraPair =
-        componentManager
-            ->getTComponentWithEntity<gim::ecs::components::Camera::Component>(
-                getEntities());
-
-    if (!engineStatePair.has_value()) {
-        std::cout << "Engine state component not found!" << std::endl;
-        return;
-    }
+    auto triangleShaders =
+        componentManager->view<gim::ecs::components::Shader::ShaderBuilder>();
 
-    if (!triangleShaderPair.has_value()) {
+    if (triangleShaders.empty()) {
         std::cout << "Triangle shader not found!" << std::endl;
         return;
     }
 
-    if (!cameraPair.has_value()) {
-        std::cout << "Camera not found!" << std::endl;
-        return;
-    }
-
-    auto [_e, engineState] = engineStatePair.value();
-    auto [_t, triangleShaderComponent] = triangleShaderPair.value();
-    auto [_c, cameraComponent] = cameraPair.value();
-
-    shaderBuilder = triangleShaderComponent;
-    camera = cameraComponent;
+    auto [_t, triangleShaderComponent] = *triangleShaders.begin();
+    shaderBuilder = &triangleShaderComponent;
 
     if (!readyToFinishInitialization) {
         readyToFinishInitialization = true;
@@ -99,37 +33,22 @@ auto VulkanRendererSystem::update() -> void {
         finishCreatingGraphicsPipeline();
     }
 
-    SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        if (event.type == SDL_QUIT) {
-            engineState->state = gim::ecs::components::EngineState::Quitting;
-            return;
-        } else if (event.type == SDL_WINDOWEVENT &&
-                   event.window.event == SDL_WINDOWEVENT_RESIZED) {
-        }
-
-        processInput(event);
-        handleMouseMotion(event);
+    // The shader holds the camera's UBO, so it only needs rewriting when the
+    // camera changed since the last frame, or is moving and drawn at a new
+    // point between two simulation steps.
+    auto const &camera = resource<const components::Camera::Component>();
+    if (resourceChanged<components::Camera::Component>() || camera.moving()) {
+        auto alpha = resource<const gim::library::loop::FrameTime>().alpha;
+        resource<components::Camera::Component>().updateShaderUBO(
+            static_cast<float>(alpha));
     }
 
     drawFrame();
 }
 
-auto VulkanRendererSystem::insertEntity(Entity entity) -> void {
-    entities.push_back(entity);
-}
-
-auto VulkanRendererSystem::removeEntity(Entity entity) -> void {
-    entities.erase(std::remove(entities.begin(), entities.end(), entity),
-                   entities.end());
-}
-
-auto VulkanRendererSystem::getEntities() -> std::vector<Entity> const & {
-    return entities;
-}
 auto VulkanRendererSystem::setComponentManager(
     std::shared_ptr<ComponentManager> componentManager) -> void {
-    componentManager = componentManager;
+    this->componentManager = std::move(componentManager);
 }
 auto VulkanRendererSystem::getComponentManager()
     -> std::shared_ptr<ComponentManager> {
@@ -486,16 +405,25 @@ auto VulkanRendererSystem::recreate_swapchain() -> auto {
 }
 
 auto VulkanRendererSystem::drawFrame() -> void {
-    vkWaitForFences(
-        instance.device, 1,
-        &instance.data.in_flight_fences[instance.data.current_frame], VK_TRUE,
-        UINT64_MAX);
+    GIM_PROFILE_ZONE("drawFrame");
+
+    {
+        GIM_PROFILE_ZONE("wait in flight fence");
+        vkWaitForFences(
+            instance.device, 1,
+            &instance.data.in_flight_fences[instance.data.current_frame],
+            VK_TRUE, UINT64_MAX);
+    }
 
     uint32_t image_index = 0;
-    VkResult result = vkAcquireNextImageKHR(
-        instance.device, instance.swapchain, UINT64_MAX,
-        instance.data.available_semaphores[instance.data.current_frame],
-        VK_NULL_HANDLE, &image_index);
+    VkResult result = VK_SUCCESS;
+    {
+        GIM_PROFILE_ZONE("vkAcquireNextImageKHR");
+        result = vkAcquireNextImageKHR(
+            instance.device, instance.swapchain, UINT64_MAX,
+            instance.data.available_semaphores[instance.data.current_frame],
+            VK_NULL_HANDLE, &image_index);
+    }
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreate_swapchain();
@@ -506,6 +434,7 @@ auto VulkanRendererSystem::drawFrame() -> void {
     }
 
     if (instance.data.image_in_flight[image_index] != VK_NULL_HANDLE) {
+        GIM_PROFILE_ZONE("wait image fence");
         vkWaitForFences(instance.device, 1,
                         &instance.data.image_in_flight[image_index], VK_TRUE,
                         UINT64_MAX);
@@ -535,11 +464,14 @@ auto VulkanRendererSystem::drawFrame() -> void {
     vkResetFences(instance.device, 1,
                   &instance.data.in_flight_fences[instance.data.current_frame]);
 
-    if (vkQueueSubmit(
-            instance.data.graphics_queue, 1, &submitInfo,
-            instance.data.in_flight_fences[instance.data.current_frame]) !=
-        VK_SUCCESS) {
-        std::cout << "failed to submit draw command buffer\n";
+    {
+        GIM_PROFILE_ZONE("vkQueueSubmit");
+        if (vkQueueSubmit(
+                instance.data.graphics_queue, 1, &submitInfo,
+                instance.data.in_flight_fences[instance.data.current_frame]) !=
+            VK_SUCCESS) {
+            std::cout << "failed to submit draw command buffer\n";
+        }
     }
 
     VkPresentInfoKHR present_info = {};
@@ -554,7 +486,10 @@ auto VulkanRendererSystem::drawFrame() -> void {
 
     present_info.pImageIndices = &image_index;
 
-    result = vkQueuePresentKHR(instance.data.present_queue, &present_info);
+    {
+        GIM_PROFILE_ZONE("vkQueuePresentKHR");
+        result = vkQueuePresentKHR(instance.data.present_queue, &present_info);
+    }
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
         return recreate_swapchain();
     } else if (result != VK_SUCCESS) {
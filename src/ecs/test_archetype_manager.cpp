@@ -0,0 +1,104 @@
+#include "gim/ecs/engine/archetype_manager.hpp"
+#include "gim/ecs/engine/testing.hpp"
+#include <doctest/doctest.h>
+#include <memory>
+
+using namespace gim::ecs;
+
+namespace {
+// Plain data, so it gets a Pod column.
+struct Position {
+	float x = 0.F;
+	float y = 0.F;
+};
+} // namespace
+
+TEST_CASE("archetype-manager") {
+	ArchetypeComponentManager am;
+	am.registerComponent<Position>();
+	am.registerComponent<TESTING::TestValueComponent>();
+	am.registerComponent<TESTING::TestComponent>();
+
+	// Enough entities to spill over several chunks.
+	const Entity count = 5000;
+	for (Entity entity = 0; entity < count; entity++) {
+		am.emplace<Position>(entity, static_cast<float>(entity), 0.F);
+		if (entity % 2 == 0) {
+			am.emplace<TESTING::TestValueComponent>(
+				entity, static_cast<int>(entity));
+		}
+	}
+	am.addComponent(3, std::make_shared<TESTING::TestComponent>(33));
+
+	CHECK(am.get<Position>(10).x == 10.F);
+	CHECK(am.get<TESTING::TestValueComponent>(10).x == 10);
+	CHECK_FALSE(am.hasComponent<TESTING::TestValueComponent>(11));
+	CHECK(am.getComponent<TESTING::TestComponent>(3)->x == 33);
+	CHECK(am.getComponent<TESTING::TestComponent>(4) == nullptr);
+
+	// Only entities with every requested component are visited.
+	std::size_t visited = 0;
+	am.each<Position, TESTING::TestValueComponent>(
+		[&](Entity entity, Position &position,
+			TESTING::TestValueComponent &value) {
+			CHECK(position.x == static_cast<float>(entity));
+			CHECK(value.x == static_cast<int>(entity));
+			position.y = 1.F;
+			visited++;
+		});
+	CHECK(visited == count / 2);
+	CHECK(am.get<Position>(0).y == 1.F);
+	CHECK(am.get<Position>(1).y == 0.F);
+
+	// Removing a component moves the entity, keeping its other components.
+	am.removeComponent<TESTING::TestValueComponent>(10);
+	CHECK_FALSE(am.hasComponent<TESTING::TestValueComponent>(10));
+	CHECK(am.get<Position>(10).x == 10.F);
+	CHECK(am.get<TESTING::TestValueComponent>(4998).x == 4998);
+
+	am.entityDestroyed(4998);
+	CHECK_FALSE(am.hasComponent<Position>(4998));
+	CHECK(am.get<Position>(4996).x == 4996.F);
+
+	visited = 0;
+	am.each<Position>([&](Entity, Position &) { visited++; });
+	CHECK(visited == count - 1);
+	CHECK_THROWS(am.get<TESTING::TestValueComponent>(11));
+}
+
+TEST_CASE("archetype-chunk-boundary") {
+	auto type = componentTypeId<Position>();
+	Signature signature;
+	signature.set(type);
+	Archetype archetype(signature, {ColumnType::ofPod<Position>(type)});
+	auto capacity = archetype.chunkCapacity();
+
+	// One row past the first chunk, then back: the spare chunk is kept but
+	// holds no rows.
+	for (Entity entity = 0; entity <= capacity; entity++) {
+		archetype.allocate(entity);
+	}
+	CHECK(archetype.chunkCount() == 2);
+	CHECK(archetype.chunkSize(1) == 1);
+	archetype.release(capacity);
+	CHECK(archetype.chunkCount() == 1);
+	CHECK(archetype.chunkSize(0) == capacity);
+
+	// Iterating right after crossing back only visits live rows.
+	ArchetypeComponentManager am;
+	am.registerComponent<Position>();
+	for (Entity entity = 0; entity <= capacity; entity++) {
+		am.emplace<Position>(entity, static_cast<float>(entity), 1.F);
+	}
+	am.removeComponent<Position>(static_cast<Entity>(capacity));
+
+	std::size_t visited = 0;
+	bool live = true;
+	am.each<Position>([&](Entity entity, Position &position) {
+		live = live && entity < capacity &&
+			   position.x == static_cast<float>(entity) && position.y == 1.F;
+		visited++;
+	});
+	CHECK(visited == capacity);
+	CHECK(live);
+}
@@ -0,0 +1,186 @@
+#include <cstddef>
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <gim/ecs/ecs.hpp>
+#include <gim/library/arena.hpp>
+#include <gim/library/jobs.hpp>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+using namespace gim::library::memory;
+
+namespace {
+// Counts what the arena asks the heap for.
+class CountingResource : public std::pmr::memory_resource {
+  public:
+	std::size_t allocations = 0;
+	std::size_t deallocations = 0;
+
+  protected:
+	auto do_allocate(std::size_t bytes, std::size_t alignment)
+		-> void * override {
+		allocations++;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	auto do_deallocate(void *pointer, std::size_t bytes, std::size_t alignment)
+		-> void override {
+		deallocations++;
+		std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+	}
+
+	[[nodiscard]] auto do_is_equal(std::pmr::memory_resource const &other)
+		const noexcept -> bool override {
+		return this == &other;
+	}
+};
+
+// The queries hand out shared pointers, so opt out of value storage.
+struct Position {
+	static constexpr auto storage = gim::ecs::Storage::Shared;
+	float x = 0.F;
+};
+} // namespace
+
+TEST_CASE("frame-arena") {
+	CountingResource heap;
+	FrameArena arena(1024, &heap);
+
+	auto *a = arena.allocate(3, 1);
+	auto *b = arena.allocate(8, 8);
+	auto *c = arena.allocate(16, 64);
+
+	CHECK(reinterpret_cast<std::uintptr_t>(b) % 8 == 0);
+	CHECK(reinterpret_cast<std::uintptr_t>(c) % 64 == 0);
+	CHECK(static_cast<std::byte *>(b) >= static_cast<std::byte *>(a) + 3);
+	CHECK(heap.allocations == 1);
+
+	auto stats = arena.getStats();
+	CHECK(stats.allocations == 3);
+	CHECK(stats.bytes == 27);
+	CHECK(stats.upstreamAllocations == 1);
+}
+
+TEST_CASE("frame-arena-reset") {
+	CountingResource heap;
+	FrameArena arena(1024, &heap);
+
+	auto *first = arena.allocate(64, 16);
+	arena.reset();
+	CHECK(arena.allocate(64, 16) == first);
+	CHECK(heap.allocations == 1);
+}
+
+TEST_CASE("frame-arena-coalesce") {
+	CountingResource heap;
+	FrameArena arena(256, &heap);
+
+	auto frame = [&] {
+		std::pmr::vector<int> scratch(&arena);
+		for (int i = 0; i < 1000; i++) {
+			scratch.push_back(i);
+		}
+		CHECK(scratch[999] == 999);
+	};
+
+	// The first frame chains blocks, the reset swaps them for a single one.
+	frame();
+	CHECK(heap.allocations > 1);
+	arena.reset();
+	CHECK(heap.deallocations == heap.allocations);
+	frame();
+	arena.reset();
+
+	auto warm = heap.allocations;
+	for (int i = 0; i < 10; i++) {
+		frame();
+		arena.reset();
+	}
+	CHECK(heap.allocations == warm);
+	CHECK(arena.getStats().peakBytes > 1000 * sizeof(int));
+}
+
+TEST_CASE("frame-arena-release") {
+	CountingResource heap;
+	{
+		FrameArena arena(64, &heap);
+		CHECK(arena.allocate(100, 8) != nullptr);
+		CHECK(arena.allocate(100, 8) != nullptr);
+	}
+	CHECK(heap.allocations == 2);
+	CHECK(heap.deallocations == 2);
+}
+
+TEST_CASE("frame-arenas") {
+	gim::library::jobs::JobSystem jobs(3);
+	FrameArenas arenas(jobs);
+
+	jobs.parallelFor(64, 1, [&](std::size_t begin, std::size_t end) {
+		std::pmr::vector<std::size_t> scratch(&arenas.local());
+		for (auto i = begin; i < end; i++) {
+			scratch.push_back(i);
+		}
+	});
+
+	auto stats = arenas.getStats();
+	CHECK(stats.allocations >= 64);
+	CHECK(stats.upstreamAllocations >= 1);
+	CHECK(stats.upstreamAllocations <= jobs.concurrency());
+
+	arenas.reset();
+	arenas.resetStats();
+	CHECK(arenas.getStats().allocations == 0);
+}
+
+TEST_CASE("frame-arenas-outside-threads") {
+	gim::library::jobs::JobSystem jobs(1);
+	FrameArenas arenas(jobs);
+	auto *main = &arenas.local();
+
+	// Threads outside the pool don't share the main thread's arena.
+	FrameArena *first = nullptr;
+	FrameArena *again = nullptr;
+	void *allocated = nullptr;
+	std::thread outside([&] {
+		first = &arenas.local();
+		again = &arenas.local();
+		allocated = first->allocate(16, 8);
+	});
+	outside.join();
+	CHECK(allocated != nullptr);
+
+	CHECK(first != main);
+	CHECK(first == again);
+	CHECK(arenas.getStats().allocations == 1);
+	arenas.reset();
+}
+
+TEST_CASE("component-manager-frame-arena-queries") {
+	gim::ecs::ComponentManager cm;
+	cm.registerComponent<Position>();
+
+	std::vector<gim::ecs::Entity> entities;
+	for (gim::ecs::Entity entity = 0; entity < 8; entity++) {
+		if (entity % 2 == 0) {
+			cm.addComponent(entity, std::make_shared<Position>());
+		}
+		entities.push_back(entity);
+	}
+
+	FrameArena arena;
+	auto found = cm.getAllTComponentsAndEntities<Position>(entities, &arena);
+	CHECK(found.size() == 4);
+	CHECK(found.get_allocator().resource() == &arena);
+	CHECK(arena.getStats().allocations >= 1);
+}
+
+TEST_CASE("ECS-update-resets-frame-arenas") {
+	gim::ecs::ECS ecs;
+	auto &arena = frameArena();
+
+	auto *before = arena.allocate(32, 16);
+	ecs.update();
+	CHECK(arena.allocate(32, 16) == before);
+}
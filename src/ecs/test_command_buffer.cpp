@@ -0,0 +1,143 @@
+#include "gim/ecs/engine/command_buffer.hpp"
+#include "gim/ecs/engine/testing.hpp"
+#include <doctest/doctest.h>
+#include <gim/ecs/ecs.hpp>
+#include <memory>
+#include <vector>
+
+using namespace gim::ecs;
+
+TEST_CASE("command-buffer") {
+	auto ecs = ECS();
+	ecs.registerSystem<TESTING::TestSystem>();
+	ecs.registerComponent<TESTING::TestComponent>();
+	ecs.registerComponent<TESTING::TestValueComponent>();
+
+	auto existing = ecs.createEntity();
+	ecs.emplace<TESTING::TestValueComponent>(existing, 1);
+
+	auto created = ecs.commands().create();
+	ecs.commands().emplace<TESTING::TestComponent>(created, 7);
+	ecs.commands().removeComponent<TESTING::TestValueComponent>(existing);
+	ecs.commands().emplace<TESTING::TestValueComponent>(existing, 2);
+
+	// Nothing changes until the buffer is applied.
+	CHECK(ecs.get<TESTING::TestValueComponent>(existing).x == 1);
+	CHECK(!ecs.commands().empty());
+
+	ecs.flush();
+	CHECK(ecs.commands().empty());
+	CHECK(ecs.get<TESTING::TestValueComponent>(existing).x == 2);
+
+	int count = 0;
+	Entity entity = 0;
+	ecs.view<TESTING::TestComponent>().each(
+		[&](Entity found, TESTING::TestComponent &component) {
+			CHECK(component.x == 7);
+			entity = found;
+			count++;
+		});
+	CHECK(count == 1);
+
+	// Commands after a destroy are dropped.
+	ecs.commands().destroy(entity);
+	ecs.commands().emplace<TESTING::TestValueComponent>(entity, 3);
+	ecs.flush();
+	CHECK(!ecs.hasComponent<TESTING::TestComponent>(entity));
+	CHECK(!ecs.hasComponent<TESTING::TestValueComponent>(entity));
+}
+
+TEST_CASE("command-buffer-parallel") {
+	auto ecs = ECS();
+	ecs.registerSystem<TESTING::TestSystem>();
+	ecs.registerComponent<TESTING::TestComponent>();
+	ecs.registerComponent<TESTING::TestValueComponent>();
+
+	constexpr int count = 4'000;
+	for (int i = 0; i < count; i++) {
+		ecs.emplace<TESTING::TestValueComponent>(ecs.createEntity(), i);
+	}
+
+	// Structural changes recorded from inside a parallel loop, half of the
+	// entities get a component and each of them spawns a new entity.
+	ecs.view<const TESTING::TestValueComponent>().parallelEach(
+		[&](Entity entity, const TESTING::TestValueComponent &value) {
+			if (value.x % 2 == 0) {
+				ecs.commands().removeComponent<TESTING::TestValueComponent>(
+					entity);
+				ecs.commands().emplace<TESTING::TestComponent>(entity, value.x);
+
+				auto spawned = ecs.commands().create();
+				ecs.commands().emplace<TESTING::TestComponent>(spawned, -1);
+			}
+		});
+	ecs.flush();
+
+	int moved = 0;
+	int spawned = 0;
+	ecs.view<const TESTING::TestComponent>().each(
+		[&](Entity, const TESTING::TestComponent &component) {
+			component.x == -1 ? spawned++ : moved++;
+		});
+	CHECK(moved == count / 2);
+	CHECK(spawned == count / 2);
+
+	ecs.update();
+	ecs.view<const TESTING::TestComponent>().each(
+		[&](Entity, const TESTING::TestComponent &component) {
+			CHECK((component.x == 0 || component.x % 2 == 1));
+		});
+}
+
+namespace {
+// Never registered, so adding it throws when the commands are applied.
+struct UnregisteredComponent {
+	static constexpr auto storage = Storage::Value;
+
+	int x = 0;
+};
+
+// Records what apply tells the systems.
+struct Notified {
+	std::vector<Entity> changed;
+	std::vector<Signature> signatures;
+
+	auto entitySignatureChanged(Entity entity, Signature const &signature,
+								Signature const &) -> void {
+		changed.push_back(entity);
+		signatures.push_back(signature);
+	}
+
+	auto entityDestroyed(Entity) -> void {}
+};
+} // namespace
+
+TEST_CASE("command-buffer-throwing-command") {
+	EntityManager entities;
+	ComponentManager components;
+	components.registerComponent<TESTING::TestValueComponent>();
+	CommandBuffer commands;
+	Notified systems;
+
+	auto entity = entities.createEntity();
+	commands.emplace<TESTING::TestValueComponent>(entity, 1);
+	commands.emplace<UnregisteredComponent>(entity, 2);
+	commands.emplace<TESTING::TestValueComponent>(commands.create(), 3);
+
+	CHECK_THROWS(commands.apply(entities, components, systems));
+
+	// Nothing is left to be applied a second time.
+	CHECK(commands.empty());
+
+	// The component added before the throw is there, in the signature and
+	// the systems were told about it.
+	REQUIRE(systems.changed.size() == 1);
+	CHECK(systems.changed[0] == entity);
+	CHECK(systems.signatures[0].get<TESTING::TestValueComponent>());
+	CHECK(!systems.signatures[0].get<UnregisteredComponent>());
+	CHECK(entities.getSignature(entity)->get<TESTING::TestValueComponent>());
+	CHECK(components.hasComponent<TESTING::TestValueComponent>(entity));
+
+	commands.apply(entities, components, systems);
+	CHECK(systems.changed.size() == 1);
+}
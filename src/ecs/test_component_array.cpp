@@ -1,7 +1,9 @@
 #include "gim/ecs/engine/component_array.hpp"
 #include "gim/ecs/engine/testing.hpp"
+#include <cstdint>
 #include <doctest/doctest.h>
 #include <memory>
+#include <vector>
 
 using namespace gim::ecs;
 
@@ -18,3 +20,122 @@ TEST_CASE("component-array") {
 	componentArray->removeData(entity);
 	CHECK(componentArray->getData(entity) == nullptr);
 }
+
+TEST_CASE("component-array-swap-and-pop") {
+	ComponentArray<TESTING::TestComponent> componentArray;
+
+	for (Entity entity = 0; entity < 4; entity++) {
+		componentArray.insertData(
+			entity, std::make_shared<TESTING::TestComponent>(
+						static_cast<int>(entity) * 10));
+	}
+
+	componentArray.removeData(1);
+	CHECK(componentArray.size() == 3);
+	CHECK(componentArray.getData(1) == nullptr);
+	CHECK(componentArray.getData(0)->x == 0);
+	CHECK(componentArray.getData(2)->x == 20);
+	CHECK(componentArray.getData(3)->x == 30);
+
+	// Destroying an entity without the component is a no-op.
+	componentArray.entityDestroyed(42);
+	CHECK(componentArray.size() == 3);
+
+	// The packed arrays stay in lock step.
+	auto const &entities = componentArray.getEntities();
+	auto const &components = componentArray.getComponents();
+	for (std::size_t i = 0; i < entities.size(); i++) {
+		CHECK(components[i]->x == static_cast<int>(entities[i]) * 10);
+	}
+}
+
+TEST_CASE("component-array-by-value") {
+	ComponentArray<TESTING::TestValueComponent> componentArray;
+
+	for (Entity entity = 0; entity < 4; entity++) {
+		componentArray.emplace(entity, static_cast<int>(entity) * 10);
+	}
+
+	CHECK(componentArray.find(2)->x == 20);
+	componentArray.find(2)->x = 21;
+	CHECK(componentArray.getComponents()[2].x == 21);
+
+	componentArray.removeData(0);
+	CHECK(componentArray.find(0) == nullptr);
+	CHECK(componentArray.size() == 3);
+	CHECK(componentArray.find(3)->x == 30);
+
+	// Emplacing again replaces the existing component.
+	componentArray.emplace(3, 33);
+	CHECK(componentArray.size() == 3);
+	CHECK(componentArray.find(3)->x == 33);
+}
+
+namespace {
+struct Velocity {
+	float x = 0.F;
+	float y = 0.F;
+};
+} // namespace
+
+TEST_CASE("component-array-pod") {
+	static_assert(PodComponent<Velocity>);
+	static_assert(!PodComponent<TESTING::TestComponent>);
+	static_assert(ComponentStorage<Velocity>::value == Storage::Pod);
+	// Declared storage wins over the Pod default.
+	static_assert(ComponentStorage<TESTING::TestValueComponent>::value ==
+				  Storage::Value);
+
+	ComponentArray<Velocity> componentArray;
+
+	std::vector<Entity> entities;
+	std::vector<Velocity> values;
+	for (Entity entity = 0; entity < 100; entity++) {
+		entities.push_back(entity);
+		values.push_back({static_cast<float>(entity), 1.F});
+	}
+	componentArray.insertBulk(entities, values, 1);
+
+	CHECK(componentArray.size() == 100);
+	CHECK(reinterpret_cast<std::uintptr_t>(
+			  componentArray.getComponents().data()) %
+			  PodAlignment ==
+		  0);
+	CHECK(componentArray.find(42)->x == 42.F);
+
+	componentArray.removeData(0);
+	CHECK(componentArray.find(0) == nullptr);
+	CHECK(componentArray.find(99)->x == 99.F);
+
+	CHECK(componentArray.clone(42, 0)->x == 42.F);
+	CHECK(componentArray.clone(1000, 1) == nullptr);
+	CHECK(componentArray.size() == 100);
+
+	// Bulk inserting over existing components replaces them.
+	std::vector<Entity> again{5, 200};
+	std::vector<Velocity> replacements{{-5.F, 0.F}, {200.F, 0.F}};
+	componentArray.insertBulk(again, replacements, 2);
+	CHECK(componentArray.size() == 101);
+	CHECK(componentArray.find(5)->x == -5.F);
+	CHECK(componentArray.find(200)->x == 200.F);
+	CHECK(componentArray.findTicks(5)->added == 2);
+	CHECK(componentArray.findTicks(200)->changed == 2);
+	CHECK(componentArray.findTicks(6)->added == 1);
+
+	// An entity given twice ends up with the last value and one slot.
+	std::vector<Entity> twice{300, 301, 300, 302};
+	std::vector<Velocity> both{{1.F, 0.F}, {2.F, 0.F}, {3.F, 0.F}, {4.F, 0.F}};
+	componentArray.insertBulk(twice, both, 3);
+	CHECK(componentArray.size() == 104);
+	CHECK(componentArray.getComponents().size() == 104);
+	CHECK(componentArray.find(300)->x == 3.F);
+	CHECK(componentArray.find(301)->x == 2.F);
+	CHECK(componentArray.find(302)->x == 4.F);
+	CHECK(componentArray.findTicks(302)->added == 3);
+
+	auto const &packed = componentArray.getEntities();
+	auto components = componentArray.getComponents();
+	for (std::size_t i = 0; i < packed.size(); i++) {
+		CHECK(componentArray.find(packed[i]) == &components[i]);
+	}
+}
@@ -7,7 +7,7 @@
 using namespace gim::ecs;
 
 TEST_CASE("component-manager") {
-	ComponentManager cm;
+	SparseComponentManager cm;
 
 	cm.registerComponent<TESTING::TestComponent>();
 	CHECK(cm.getComponentArray<TESTING::TestComponent>() != nullptr);
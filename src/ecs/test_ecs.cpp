@@ -1,9 +1,14 @@
 #include "gim/ecs/engine/component_array.hpp"
 #include "gim/ecs/engine/signature.hpp"
 #include "gim/ecs/engine/testing.hpp"
+#include <array>
+#include <cstdint>
 #include <doctest/doctest.h>
+#include <functional>
 #include <gim/ecs/ecs.hpp>
+#include <gim/library/jobs.hpp>
 #include <iostream>
+#include <vector>
 
 using namespace gim::ecs;
 
@@ -30,3 +35,212 @@ TEST_CASE("ECS") {
 	CHECK(ecs.getComponent<TESTING::TestComponent>(e1)->x == 6);
 	CHECK(ecs.getComponent<TESTING::TestComponent>(e2)->x == 11);
 }
+
+TEST_CASE("ECS-by-value") {
+	auto ecs = ECS();
+	ecs.registerComponent<TESTING::TestValueComponent>();
+
+	auto e1 = ecs.createEntity();
+	auto &component = ecs.emplace<TESTING::TestValueComponent>(e1, 7);
+	CHECK(component.x == 7);
+
+	ecs.get<TESTING::TestValueComponent>(e1).x++;
+	CHECK(ecs.get<TESTING::TestValueComponent>(e1).x == 8);
+	CHECK(ecs.hasComponent<TESTING::TestValueComponent>(e1));
+
+	ecs.removeComponent<TESTING::TestValueComponent>(e1);
+	CHECK_FALSE(ecs.hasComponent<TESTING::TestValueComponent>(e1));
+	CHECK_THROWS(ecs.get<TESTING::TestValueComponent>(e1));
+}
+
+TEST_CASE("ECS-view") {
+	auto ecs = ECS();
+	ecs.registerComponent<TESTING::TestComponent>();
+	ecs.registerComponent<TESTING::TestValueComponent>();
+
+	for (int i = 0; i < 10; i++) {
+		auto entity = ecs.createEntity();
+		ecs.addComponent(entity, std::make_shared<TESTING::TestComponent>(i));
+		if (i % 2 == 0) {
+			ecs.emplace<TESTING::TestValueComponent>(entity, i * 10);
+		}
+	}
+
+	int visited = 0;
+	for (auto [entity, shared, value] :
+		 ecs.view<TESTING::TestComponent,
+				  const TESTING::TestValueComponent>()) {
+		CHECK(value.x == shared.x * 10);
+		shared.x++;
+		visited++;
+	}
+	CHECK(visited == 5);
+
+	visited = 0;
+	ecs.view<const TESTING::TestComponent>().each(
+		[&](Entity, const TESTING::TestComponent &) { visited++; });
+	CHECK(visited == 10);
+
+	int odd = 0;
+	ecs.view<TESTING::TestComponent>().each(
+		[&](Entity, TESTING::TestComponent &component) {
+			odd += component.x % 2;
+		});
+	// The even components were bumped by one in the first loop.
+	CHECK(odd == 10);
+}
+
+TEST_CASE("ECS-parallel-each") {
+	auto ecs = ECS();
+	ecs.registerComponent<TESTING::TestComponent>();
+	ecs.registerComponent<TESTING::TestValueComponent>();
+	gim::library::jobs::JobSystem jobs(3);
+
+	constexpr int count = 10'000;
+	for (int i = 0; i < count; i++) {
+		auto entity = ecs.createEntity();
+		ecs.emplace<TESTING::TestValueComponent>(entity, i);
+		if (i % 2 == 1) {
+			ecs.addComponent(entity,
+							 std::make_shared<TESTING::TestComponent>(i));
+		}
+	}
+
+	ecs.view<TESTING::TestValueComponent>().parallelEach(
+		[](Entity, TESTING::TestValueComponent &component) {
+			component.x *= 2;
+		},
+		jobs);
+
+	auto sum = ecs.view<const TESTING::TestValueComponent>().parallelReduce(
+		std::int64_t{0},
+		[](Entity, const TESTING::TestValueComponent &component) {
+			return std::int64_t{component.x};
+		},
+		std::plus<>{}, jobs);
+	CHECK(sum == std::int64_t{count} * (count - 1));
+
+	auto matched =
+		ecs.view<const TESTING::TestComponent,
+				 const TESTING::TestValueComponent>()
+			.parallelReduce(
+				0,
+				[](Entity, const TESTING::TestComponent &shared,
+				   const TESTING::TestValueComponent &value) {
+					return value.x == shared.x * 2 ? 1 : 0;
+				},
+				std::plus<>{}, jobs);
+	CHECK(matched == count / 2);
+}
+
+TEST_CASE("ECS-parallel-grain") {
+	struct Twelve {
+		float x, y, z;
+	};
+	// 12 bytes: 16 of them, not 5, end on a cache line boundary.
+	auto small = detail::parallelGrain<Twelve>(100, 1);
+	auto large = detail::parallelGrain<Twelve>(1'000'000, 3);
+	CHECK(small * sizeof(Twelve) % 64 == 0);
+	CHECK(large * sizeof(Twelve) % 64 == 0);
+	CHECK(large >= 1'000'000 / 12);
+
+	auto wide = detail::parallelGrain<std::array<char, 96>>(10'000, 2);
+	CHECK(wide * 96 % 64 == 0);
+}
+
+TEST_CASE("ECS-stale-handles") {
+	auto ecs = ECS();
+	ecs.registerComponent<TESTING::TestValueComponent>();
+
+	auto first = ecs.createEntity();
+	ecs.emplace<TESTING::TestValueComponent>(first, 1);
+	ecs.destroyEntity(first);
+
+	auto second = ecs.createEntity();
+	ecs.emplace<TESTING::TestValueComponent>(second, 2);
+
+	CHECK(entityIndex(first) == entityIndex(second));
+	CHECK(!ecs.alive(first));
+	CHECK(!ecs.hasComponent<TESTING::TestValueComponent>(first));
+	CHECK(ecs.get<TESTING::TestValueComponent>(second).x == 2);
+	CHECK_THROWS(ecs.emplace<TESTING::TestValueComponent>(first, 3));
+
+	// Destroying the stale handle again doesn't touch the new entity.
+	ecs.destroyEntity(first);
+	CHECK(ecs.alive(second));
+	CHECK(ecs.hasComponent<TESTING::TestValueComponent>(second));
+}
+
+TEST_CASE("ECS-insert-bulk") {
+	// Plain data, so stored as Pod and copied in with one memcpy.
+	struct Mass {
+		float kg = 0.F;
+	};
+
+	auto ecs = ECS();
+	ecs.registerComponent<Mass>();
+	ecs.registerComponent<TESTING::TestValueComponent>();
+
+	std::vector<Entity> entities;
+	std::vector<Mass> masses;
+	for (int i = 0; i < 10; i++) {
+		entities.push_back(ecs.createEntity());
+		masses.push_back({static_cast<float>(i)});
+	}
+	ecs.emplace<Mass>(entities[3], -1.F);
+	ecs.emplace<TESTING::TestValueComponent>(entities[3], 3);
+	entities.push_back(entities[4]);
+	masses.push_back({40.F});
+
+	ecs.insertBulk<Mass>(entities, masses);
+	CHECK(ecs.get<Mass>(entities[3]).kg == 3.F);
+	CHECK(ecs.get<Mass>(entities[4]).kg == 40.F);
+	CHECK(ecs.get<Mass>(entities[9]).kg == 9.F);
+	int count = 0;
+	ecs.view<const Mass>().each([&](Entity, const Mass &) { count++; });
+	CHECK(count == 10);
+	count = 0;
+	ecs.view<const Mass, const TESTING::TestValueComponent>().each(
+		[&](Entity, const Mass &, const TESTING::TestValueComponent &) {
+			count++;
+		});
+	CHECK(count == 1);
+
+	// Nothing is inserted when one of the entities is dead.
+	auto dead = ecs.createEntity();
+	auto alive = ecs.createEntity();
+	ecs.destroyEntity(dead);
+	std::vector<Entity> mixed{alive, dead};
+	std::vector<Mass> two{{1.F}, {2.F}};
+	CHECK_THROWS(ecs.insertBulk<Mass>(mixed, two));
+	CHECK(!ecs.hasComponent<Mass>(alive));
+
+	std::vector<TESTING::TestValueComponent> values{{7}};
+	std::vector<Entity> one{alive};
+	ecs.insertBulk<TESTING::TestValueComponent>(one, values);
+	CHECK(ecs.get<TESTING::TestValueComponent>(alive).x == 7);
+}
+
+TEST_CASE("ECS-resources") {
+	struct Settings {
+		int volume = 5;
+	};
+
+	auto ecs = ECS();
+	CHECK(!ecs.hasResource<Settings>());
+	CHECK_THROWS(ecs.resource<Settings>());
+
+	ecs.emplaceResource<Settings>();
+	CHECK(ecs.hasResource<Settings>());
+	ecs.resource<Settings>().volume = 7;
+	CHECK(ecs.resource<const Settings>().volume == 7);
+
+	// Inserting again replaces the resource.
+	auto replacement = std::make_shared<Settings>();
+	replacement->volume = 1;
+	ecs.insertResource(replacement);
+	CHECK(&ecs.resource<Settings>() == replacement.get());
+
+	ecs.removeResource<Settings>();
+	CHECK(!ecs.hasResource<Settings>());
+}
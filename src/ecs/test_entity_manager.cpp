@@ -6,14 +6,14 @@
 #include <doctest/doctest.h>
 
 TEST_CASE("entity-manager") {
-	auto em = gim::ecs::EntityManager<10>();
+	auto em = gim::ecs::EntityManager();
 	auto e1 = em.createEntity();
 
 	CHECK(e1 == 0);
 
 	// Create a signature for the entity.
-	auto s1 = std::make_shared<gim::ecs::Signature>();
-	s1->set<gim::ecs::TESTING::TestComponent>();
+	auto s1 = gim::ecs::Signature();
+	s1.set<gim::ecs::TESTING::TestComponent>();
 	em.setSignature(e1, s1);
 	CHECK(em.getSignature(e1)->get<gim::ecs::TESTING::TestComponent>() == true);
 	CHECK(em.getSignature(e1) != nullptr);
@@ -26,3 +26,95 @@ TEST_CASE("entity-manager") {
 	em.destroyEntity(e1);
 	CHECK(em.getSignature(e1) == nullptr);
 }
+
+TEST_CASE("entity-manager-generations") {
+	using namespace gim::ecs;
+	auto em = EntityManager();
+
+	auto e1 = em.createEntity();
+	auto e2 = em.createEntity();
+	auto e3 = em.createEntity();
+	CHECK(em.alive(e1));
+	CHECK(em.size() == 3);
+
+	// Freed slots are reused last in first out with a new generation.
+	em.destroyEntity(e1);
+	em.destroyEntity(e3);
+	CHECK(!em.alive(e1));
+	CHECK(!em.alive(e3));
+	CHECK(em.size() == 1);
+
+	auto e4 = em.createEntity();
+	CHECK(entityIndex(e4) == entityIndex(e3));
+	CHECK(entityGeneration(e4) == entityGeneration(e3) + 1);
+	CHECK(e4 != e3);
+	CHECK(em.alive(e4));
+	CHECK(!em.alive(e3));
+
+	auto e5 = em.createEntity();
+	CHECK(entityIndex(e5) == entityIndex(e1));
+
+	// Destroying a stale handle leaves the entity now in the slot alone.
+	em.destroyEntity(e1);
+	CHECK(em.alive(e5));
+	CHECK(em.getSignature(e5) != nullptr);
+	CHECK(em.getSignature(e1) == nullptr);
+
+	CHECK(em.alive(e2));
+	CHECK(!em.alive(NullEntity));
+}
+
+TEST_CASE("entity-manager-generation-wrap") {
+	using namespace gim::ecs;
+	auto em = EntityManager();
+
+	// Cycle one slot through every generation, a stale handle must never
+	// come back to life.
+	auto first = em.createEntity();
+	auto entity = first;
+	for (Entity generation = 0; generation < EntityGenerationMask;
+		 generation++) {
+		em.destroyEntity(entity);
+		entity = em.createEntity();
+		CHECK(entityIndex(entity) == entityIndex(first));
+		CHECK(!em.alive(first));
+	}
+	CHECK(entityGeneration(entity) == EntityGenerationMask);
+
+	// The last generation retires the slot instead of wrapping to 0.
+	em.destroyEntity(entity);
+	CHECK(!em.alive(entity));
+	CHECK(!em.alive(first));
+	auto next = em.createEntity();
+	CHECK(entityIndex(next) != entityIndex(first));
+	CHECK(!em.alive(first));
+	CHECK(em.size() == 1);
+
+	// Destroying handles to the retired slot does nothing.
+	em.destroyEntity(first);
+	em.destroyEntity(entity);
+	CHECK(em.alive(next));
+	CHECK(em.size() == 1);
+}
+
+TEST_CASE("entity-manager-pages") {
+	using namespace gim::ecs;
+	auto em = EntityManager();
+
+	// Entities spill into new pages, and signatures in earlier pages stay
+	// where they are.
+	auto first = em.createEntity();
+	auto *signature = em.getSignature(first);
+	signature->set<TESTING::TestComponent>();
+
+	Entity last = first;
+	for (std::size_t i = 1; i < EntityManager::PageSize * 3; i++) {
+		last = em.createEntity();
+	}
+
+	CHECK(entityIndex(last) == EntityManager::PageSize * 3 - 1);
+	CHECK(em.size() == EntityManager::PageSize * 3);
+	CHECK(em.getSignature(first) == signature);
+	CHECK(signature->get<TESTING::TestComponent>());
+	CHECK(em.getSignature(last)->empty());
+}
@@ -0,0 +1,206 @@
+#include "gim/ecs/engine/testing.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <doctest/doctest.h>
+#include <functional>
+#include <gim/ecs/ecs.hpp>
+#include <gim/library/jobs.hpp>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+using namespace gim::ecs;
+
+// Counts heap allocations while a test arms it. Only the operator new forms
+// are replaced and every call is forwarded to the definition this one hides
+// (the sanitizer's or the standard library's), so the rest of the test
+// binary keeps the allocator, and the checks, it would have without this
+// file. The mangled names assume the Itanium ABI of LP64 Linux.
+#if defined(__linux__) && defined(__LP64__)
+#define GIM_COUNT_ALLOCATIONS
+namespace {
+std::atomic<bool> countingAllocations{false};
+std::atomic<std::size_t> heapAllocations{0};
+
+template <typename Fn> auto hidden(const char *symbol) -> Fn {
+	auto *found = dlsym(RTLD_NEXT, symbol);
+	if (found == nullptr) {
+		std::abort();
+	}
+	return reinterpret_cast<Fn>(found);
+}
+
+template <typename Fn, typename... Args>
+auto counted(Fn fn, Args &&...args) -> void * {
+	if (countingAllocations.load(std::memory_order_relaxed)) {
+		heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+	return fn(std::forward<Args>(args)...);
+}
+} // namespace
+
+using New = void *(*)(std::size_t);
+using AlignedNew = void *(*)(std::size_t, std::align_val_t);
+using NothrowNew = void *(*)(std::size_t, std::nothrow_t const &);
+using AlignedNothrowNew = void *(*)(std::size_t, std::align_val_t,
+									std::nothrow_t const &);
+
+auto operator new(std::size_t bytes) -> void * {
+	static auto fn = hidden<New>("_Znwm");
+	return counted(fn, bytes);
+}
+auto operator new[](std::size_t bytes) -> void * {
+	static auto fn = hidden<New>("_Znam");
+	return counted(fn, bytes);
+}
+auto operator new(std::size_t bytes, std::align_val_t alignment) -> void * {
+	static auto fn = hidden<AlignedNew>("_ZnwmSt11align_val_t");
+	return counted(fn, bytes, alignment);
+}
+auto operator new[](std::size_t bytes, std::align_val_t alignment) -> void * {
+	static auto fn = hidden<AlignedNew>("_ZnamSt11align_val_t");
+	return counted(fn, bytes, alignment);
+}
+auto operator new(std::size_t bytes, std::nothrow_t const &nothrow) noexcept
+	-> void * {
+	static auto fn = hidden<NothrowNew>("_ZnwmRKSt9nothrow_t");
+	return counted(fn, bytes, nothrow);
+}
+auto operator new[](std::size_t bytes, std::nothrow_t const &nothrow) noexcept
+	-> void * {
+	static auto fn = hidden<NothrowNew>("_ZnamRKSt9nothrow_t");
+	return counted(fn, bytes, nothrow);
+}
+auto operator new(std::size_t bytes, std::align_val_t alignment,
+				  std::nothrow_t const &nothrow) noexcept -> void * {
+	static auto fn =
+		hidden<AlignedNothrowNew>("_ZnwmSt11align_val_tRKSt9nothrow_t");
+	return counted(fn, bytes, alignment, nothrow);
+}
+auto operator new[](std::size_t bytes, std::align_val_t alignment,
+					std::nothrow_t const &nothrow) noexcept -> void * {
+	static auto fn =
+		hidden<AlignedNothrowNew>("_ZnamSt11align_val_tRKSt9nothrow_t");
+	return counted(fn, bytes, alignment, nothrow);
+}
+#endif
+
+namespace {
+// The shape of a frame: a parallel update, a parallel reduction and some
+// entities dying and being replaced through the command buffer.
+class System : public ISystem {
+  private:
+	std::shared_ptr<ComponentManager> componentManager;
+
+  public:
+	auto getSignature() -> std::shared_ptr<Signature> override {
+		return std::make_shared<Signature>();
+	}
+
+	auto setComponentManager(std::shared_ptr<ComponentManager> cm)
+		-> void override {
+		componentManager = cm;
+	}
+
+	auto getComponentManager() -> std::shared_ptr<ComponentManager> override {
+		return componentManager;
+	}
+};
+
+class MoveSystem : public System {
+  public:
+	using Writes = Components<TESTING::TestValueComponent>;
+
+	auto update() -> void override {
+		getComponentManager()->view<TESTING::TestValueComponent>().parallelEach(
+			[](Entity, TESTING::TestValueComponent &component) {
+				component.x++;
+			});
+	}
+};
+
+class SumSystem : public System {
+  public:
+	using Reads = Components<TESTING::TestValueComponent>;
+
+	long total = 0;
+
+	auto update() -> void override {
+		total = getComponentManager()
+					->view<const TESTING::TestValueComponent>()
+					.parallelReduce(
+						0L,
+						[](Entity, TESTING::TestValueComponent const &c) {
+							return static_cast<long>(c.x);
+						},
+						std::plus<>{});
+	}
+};
+
+class ChurnSystem : public System {
+  public:
+	using Reads = Components<TESTING::TestValueComponent>;
+
+	auto update() -> void override {
+		int destroyed = 0;
+		for (auto [entity, component] :
+			 getComponentManager()
+				 ->view<const TESTING::TestValueComponent>()) {
+			if (destroyed++ == 8) {
+				break;
+			}
+			commands().destroy(entity);
+		}
+		for (int i = 0; i < 8; i++) {
+			commands().emplace<TESTING::TestValueComponent>(commands().create(),
+															i);
+		}
+	}
+};
+} // namespace
+
+TEST_CASE("frame-allocations") {
+	auto ecs = ECS();
+	ecs.registerComponent<TESTING::TestValueComponent>();
+	ecs.registerSystem<MoveSystem>();
+	ecs.registerSystem<SumSystem>();
+	ecs.registerSystem<ChurnSystem>();
+
+	for (int i = 0; i < 4'000; i++) {
+		ecs.emplace<TESTING::TestValueComponent>(ecs.createEntity(), i);
+	}
+
+	// The instance may have no workers, so also keep a pool of our own busy.
+	gim::library::jobs::JobSystem jobs(3);
+	std::vector<long> values(4'000, 1);
+	auto frame = [&] {
+		ecs.update();
+		jobs.parallelFor(values.size(), 64,
+						 [&](std::size_t begin, std::size_t end) {
+							 for (auto i = begin; i < end; i++) {
+								 values[i]++;
+							 }
+						 });
+	};
+
+	// Warm up until every buffer, pool and arena has grown to its size.
+	for (int i = 0; i < 50; i++) {
+		frame();
+	}
+
+#ifdef GIM_COUNT_ALLOCATIONS
+	heapAllocations = 0;
+	countingAllocations = true;
+#endif
+	for (int i = 0; i < 20; i++) {
+		frame();
+	}
+#ifdef GIM_COUNT_ALLOCATIONS
+	countingAllocations = false;
+	CHECK(heapAllocations.load() == 0);
+#endif
+	CHECK(values[0] == 71);
+}
@@ -0,0 +1,176 @@
+#include <atomic>
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <gim/library/jobs.hpp>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace gim::library::jobs;
+
+TEST_CASE("work-stealing-deque") {
+	WorkStealingDeque<std::intptr_t> deque(4);
+
+	// Grows past its initial capacity.
+	for (std::intptr_t i = 1; i <= 10; i++) {
+		deque.push(i);
+	}
+	CHECK(deque.pop() == 10);
+	CHECK(deque.steal() == 1);
+	CHECK(deque.pop() == 9);
+
+	std::intptr_t left = 0;
+	while (auto item = deque.pop()) {
+		left++;
+	}
+	CHECK(left == 7);
+	CHECK(deque.empty());
+	CHECK(!deque.steal().has_value());
+}
+
+TEST_CASE("work-stealing-deque-concurrent") {
+	constexpr std::intptr_t Items = 20000;
+	WorkStealingDeque<std::intptr_t> deque;
+	std::atomic<std::intptr_t> sum{0};
+	std::atomic<std::intptr_t> taken{0};
+	std::atomic<bool> pushing{true};
+
+	std::vector<std::thread> thieves;
+	for (int i = 0; i < 3; i++) {
+		thieves.emplace_back([&] {
+			while (pushing.load() || !deque.empty()) {
+				if (auto item = deque.steal()) {
+					sum += *item;
+					taken++;
+				}
+			}
+		});
+	}
+
+	for (std::intptr_t i = 1; i <= Items; i++) {
+		deque.push(i);
+		if (i % 3 == 0) {
+			if (auto item = deque.pop()) {
+				sum += *item;
+				taken++;
+			}
+		}
+	}
+	while (auto item = deque.pop()) {
+		sum += *item;
+		taken++;
+	}
+	pushing = false;
+	for (auto &thief : thieves) {
+		thief.join();
+	}
+
+	// Every item is taken exactly once.
+	CHECK(taken == Items);
+	CHECK(sum == Items * (Items + 1) / 2);
+}
+
+TEST_CASE("job-system-counters") {
+	JobSystem jobs(3);
+	Counter first;
+	Counter second;
+	std::atomic<int> ran{0};
+	std::atomic<bool> firstFinished{true};
+
+	for (int i = 0; i < 32; i++) {
+		jobs.submit([&] { ran++; }, first);
+	}
+	jobs.submitAfter(
+		first, [&] { firstFinished = ran.load() == 32; }, &second);
+
+	jobs.wait(second);
+	CHECK(first.done());
+	CHECK(firstFinished);
+
+	// A finished counter starts dependent jobs right away.
+	jobs.submitAfter(first, [&] { ran++; }, &second);
+	jobs.wait(second);
+	CHECK(ran == 33);
+}
+
+TEST_CASE("job-system-short-lived-counters") {
+	// Waiting returns once the last job is done with the counter, so it can
+	// be destroyed right away (ASan and TSan catch a late finish()).
+	constexpr int Rounds = 2000;
+	JobSystem jobs(3);
+	std::atomic<int> ran{0};
+	for (int i = 0; i < Rounds; i++) {
+		auto counter = std::make_unique<Counter>();
+		jobs.submit([&] { ran++; }, *counter);
+		jobs.submit([&] { ran++; }, *counter);
+		jobs.wait(*counter);
+	}
+	CHECK(ran == 2 * Rounds);
+
+	for (int i = 0; i < Rounds; i++) {
+		jobs.parallelFor(4, 1, [&](std::size_t begin, std::size_t end) {
+			ran += static_cast<int>(end - begin);
+		});
+	}
+	CHECK(ran == 6 * Rounds);
+}
+
+TEST_CASE("job-system-errors") {
+	JobSystem jobs(2);
+	Counter counter;
+
+	jobs.submit([] { throw std::runtime_error("job failed"); }, counter);
+	jobs.submit([] {}, counter);
+	CHECK_THROWS(jobs.wait(counter));
+	// The error is only reported once.
+	CHECK_NOTHROW(jobs.wait(counter));
+
+	CHECK_THROWS(jobs.parallelFor(16, 1, [](std::size_t begin, std::size_t) {
+		if (begin == 7) {
+			throw std::runtime_error("range failed");
+		}
+	}));
+}
+
+TEST_CASE("job-system-priorities") {
+	// Without workers everything runs on the helping thread, in priority
+	// order.
+	JobSystem jobs(0);
+	Counter counter;
+	std::vector<Priority> order;
+
+	jobs.submit([&] { order.push_back(Priority::Background); }, counter,
+				Priority::Background);
+	jobs.submit([&] { order.push_back(Priority::Frame); }, counter);
+	jobs.wait(counter);
+
+	REQUIRE(order.size() == 2);
+	CHECK(order[0] == Priority::Frame);
+	CHECK(order[1] == Priority::Background);
+}
+
+TEST_CASE("job-system-main-thread-lane") {
+	JobSystem jobs(3);
+	Counter counter;
+	std::thread::id ranOn;
+	std::atomic<bool> onWorker{false};
+
+	CHECK(jobs.isMainThread());
+	// Background jobs are left to the workers.
+	jobs.submit(
+		[&] {
+			onWorker = !jobs.isMainThread();
+			jobs.submitMain([&] { ranOn = std::this_thread::get_id(); },
+							&counter);
+		},
+		counter, Priority::Background);
+
+	jobs.wait(counter);
+	CHECK(onWorker);
+	CHECK(ranOn == std::this_thread::get_id());
+
+	jobs.submitMain([&] { ranOn = {}; });
+	CHECK(jobs.runMainThreadJobs());
+	CHECK(ranOn == std::thread::id{});
+}
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <gim/library/loop.hpp>
+#include <thread>
+
+using namespace gim::library::loop;
+
+TEST_CASE("fixed-timestep") {
+	FixedTimestep loop({.simulationRate = 100.0});
+	int steps = 0;
+	int frames = 0;
+	double alpha = -1.0;
+
+	auto simulate = [&](FrameTime const &time) {
+		CHECK(std::abs(time.delta - 0.01) < 1e-9);
+		steps++;
+	};
+	auto render = [&](FrameTime const &time) {
+		alpha = time.alpha;
+		frames++;
+	};
+	auto frame = [&] { loop.frame(simulate, render); };
+
+	frame();
+	CHECK(frames == 1);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(35));
+	frame();
+	CHECK(steps >= 3);
+	CHECK(frames == 2);
+	CHECK(alpha >= 0.0);
+	CHECK(alpha < 1.0);
+	CHECK(loop.getTime().steps == static_cast<std::uint64_t>(steps));
+}
+
+TEST_CASE("fixed-timestep-catch-up-limit") {
+	FixedTimestep loop({.simulationRate = 1000.0, .maxStepsPerFrame = 3});
+	int steps = 0;
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	loop.frame([&](FrameTime const &) { steps++; }, [](FrameTime const &) {});
+
+	// The rest of the backlog is dropped rather than simulated later.
+	CHECK(steps == 3);
+	CHECK(loop.getTime().alpha < 1.0);
+}
+
+TEST_CASE("fixed-timestep-frame-cap") {
+	FixedTimestep loop({.maxFrameRate = 100.0});
+	auto start = Clock::now();
+
+	for (int i = 0; i < 5; i++) {
+		loop.frame([](FrameTime const &) {}, [](FrameTime const &) {});
+	}
+
+	// Five capped frames take at least 50ms, sleeping rather than spinning.
+	CHECK(Clock::now() - start >= std::chrono::milliseconds(45));
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <gim/library/jobs.hpp>
+#include <gim/library/morton.hpp>
+#include <gim/library/sort.hpp>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace gim::library;
+
+TEST_CASE("morton-encode-decode") {
+	CHECK(morton::encode(0, 0, 0) == 0);
+	CHECK(morton::encode(2, 0, 0) == 8);
+	CHECK(morton::encode(0, 0, 2) == 32);
+
+	std::mt19937 random(5);
+	std::uniform_int_distribution<std::uint32_t> axis(0, (1U << 21U) - 1);
+	bool roundTrips = true;
+	for (int i = 0; i < 1000; i++) {
+		auto x = axis(random);
+		auto y = axis(random);
+		auto z = axis(random);
+		roundTrips = roundTrips &&
+		             morton::decode(morton::encode(x, y, z)) ==
+		                 std::array<std::uint32_t, 3>{x, y, z};
+	}
+	CHECK(roundTrips);
+}
+
+TEST_CASE("morton-tables-match-bit-twiddling") {
+	std::mt19937 random(7);
+	std::uniform_int_distribution<std::uint32_t> axis(0, (1U << 21U) - 1);
+	bool same = true;
+	for (int i = 0; i < 1000; i++) {
+		auto x = axis(random);
+		auto y = axis(random);
+		auto z = axis(random);
+		auto code = morton::spread(x) | morton::spread(y) << 1U |
+		            morton::spread(z) << 2U;
+		same = same && morton::detail::encodeTable(x, y, z) == code &&
+		       morton::detail::decodeTable(code) ==
+		           std::array<std::uint32_t, 3>{x, y, z};
+#if defined(GIM_MORTON_BMI2)
+		if (morton::usesBmi2()) {
+			same = same && morton::detail::encodeBmi2(x, y, z) == code &&
+			       morton::detail::decodeBmi2(code) ==
+			           std::array<std::uint32_t, 3>{x, y, z};
+		}
+#endif
+	}
+	CHECK(same);
+	// Bits above the 21 per axis are dropped.
+	CHECK(morton::encode(1U << 21U, 0, 0) == 0);
+	CHECK(morton::detail::encodeTable(1U << 21U, 0, 0) == 0);
+}
+
+TEST_CASE("radix-sort") {
+	jobs::JobSystem pool(3);
+	std::mt19937_64 random(6);
+
+	for (std::size_t count : {0, 1, 100, 200000}) {
+		std::vector<std::uint64_t> keys(count);
+		for (auto &key : keys) {
+			key = random();
+		}
+		auto expected = keys;
+		std::sort(expected.begin(), expected.end());
+
+		sort::radixSort(std::span(keys), 64, pool);
+		CHECK(keys == expected);
+	}
+}
+
+TEST_CASE("radix-sort-low-bits") {
+	jobs::JobSystem pool(3);
+	std::vector<std::uint32_t> keys;
+	for (std::uint32_t i = 0; i < 100000; i++) {
+		keys.push_back((i * 7919U) % 4096U);
+	}
+	auto expected = keys;
+	std::sort(expected.begin(), expected.end());
+
+	// Only the 12 bits in use are sorted.
+	sort::radixSort(std::span(keys), 12, pool);
+	CHECK(keys == expected);
+
+	// Bits above bits don't take part, even within the last byte.
+	std::vector<std::uint32_t> small{2, 0, 6, 4, 3, 1};
+	std::vector<std::uint32_t> lowBit{2, 0, 6, 4, 3, 1};
+	std::vector<std::uint32_t> lowBits{0, 4, 1, 2, 6, 3};
+	sort::radixSort(std::span(small), 1, pool);
+	CHECK(small == lowBit);
+	sort::radixSort(std::span(small), 2, pool);
+	CHECK(small == lowBits);
+
+	std::mt19937 random(5);
+	keys.clear();
+	for (int i = 0; i < 100000; i++) {
+		keys.push_back(static_cast<std::uint32_t>(random()));
+	}
+	expected = keys;
+	std::stable_sort(expected.begin(), expected.end(),
+	                 [](std::uint32_t a, std::uint32_t b) {
+		                 return (a & 0x3FFFU) < (b & 0x3FFFU);
+	                 });
+	sort::radixSort(std::span(keys), 14, pool);
+	CHECK(keys == expected);
+}
+
+TEST_CASE("radix-sort-payloads") {
+	jobs::JobSystem pool(3);
+	std::mt19937 random(8);
+
+	struct Item {
+		std::uint32_t key = 0;
+		std::uint32_t order = 0;
+	};
+	std::vector<std::uint32_t> keys;
+	std::vector<Item> items;
+	for (std::uint32_t i = 0; i < 100000; i++) {
+		keys.push_back(random() % 1000U);
+		items.push_back({keys.back(), i});
+	}
+	auto expected = items;
+	std::stable_sort(expected.begin(), expected.end(),
+	                 [](Item a, Item b) { return a.key < b.key; });
+
+	sort::radixSort(std::span(keys), std::span(items), 10, pool);
+
+	// Values move with their keys and equal keys keep their order.
+	bool same = true;
+	for (std::size_t i = 0; i < items.size(); i++) {
+		same = same && keys[i] == expected[i].key &&
+		       items[i].key == expected[i].key &&
+		       items[i].order == expected[i].order;
+	}
+	CHECK(same);
+}
@@ -0,0 +1,89 @@
+#include <cstddef>
+#include <doctest/doctest.h>
+#include <gim/svo/noise.hpp>
+#include <random>
+#include <vector>
+
+using gim::svo::Simd;
+
+namespace {
+auto kernels() -> std::vector<Simd> {
+	std::vector<Simd> supported;
+	for (auto simd : {Simd::Scalar, Simd::Sse2, Simd::Avx2, Simd::Avx512}) {
+		if (simd <= gim::svo::detectSimd()) {
+			supported.push_back(simd);
+		}
+	}
+	return supported;
+}
+
+// The coordinate generateGrid() samples. The product goes through memory
+// so it is rounded before the add, like in the kernels, even when this
+// file is built with FMA contraction.
+auto along(float origin, float step, int i) -> float {
+	volatile float offset = step * static_cast<float>(i);
+	return origin + offset;
+}
+} // namespace
+
+TEST_CASE("noise-batch-matches-fastnoiselite") {
+	std::mt19937 random(9);
+	std::vector<glm::vec3> positions;
+	// Terrain coordinates, and far out where the rounding errors of a fused
+	// multiply-add would be largest.
+	for (float range : {5000.f, 1e5f}) {
+		std::uniform_real_distribution<float> coordinate(-range, range);
+		for (int i = 0; i < 10007; i++) {
+			positions.emplace_back(coordinate(random), coordinate(random),
+			                       coordinate(random));
+		}
+	}
+	// Lattice points and negative integers, where FastFloor rounds down.
+	positions.emplace_back(0.f, 0.f, 0.f);
+	positions.emplace_back(-300.f, 150.f, -1.f);
+
+	SimplexNoise noise;
+	for (auto simd : kernels()) {
+		noise.setSimd(simd);
+		CHECK(noise.getSimd() == simd);
+
+		std::vector<float> values(positions.size());
+		noise.generate(positions, values);
+
+		std::size_t mismatches = 0;
+		for (std::size_t i = 0; i < positions.size(); i++) {
+			auto expected = noise.getNoise(positions[i].x, positions[i].y,
+			                               positions[i].z);
+			mismatches += values[i] != expected ? 1 : 0;
+		}
+		CHECK(mismatches == 0);
+	}
+}
+
+TEST_CASE("noise-grid-matches-fastnoiselite") {
+	SimplexNoise noise;
+	glm::vec3 origin(-10.f, 3.5f, 100.f);
+	glm::ivec3 size(19, 5, 3);
+	constexpr float Step = 0.7f;
+
+	for (auto simd : kernels()) {
+		noise.setSimd(simd);
+		std::vector<float> values(static_cast<std::size_t>(size.x) * size.y *
+		                          size.z);
+		noise.generateGrid(origin, size, Step, values);
+
+		std::size_t mismatches = 0;
+		for (int z = 0; z < size.z; z++) {
+			for (int y = 0; y < size.y; y++) {
+				for (int x = 0; x < size.x; x++) {
+					auto expected = noise.getNoise(along(origin.x, Step, x),
+					                               along(origin.y, Step, y),
+					                               along(origin.z, Step, z));
+					auto value = values[x + size.x * (y + size.y * z)];
+					mismatches += value != expected ? 1 : 0;
+				}
+			}
+		}
+		CHECK(mismatches == 0);
+	}
+}
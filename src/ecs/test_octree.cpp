@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <gim/svo/octree.hpp>
+#include <glm/glm.hpp>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using gim::svo::Node;
+using gim::svo::SparseVoxelOctree;
+
+namespace {
+using Coordinate = std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>;
+
+auto randomCoordinates(std::uint32_t side, std::size_t count,
+                       std::uint32_t seed) -> std::vector<Coordinate> {
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<std::uint32_t> axis(0, side - 1);
+	std::vector<Coordinate> coordinates;
+	for (std::size_t i = 0; i < count; i++) {
+		coordinates.emplace_back(axis(random), axis(random), axis(random));
+	}
+	return coordinates;
+}
+} // namespace
+
+TEST_CASE("octree-insert-remove-lookup") {
+	SparseVoxelOctree octree(4);
+
+	CHECK(octree.size() == 16);
+	CHECK_FALSE(octree.lookup(3, 5, 7));
+	CHECK(octree.insert(3, 5, 7));
+	CHECK_FALSE(octree.insert(3, 5, 7));
+	CHECK(octree.lookup(3, 5, 7));
+	CHECK_FALSE(octree.lookup(3, 5, 6));
+
+	// One node per level down to the voxel.
+	CHECK(octree.nodeCount() == 4);
+
+	CHECK(octree.remove(3, 5, 7));
+	CHECK_FALSE(octree.remove(3, 5, 7));
+	CHECK_FALSE(octree.lookup(3, 5, 7));
+	CHECK(octree.nodeCount() == 1);
+
+	// Out of bounds voxels are never solid.
+	CHECK_FALSE(octree.insert(16, 0, 0));
+	CHECK_FALSE(octree.lookup(0, 16, 0));
+	CHECK_FALSE(octree.remove(0, 0, 16));
+}
+
+TEST_CASE("octree-solid-octants-collapse") {
+	SparseVoxelOctree octree(3);
+
+	for (std::uint32_t x = 0; x < 4; x++) {
+		for (std::uint32_t y = 0; y < 4; y++) {
+			for (std::uint32_t z = 0; z < 4; z++) {
+				octree.insert(x, y, z);
+			}
+		}
+	}
+
+	// A solid 4^3 octant is a single leaf bit of the root.
+	octree.compact();
+	REQUIRE(octree.nodeCount() == 1);
+	auto root = octree.getNodes()[0];
+	CHECK(root.childMask == 1);
+	CHECK(root.leafMask == 1);
+	CHECK(octree.lookup(3, 3, 3));
+
+	// Carving a voxel out splits the octant again.
+	CHECK(octree.remove(1, 2, 3));
+	CHECK_FALSE(octree.lookup(1, 2, 3));
+	CHECK(octree.lookup(1, 2, 2));
+	CHECK(octree.lookup(3, 3, 3));
+	octree.compact();
+	CHECK(octree.nodeCount() == 3);
+}
+
+TEST_CASE("octree-matches-a-set") {
+	SparseVoxelOctree octree(6);
+	std::set<Coordinate> reference;
+
+	auto inserted = randomCoordinates(64, 20000, 1);
+	for (auto [x, y, z] : inserted) {
+		CHECK(octree.insert(x, y, z) == reference.emplace(x, y, z).second);
+	}
+	auto removed = randomCoordinates(64, 20000, 2);
+	for (auto [x, y, z] : removed) {
+		CHECK(octree.remove(x, y, z) == (reference.erase({x, y, z}) == 1));
+	}
+
+	std::size_t mismatches = 0;
+	for (std::uint32_t x = 0; x < 64; x++) {
+		for (std::uint32_t y = 0; y < 64; y++) {
+			for (std::uint32_t z = 0; z < 64; z++) {
+				if (octree.lookup(x, y, z) != reference.contains({x, y, z})) {
+					mismatches++;
+				}
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+}
+
+TEST_CASE("octree-compact-layout-is-canonical") {
+	auto coordinates = randomCoordinates(32, 3000, 3);
+	SparseVoxelOctree forward(5);
+	SparseVoxelOctree backward(5);
+
+	for (auto [x, y, z] : coordinates) {
+		forward.insert(x, y, z);
+	}
+	std::reverse(coordinates.begin(), coordinates.end());
+	for (auto [x, y, z] : coordinates) {
+		backward.insert(x, y, z);
+	}
+
+	forward.compact();
+	backward.compact();
+	auto a = forward.getNodes();
+	auto b = backward.getNodes();
+	CHECK(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+
+	// Breadth first: children always come after their parent.
+	bool ordered = true;
+	for (std::size_t i = 0; i < a.size(); i++) {
+		if (a[i].nodeMask() != 0 && a[i].firstChild <= i) {
+			ordered = false;
+		}
+	}
+	CHECK(ordered);
+}
+
+TEST_CASE("octree-terrain-memory") {
+	// A rolling heightfield, solid below the surface.
+	SparseVoxelOctree octree(7);
+	for (std::uint32_t x = 0; x < 128; x++) {
+		for (std::uint32_t z = 0; z < 128; z++) {
+			auto height = 40 + x / 8 + z / 16;
+			for (std::uint32_t y = 0; y < height; y++) {
+				octree.insert(x, y, z);
+			}
+		}
+	}
+	octree.compact();
+
+	// Only the surface needs nodes, far fewer than the 850k solid voxels.
+	CHECK(octree.nodeCount() < 128 * 128);
+	CHECK(octree.memoryUsage() == octree.nodeCount() * sizeof(Node));
+	CHECK(octree.lookup(0, 39, 0));
+	CHECK_FALSE(octree.lookup(0, 40, 0));
+}
+
+namespace {
+struct Position {
+	int x;
+	int y;
+	int z;
+};
+
+struct Voxel {
+	Position position;
+};
+
+auto buildsLikeInserting(std::uint32_t depth, std::vector<Voxel> const &voxels)
+	-> bool {
+	SparseVoxelOctree inserted(depth);
+	for (auto const &voxel : voxels) {
+		inserted.insert(static_cast<std::uint32_t>(voxel.position.x),
+		                static_cast<std::uint32_t>(voxel.position.y),
+		                static_cast<std::uint32_t>(voxel.position.z));
+	}
+	inserted.compact();
+
+	SparseVoxelOctree built(depth);
+	built.build<Voxel>(voxels);
+
+	auto a = inserted.getNodes();
+	auto b = built.getNodes();
+	return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+} // namespace
+
+TEST_CASE("octree-build-matches-inserting") {
+	std::vector<Voxel> voxels;
+	for (auto [x, y, z] : randomCoordinates(64, 50000, 4)) {
+		voxels.push_back({{static_cast<int>(x), static_cast<int>(y),
+		                   static_cast<int>(z)}});
+	}
+	// Duplicates and voxels out of bounds are skipped.
+	voxels.push_back(voxels.front());
+	voxels.push_back({{-1, 0, 0}});
+	voxels.push_back({{0, 64, 0}});
+
+	CHECK(buildsLikeInserting(6, voxels));
+	CHECK(buildsLikeInserting(7, voxels));
+}
+
+TEST_CASE("octree-build-float-positions") {
+	struct FloatVoxel {
+		glm::vec3 position;
+	};
+
+	// Positions are rounded down, anything outside the tree (including
+	// the negatives which truncate to 0 and values too large for any
+	// integer) is skipped.
+	std::vector<FloatVoxel> voxels{
+		{glm::vec3(1.5F, 2.F, 3.99F)},
+		{glm::vec3(-0.5F, 0.F, 0.F)},
+		{glm::vec3(0.F, -1e30F, 0.F)},
+		{glm::vec3(0.F, 0.F, 1e30F)},
+		{glm::vec3(7.F, 8.F, 0.F)},
+		{glm::vec3(std::nanf(""), 0.F, 0.F)},
+	};
+
+	SparseVoxelOctree octree(3);
+	octree.build<FloatVoxel>(voxels);
+	CHECK(octree.lookup(1, 2, 3));
+	CHECK_FALSE(octree.lookup(0, 0, 0));
+
+	SparseVoxelOctree expected(3);
+	expected.insert(1, 2, 3);
+	expected.compact();
+	auto a = expected.getNodes();
+	auto b = octree.getNodes();
+	CHECK(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+}
+
+TEST_CASE("octree-build-solid-and-empty") {
+	std::vector<Voxel> voxels;
+	for (int x = 0; x < 8; x++) {
+		for (int y = 0; y < 8; y++) {
+			for (int z = 0; z < 8; z++) {
+				voxels.push_back({{x, y, z}});
+			}
+		}
+	}
+
+	// A completely solid tree is a root of leaves.
+	CHECK(buildsLikeInserting(3, voxels));
+	CHECK(buildsLikeInserting(1, {{{1, 0, 1}}}));
+	CHECK(buildsLikeInserting(4, voxels));
+	CHECK(buildsLikeInserting(4, {}));
+
+	SparseVoxelOctree octree(3);
+	octree.build<Voxel>(voxels);
+	REQUIRE(octree.nodeCount() == 1);
+	CHECK(octree.getNodes()[0].full());
+	CHECK(octree.lookup(7, 7, 7));
+}
+
+TEST_CASE("octree-build-terrain") {
+	std::vector<Voxel> voxels;
+	for (int x = 0; x < 128; x++) {
+		for (int z = 0; z < 128; z++) {
+			for (int y = 0; y < 40 + x / 8 + z / 16; y++) {
+				voxels.push_back({{x, y, z}});
+			}
+		}
+	}
+
+	// Enough voxels to build every level on several threads.
+	gim::library::jobs::JobSystem jobs(3);
+	SparseVoxelOctree octree(7);
+	octree.build<Voxel>(voxels, jobs);
+
+	CHECK(octree.lookup(0, 39, 0));
+	CHECK_FALSE(octree.lookup(0, 40, 0));
+	CHECK(octree.lookup(127, 40 + 15 + 7 - 1, 127));
+	CHECK(buildsLikeInserting(7, voxels));
+}
+
+TEST_CASE("octree-build-cubes-matches-voxels") {
+	constexpr std::uint32_t Depth = 6;
+	constexpr std::uint32_t Side = 1U << Depth;
+	std::mt19937 random(11);
+	std::vector<bool> solid(Side * Side * Side);
+	std::vector<std::vector<std::uint64_t>> cubes(Depth);
+	std::vector<Voxel> voxels;
+
+	// Random cubes of every size, skipping those overlapping earlier ones.
+	for (int attempt = 0; attempt < 400; attempt++) {
+		auto level = static_cast<std::uint32_t>(random() % Depth);
+		auto side = 1U << level;
+		auto cells = Side >> level;
+		auto x = static_cast<std::uint32_t>(random() % cells);
+		auto y = static_cast<std::uint32_t>(random() % cells);
+		auto z = static_cast<std::uint32_t>(random() % cells);
+		std::vector<Voxel> cube;
+		for (auto i = 0U; i < side * side * side; i++) {
+			cube.push_back({{static_cast<int>(x * side + i % side),
+			                 static_cast<int>(y * side + i / side % side),
+			                 static_cast<int>(z * side + i / side / side)}});
+		}
+		auto index = [&](Voxel const &voxel) {
+			return (static_cast<std::size_t>(voxel.position.x) * Side +
+			        static_cast<std::size_t>(voxel.position.y)) *
+			           Side +
+			       static_cast<std::size_t>(voxel.position.z);
+		};
+		if (std::ranges::any_of(
+				cube, [&](Voxel const &voxel) { return solid[index(voxel)]; })) {
+			continue;
+		}
+		cubes[level].push_back(gim::library::morton::encode(x, y, z));
+		for (auto const &voxel : cube) {
+			solid[index(voxel)] = true;
+			voxels.push_back(voxel);
+		}
+	}
+	// Repeated cubes don't matter.
+	cubes[0].push_back(cubes[0].front());
+
+	SparseVoxelOctree fromCubes(Depth);
+	fromCubes.buildCubes(cubes);
+	SparseVoxelOctree fromVoxels(Depth);
+	fromVoxels.build<Voxel>(voxels);
+
+	auto a = fromCubes.getNodes();
+	auto b = fromVoxels.getNodes();
+	CHECK(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+
+	// Eight cubes filling the tree make a full root.
+	std::vector<std::vector<std::uint64_t>> halves(Depth);
+	for (std::uint64_t child = 0; child < 8; child++) {
+		halves[Depth - 1].push_back(child);
+	}
+	fromCubes.buildCubes(halves);
+	REQUIRE(fromCubes.nodeCount() == 1);
+	CHECK(fromCubes.getNodes()[0].full());
+
+	std::vector<std::vector<std::uint64_t>> none(Depth);
+	fromCubes.buildCubes(none);
+	CHECK(fromCubes.nodeCount() == 1);
+	CHECK_FALSE(fromCubes.lookup(0, 0, 0));
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cstdio>
+#include <doctest/doctest.h>
+#include <fstream>
+#include <gim/library/jobs.hpp>
+#include <gim/library/profiler.hpp>
+#include <iterator>
+#include <string>
+
+using namespace gim::library::profiler;
+
+TEST_CASE("profiler") {
+	auto &profiler = Profiler::instance();
+	profiler.collect();
+	profiler.clear();
+
+	gim::library::jobs::JobSystem jobs(3);
+	jobs.parallelFor(400, 1, [](std::size_t begin, std::size_t end) {
+		for (auto i = begin; i < end; i++) {
+			Zone zone("profiler-test \"zone\"");
+		}
+	});
+	{
+		Zone zone(typeName<Profiler>());
+	}
+	profiler.collect();
+
+	auto summary = profiler.summary();
+	auto found = std::find_if(summary.begin(), summary.end(), [](auto &zone) {
+		return zone.name == "profiler-test \"zone\"";
+	});
+	REQUIRE(found != summary.end());
+	CHECK(found->count == 400);
+	CHECK(found->minMicroseconds <= found->avgMicroseconds);
+	CHECK(found->avgMicroseconds <= found->p99Microseconds);
+	CHECK(std::any_of(summary.begin(), summary.end(), [](auto &zone) {
+		return zone.name == "gim::library::profiler::Profiler";
+	}));
+
+	auto path = std::string("profiler-test-trace.json");
+	REQUIRE(profiler.writeChromeTrace(path));
+	std::ifstream file(path);
+	std::string trace((std::istreambuf_iterator<char>(file)),
+					  std::istreambuf_iterator<char>());
+	CHECK(trace.starts_with("{\"traceEvents\":["));
+	CHECK(trace.find("profiler-test \\\"zone\\\"") != std::string::npos);
+	std::remove(path.c_str());
+
+	profiler.clear();
+	CHECK(profiler.summary().empty());
+}
+
+TEST_CASE("profiler-zone-before-epoch") {
+	// A zone which began before the profiler existed, like the first zone
+	// of a program, starts the trace at 0 instead of wrapping around.
+	auto begin = Profiler::clock();
+	Profiler profiler;
+	profiler.record("first", begin, Profiler::clock());
+	profiler.collect();
+
+	auto path = std::string("profiler-epoch-trace.json");
+	REQUIRE(profiler.writeChromeTrace(path));
+	std::ifstream file(path);
+	std::string trace((std::istreambuf_iterator<char>(file)),
+					  std::istreambuf_iterator<char>());
+	std::remove(path.c_str());
+
+	auto ts = trace.find("\"ts\":");
+	REQUIRE(ts != std::string::npos);
+	CHECK(std::stod(trace.substr(ts + 5)) == 0.0);
+}
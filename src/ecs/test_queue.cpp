@@ -0,0 +1,85 @@
+#include <atomic>
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <gim/ecs/components/input.hpp>
+#include <gim/ecs/engine/events.hpp>
+#include <gim/library/queue.hpp>
+#include <thread>
+#include <vector>
+
+using namespace gim::library::queue;
+
+TEST_CASE("mpsc-ring") {
+	MpscRing<int, 4> ring;
+
+	CHECK(!ring.pop().has_value());
+	for (int i = 0; i < 4; i++) {
+		CHECK(ring.push(i));
+	}
+	// Full rings drop instead of blocking.
+	CHECK(!ring.push(4));
+	CHECK(ring.dropped() == 1);
+
+	CHECK(ring.pop() == 0);
+	CHECK(ring.push(5));
+
+	std::vector<int> drained;
+	CHECK(ring.drain([&](int value) { drained.push_back(value); }) == 4);
+	CHECK((drained == std::vector<int>{1, 2, 3, 5}));
+}
+
+TEST_CASE("mpsc-ring-producers") {
+	constexpr int Producers = 4;
+	constexpr int PerProducer = 5000;
+	MpscRing<std::uint32_t, 256> ring;
+	std::atomic<bool> start{false};
+
+	std::vector<std::thread> producers;
+	for (int producer = 0; producer < Producers; producer++) {
+		producers.emplace_back([&, producer] {
+			while (!start.load()) {
+			}
+			for (int i = 0; i < PerProducer; i++) {
+				auto value = static_cast<std::uint32_t>(producer << 16 | i);
+				while (!ring.push(value)) {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	// Every producer's items arrive exactly once and in order.
+	std::vector<int> next(Producers, 0);
+	int received = 0;
+	bool ordered = true;
+	start = true;
+	while (received < Producers * PerProducer) {
+		ring.drain([&](std::uint32_t value) {
+			auto producer = static_cast<int>(value >> 16);
+			ordered = ordered && static_cast<int>(value & 0xFFFFU) ==
+									 next[producer];
+			next[producer]++;
+			received++;
+		});
+	}
+	for (auto &producer : producers) {
+		producer.join();
+	}
+
+	CHECK(ordered);
+	CHECK(!ring.pop().has_value());
+}
+
+TEST_CASE("events") {
+	namespace Input = gim::ecs::components::Input;
+	gim::ecs::Events<Input::Event> events;
+
+	events.send({.type = Input::KeyDown, .key = 'w'});
+	events.send({.type = Input::MouseMotion, .x = 2.F, .y = -1.F});
+	REQUIRE(events.size() == 2);
+	CHECK(events.read()[0].key == 'w');
+	CHECK(events.read()[1].x == 2.F);
+
+	events.clear();
+	CHECK(events.empty());
+}
@@ -57,3 +57,33 @@ TEST_CASE("signature") {
 	CHECK(s3->subsetOf(s3) == true);
 	CHECK(s4->subsetOf(s4) == true);
 }
+
+TEST_CASE("signature-bitset") {
+	Signature all;
+	all.set<TestComponent>();
+	all.set<AnotherComponent>();
+	all.set<YetAnotherComponent>();
+
+	Signature some;
+	some.set<TestComponent>();
+	some.set<AnotherComponent>();
+
+	CHECK(some.subsetOf(all));
+	CHECK_FALSE(all.subsetOf(some));
+	CHECK((all & some) == some);
+	CHECK(all != some);
+
+	// Unsetting after setting clears the bit.
+	all.unset<YetAnotherComponent>();
+	CHECK_FALSE(all.get<YetAnotherComponent>());
+	CHECK(all == some);
+
+	some.reset();
+	CHECK(some.empty());
+
+	// Type ids are stable and shared across cv qualifiers.
+	CHECK(componentTypeId<TestComponent>() ==
+		  componentTypeId<const TestComponent>());
+	CHECK(componentTypeId<TestComponent>() !=
+		  componentTypeId<AnotherComponent>());
+}
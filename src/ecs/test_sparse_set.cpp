@@ -0,0 +1,49 @@
+#include "gim/ecs/engine/sparse_set.hpp"
+#include <doctest/doctest.h>
+
+using namespace gim::ecs;
+
+TEST_CASE("sparse-set") {
+	SparseSet set;
+
+	set.insert(3);
+	set.insert(7);
+	set.insert(100'000);
+
+	CHECK(set.size() == 3);
+	CHECK(set.contains(7));
+	CHECK(set.contains(100'000));
+	CHECK_FALSE(set.contains(4));
+	CHECK(set.index(3) == 0);
+
+	// Inserting twice keeps the original slot.
+	CHECK(set.insert(7) == 1);
+	CHECK(set.size() == 3);
+
+	// Removing moves the last entity into the vacated slot.
+	CHECK(set.erase(3) == 0);
+	CHECK(set.entities()[0] == 100'000);
+	CHECK(set.index(100'000) == 0);
+	CHECK_FALSE(set.contains(3));
+	CHECK(set.erase(3) == SparseSet::npos);
+	CHECK(set.size() == 2);
+}
+
+TEST_CASE("sparse-set-generations") {
+	SparseSet set;
+
+	auto stale = makeEntity(5, 0);
+	auto current = makeEntity(5, 1);
+	set.insert(stale);
+
+	// A handle from another generation of the same slot isn't in the set.
+	CHECK(set.contains(stale));
+	CHECK_FALSE(set.contains(current));
+	CHECK(set.erase(current) == SparseSet::npos);
+
+	// Inserting the new generation takes the slot over.
+	CHECK(set.insert(current) == 0);
+	CHECK(set.contains(current));
+	CHECK_FALSE(set.contains(stale));
+	CHECK(set.size() == 1);
+}
@@ -4,12 +4,17 @@
 #include "gim/ecs/engine/testing.hpp"
 #include <doctest/doctest.h>
 #include <gim/ecs/ecs.hpp>
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace gim::ecs;
 
 TEST_CASE("system-manager") {
-	auto em = std::make_unique<EntityManager<10>>();
+	auto em = std::make_unique<EntityManager>();
 	auto cm = std::make_shared<ComponentManager>();
 	auto sm = SystemManager(cm);
 
@@ -17,9 +22,348 @@ TEST_CASE("system-manager") {
 	sm.registerSystem<TESTING::TestSystem>();
 	auto entity = em->createEntity();
 	cm->addComponent(entity, std::make_shared<TESTING::TestComponent>(1));
-	sm.entitySignatureChanged(entity, em->getSignature(entity));
+	em->getSignature(entity)->set<TESTING::TestComponent>();
+	sm.entitySignatureChanged(entity, *em->getSignature(entity));
 
 	sm.update();
 
 	CHECK(cm->getComponent<TESTING::TestComponent>(entity)->x == 2);
 }
+
+namespace {
+// Records the order systems ran in and which thread ran them.
+struct Trace {
+	std::mutex mutex;
+	std::vector<std::string> ran;
+	std::thread::id mainThreadSystem;
+};
+
+Trace trace;
+
+template <typename Self> class TracingSystem : public ISystem {
+  private:
+	std::shared_ptr<ComponentManager> componentManager;
+
+  public:
+	auto getSignature() -> std::shared_ptr<Signature> override {
+		return std::make_shared<Signature>();
+	}
+	auto update() -> void override {
+		std::lock_guard lock(trace.mutex);
+		trace.ran.emplace_back(Self::name);
+	}
+	auto setComponentManager(std::shared_ptr<ComponentManager> cm)
+		-> void override {
+		componentManager = std::move(cm);
+	}
+	auto getComponentManager() -> std::shared_ptr<ComponentManager> override {
+		return componentManager;
+	}
+};
+
+struct Position {};
+struct Velocity {};
+
+class Integrate : public TracingSystem<Integrate> {
+  public:
+	static constexpr const char *name = "integrate";
+	using Reads = Components<Velocity>;
+	using Writes = Components<Position>;
+	using After = Systems<class Input>;
+};
+
+class Input : public TracingSystem<Input> {
+  public:
+	static constexpr const char *name = "input";
+	using Writes = Components<Velocity>;
+};
+
+class Render : public TracingSystem<Render> {
+  public:
+	static constexpr const char *name = "render";
+	static constexpr bool mainThreadOnly = true;
+	using Reads = Components<Position>;
+
+	auto update() -> void override {
+		TracingSystem<Render>::update();
+		trace.mainThreadSystem = std::this_thread::get_id();
+	}
+};
+
+class Audio : public TracingSystem<Audio> {
+  public:
+	static constexpr const char *name = "audio";
+	using Reads = Components<Position>;
+};
+
+class Present : public TracingSystem<Present> {
+  public:
+	static constexpr const char *name = "present";
+	static constexpr auto stage = Stage::Render;
+	using Writes = Components<Position>;
+};
+} // namespace
+
+TEST_CASE("system-manager-schedule") {
+	gim::library::jobs::JobSystem jobs(3);
+	auto sm = SystemManager(std::make_shared<ComponentManager>(), jobs);
+
+	// Registered out of order, After puts input first.
+	sm.registerSystem<Integrate>();
+	sm.registerSystem<Render>();
+	sm.registerSystem<Audio>();
+	sm.registerSystem<Input>();
+
+	for (int frame = 0; frame < 50; frame++) {
+		trace.ran.clear();
+		sm.update();
+
+		REQUIRE(trace.ran.size() == 4);
+		auto position = [](const std::string &name) {
+			return std::find(trace.ran.begin(), trace.ran.end(), name) -
+				   trace.ran.begin();
+		};
+		CHECK(position("input") < position("integrate"));
+		// Reading positions waits for the system writing them.
+		CHECK(position("integrate") < position("render"));
+		CHECK(position("integrate") < position("audio"));
+		CHECK(trace.mainThreadSystem == std::this_thread::get_id());
+	}
+}
+
+TEST_CASE("system-manager-stages") {
+	gim::library::jobs::JobSystem jobs(3);
+	auto sm = SystemManager(std::make_shared<ComponentManager>(), jobs);
+
+	// Registered first, but only runs in the render stage.
+	sm.registerSystem<Present>();
+	sm.registerSystem<Integrate>();
+	sm.registerSystem<Input>();
+
+	trace.ran.clear();
+	sm.update(Stage::Simulation);
+	sm.update(Stage::Simulation);
+	CHECK(std::count(trace.ran.begin(), trace.ran.end(), "integrate") == 2);
+	CHECK(std::count(trace.ran.begin(), trace.ran.end(), "present") == 0);
+
+	trace.ran.clear();
+	sm.update(Stage::Render);
+	REQUIRE(trace.ran.size() == 1);
+	CHECK(trace.ran[0] == "present");
+
+	// A whole update runs the simulation first.
+	trace.ran.clear();
+	sm.update();
+	REQUIRE(trace.ran.size() == 3);
+	CHECK(trace.ran.back() == "present");
+}
+
+TEST_CASE("system-manager-membership") {
+	auto em = EntityManager();
+	auto cm = std::make_shared<ComponentManager>();
+	auto sm = SystemManager(cm);
+	cm->registerComponent<TESTING::TestComponent>();
+	cm->registerComponent<TESTING::TestValueComponent>();
+	sm.registerSystem<TESTING::TestSystem>();
+	auto &system = sm.getSystem<TESTING::TestSystem>();
+
+	Signature testComponent;
+	testComponent.set<TESTING::TestComponent>();
+	Signature valueComponent;
+	valueComponent.set<TESTING::TestValueComponent>();
+
+	// Entities belong to a system when they have every component the system
+	// requires, extra components don't matter.
+	auto entity = em.createEntity();
+	auto *signature = em.getSignature(entity);
+	*signature = testComponent | valueComponent;
+	sm.entitySignatureChanged(entity, *signature, testComponent);
+	CHECK(system.hasEntity(entity));
+
+	// Changes to components the system doesn't require leave it alone.
+	signature->unset<TESTING::TestValueComponent>();
+	sm.entitySignatureChanged(entity, *signature, valueComponent);
+	CHECK(system.hasEntity(entity));
+
+	signature->unset<TESTING::TestComponent>();
+	sm.entitySignatureChanged(entity, *signature, testComponent);
+	CHECK(!system.hasEntity(entity));
+
+	std::vector<Entity> spawned;
+	for (int i = 0; i < 50'000; i++) {
+		spawned.push_back(em.createEntity());
+		sm.entitySignatureChanged(spawned.back(), testComponent, testComponent);
+	}
+	CHECK(system.getEntities().size() == 50'000);
+
+	for (std::size_t i = 0; i < spawned.size(); i += 2) {
+		sm.entityDestroyed(spawned[i]);
+	}
+	CHECK(system.getEntities().size() == 25'000);
+	CHECK(!system.hasEntity(spawned[0]));
+	CHECK(system.hasEntity(spawned[1]));
+}
+
+namespace {
+template <typename Self> class CountingSystem : public ISystem {
+  private:
+	std::shared_ptr<ComponentManager> componentManager;
+
+  public:
+	int changedCount = 0;
+	int addedCount = 0;
+
+	auto getSignature() -> std::shared_ptr<Signature> override {
+		return std::make_shared<Signature>();
+	}
+	auto setComponentManager(std::shared_ptr<ComponentManager> cm)
+		-> void override {
+		componentManager = std::move(cm);
+	}
+	auto getComponentManager() -> std::shared_ptr<ComponentManager> override {
+		return componentManager;
+	}
+};
+
+// Bumps every value which changed since it last ran.
+class Bump : public CountingSystem<Bump> {
+  public:
+	using Writes = Components<TESTING::TestValueComponent>;
+
+	auto update() -> void override {
+		changedCount = 0;
+		changed<TESTING::TestValueComponent>().each(
+			[&](Entity, TESTING::TestValueComponent &value) {
+				value.x++;
+				changedCount++;
+			});
+	}
+};
+
+class Watch : public CountingSystem<Watch> {
+  public:
+	using Reads = Components<TESTING::TestValueComponent>;
+
+	auto update() -> void override {
+		changedCount = 0;
+		addedCount = 0;
+		changed<const TESTING::TestValueComponent>().each(
+			[&](Entity, const TESTING::TestValueComponent &) {
+				changedCount++;
+			});
+		added<const TESTING::TestValueComponent>().each(
+			[&](Entity, const TESTING::TestValueComponent &) {
+				addedCount++;
+			});
+	}
+};
+} // namespace
+
+TEST_CASE("system-manager-change-ticks") {
+	auto em = EntityManager();
+	auto cm = std::make_shared<ComponentManager>();
+	auto sm = SystemManager(cm);
+	cm->registerComponent<TESTING::TestValueComponent>();
+	sm.registerSystem<Bump>();
+	sm.registerSystem<Watch>();
+	auto &bump = sm.getSystem<Bump>();
+	auto &watch = sm.getSystem<Watch>();
+
+	std::vector<Entity> entities;
+	for (int i = 0; i < 3; i++) {
+		entities.push_back(em.createEntity());
+		cm->emplace<TESTING::TestValueComponent>(entities.back(), i);
+	}
+
+	sm.update();
+	CHECK(bump.changedCount == 3);
+	CHECK(watch.changedCount == 3);
+	CHECK(watch.addedCount == 3);
+
+	// Bump doesn't see its own writes, Watch saw them last update.
+	sm.update();
+	CHECK(bump.changedCount == 0);
+	CHECK(watch.changedCount == 0);
+	CHECK(watch.addedCount == 0);
+
+	// Reading through a const view doesn't count as a change.
+	int total = 0;
+	cm->view<const TESTING::TestValueComponent>().each(
+		[&](Entity, const TESTING::TestValueComponent &value) {
+			total += value.x;
+		});
+	CHECK(total == 6);
+	cm->get<TESTING::TestValueComponent>(entities[1]).x = 10;
+
+	sm.update();
+	CHECK(bump.changedCount == 1);
+	CHECK(watch.changedCount == 1);
+	CHECK(watch.addedCount == 0);
+	CHECK(cm->get<TESTING::TestValueComponent>(entities[1]).x == 11);
+
+	// Iterating a filtered view skips entities which didn't change.
+	auto since = cm->advanceTick();
+	cm->get<TESTING::TestValueComponent>(entities[2]).x = 20;
+	std::vector<Entity> changed;
+	for (auto [entity, value] :
+		 cm->view<const TESTING::TestValueComponent>().changedSince(since)) {
+		changed.push_back(entity);
+	}
+	CHECK(changed == std::vector<Entity>{entities[2]});
+}
+
+namespace {
+struct Score {
+	int points = 0;
+};
+
+class Scorer : public CountingSystem<Scorer> {
+  public:
+	using WritesResources = Resources<Score>;
+
+	auto update() -> void override { resource<Score>().points++; }
+};
+
+class ScoreBoard : public CountingSystem<ScoreBoard> {
+  public:
+	using ReadsResources = Resources<Score>;
+
+	int shown = 0;
+
+	auto update() -> void override {
+		changedCount = 0;
+		if (resourceChanged<Score>()) {
+			shown = resource<const Score>().points;
+			changedCount++;
+		}
+	}
+};
+} // namespace
+
+TEST_CASE("system-manager-resources") {
+	auto access = SystemAccess::of<Scorer>();
+	CHECK(!access.exclusive);
+	CHECK(access.conflictsWith(SystemAccess::of<ScoreBoard>()));
+	CHECK(!SystemAccess::of<ScoreBoard>().conflictsWith(
+		SystemAccess::of<Watch>()));
+
+	auto cm = std::make_shared<ComponentManager>();
+	auto resources = ResourceManager();
+	resources.insert(std::make_shared<Score>(), cm->currentTick());
+
+	auto sm = SystemManager(cm);
+	sm.setResourceManager(&resources);
+	sm.registerSystem<ScoreBoard>();
+	sm.registerSystem<Scorer>();
+	auto &board = sm.getSystem<ScoreBoard>();
+
+	// The board runs first, so it sees each point one update later.
+	sm.update();
+	CHECK(board.changedCount == 1);
+	CHECK(board.shown == 0);
+
+	sm.update();
+	CHECK(board.changedCount == 1);
+	CHECK(board.shown == 1);
+	CHECK(resources.get<const Score>(cm->currentTick()).points == 2);
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <gim/svo/terrain.hpp>
+#include <random>
+#include <vector>
+
+using gim::svo::Column;
+using gim::svo::SparseVoxelOctree;
+
+namespace {
+struct Position {
+	int x;
+	int y;
+	int z;
+};
+
+struct Voxel {
+	Position position;
+};
+
+auto isSolid(Column const &column, int y) -> bool {
+	if (y < column.floor) {
+		return true;
+	}
+	auto i = y - column.floor;
+	return i < 32 && (column.band >> i & 1U) != 0;
+}
+
+auto cubeCount(std::vector<std::vector<std::uint64_t>> const &cubes)
+	-> std::size_t {
+	std::size_t count = 0;
+	for (auto const &level : cubes) {
+		count += level.size();
+	}
+	return count;
+}
+} // namespace
+
+TEST_CASE("terrain-cubes-fill-columns") {
+	constexpr std::uint32_t Depth = 5;
+	constexpr int Side = 1 << Depth;
+	std::mt19937 random(5);
+	std::vector<Column> columns(Side * Side);
+	std::vector<Voxel> voxels;
+	for (int z = 0; z < Side; z++) {
+		for (int x = 0; x < Side; x++) {
+			auto &column = columns[z * Side + x];
+			column.floor = 8 + x / 4 + static_cast<int>(random() % 3);
+			column.band = static_cast<std::uint32_t>(random()) &
+			              ((1U << (Side - column.floor)) - 1U);
+			for (int y = 0; y < Side; y++) {
+				if (isSolid(column, y)) {
+					voxels.push_back({{x, y, z}});
+				}
+			}
+		}
+	}
+
+	auto cubes = TerrainGenerator::solidCubes(columns, Depth);
+	SparseVoxelOctree fromCubes(Depth);
+	fromCubes.buildCubes(cubes);
+	SparseVoxelOctree fromVoxels(Depth);
+	fromVoxels.build<Voxel>(voxels);
+
+	auto a = fromCubes.getNodes();
+	auto b = fromVoxels.getNodes();
+	CHECK(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+
+	// Flat ground half way up is four cubes, whatever is below it.
+	std::vector<Column> flat(Side * Side, Column{.floor = Side / 2});
+	CHECK(cubeCount(TerrainGenerator::solidCubes(flat, Depth)) == 4);
+}
+
+TEST_CASE("terrain-columns-follow-the-noise") {
+	constexpr std::uint32_t Depth = 7;
+	constexpr int Side = 1 << Depth;
+	TerrainGenerator terrain;
+	SimplexNoise noise;
+	auto columns = terrain.generateColumns(Side);
+	REQUIRE(columns.size() == Side * Side);
+
+	SparseVoxelOctree octree(Depth);
+	terrain.generate(octree);
+	bool matches = true;
+	for (int z = 0; z < Side; z++) {
+		for (int x = 0; x < Side; x++) {
+			auto const &column = columns[z * Side + x];
+			auto height = TerrainGenerator::BaseHeight +
+			              TerrainGenerator::HeightAmplitude *
+			                  noise.getNoise(static_cast<float>(x), 0.f,
+			                                 static_cast<float>(z));
+			auto expected = static_cast<int>(std::floor(height)) -
+			                TerrainGenerator::BandHeight / 2;
+			// Batches may round differently right at a voxel boundary.
+			matches = matches && std::abs(column.floor - expected) <= 1;
+
+			for (int y = 0; y < Side; y++) {
+				matches = matches &&
+				          octree.lookup(static_cast<std::uint32_t>(x),
+				                        static_cast<std::uint32_t>(y),
+				                        static_cast<std::uint32_t>(z)) ==
+				              isSolid(column, y);
+			}
+		}
+	}
+	CHECK(matches);
+}
@@ -1,6 +1,7 @@
 #include <filesystem>
 #include <fstream>
 #include <gim/library/fs.hpp>
+#include <gim/library/profiler.hpp>
 #include <iostream>
 
 namespace gim::library::fs {
@@ -10,6 +11,7 @@ auto getFSPrefix() -> std::string {
 }
 
 auto readFile(const std::string &filename) -> std::vector<char> {
+    GIM_PROFILE_ZONE("fs::readFile");
     auto prefix = getFSPrefix();
     std::cout << std::filesystem::current_path() << std::endl;
     std::cout << "PREFIX: " << prefix << std::endl;
@@ -31,4 +33,12 @@ auto readFile(const std::string &filename) -> std::vector<char> {
 
     return buffer;
 };
+
+auto readFileAsync(const std::string &filename, jobs::Counter &counter,
+                   jobs::JobSystem &jobs) -> std::shared_ptr<std::vector<char>> {
+    auto buffer = std::make_shared<std::vector<char>>();
+    jobs.submit([filename, buffer] { *buffer = readFile(filename); }, counter,
+                jobs::Priority::Background);
+    return buffer;
+}
 } // namespace gim::library::fs
@@ -1,48 +1,129 @@
+#include <SDL2/SDL.h>
 #include <SDL_video.h>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <gim/ecs/components/camera.hpp>
 #include <gim/ecs/components/engine-state.hpp>
+#include <gim/ecs/components/input.hpp>
 #include <gim/ecs/components/shader-base.hpp>
 #include <gim/ecs/components/triangle-shader.hpp>
 #include <gim/ecs/ecs.hpp>
+#include <gim/ecs/systems/camera.hpp>
+#include <gim/ecs/systems/input.hpp>
 #include <gim/ecs/systems/vulkan.hpp>
+#include <gim/library/arena.hpp>
+#include <gim/library/fs.hpp>
+#include <gim/library/jobs.hpp>
+#include <gim/library/loop.hpp>
+#include <gim/library/profiler.hpp>
 #include <glm/fwd.hpp>
 #include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
 
 struct VertexData {};
 
+namespace Input = gim::ecs::components::Input;
+
+// SDL stamps events in milliseconds since it was initialised, move that
+// onto the profiler's clock by how long ago it was.
+auto profilerTime(Uint32 timestamp) -> std::uint64_t {
+    auto now = gim::library::profiler::Profiler::clock();
+    // Unsigned, so this survives SDL_GetTicks() wrapping around.
+    auto age = static_cast<std::uint64_t>(SDL_GetTicks() - timestamp) *
+               1'000'000U;
+    return now > age ? now - age : 0;
+}
+
+// Move SDL's events into the input queue. Called at the start of every
+// frame, before every simulation step and while the loop waits for the
+// next frame. SDL2 only reads events from the OS when pumped, so this is
+// what bounds how late they are stamped.
+auto pumpInput(Input::Queue &queue) -> void {
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        Input::Event input{.timestamp = profilerTime(event.common.timestamp)};
+
+        switch (event.type) {
+        case SDL_QUIT:
+            input.type = Input::Quit;
+            break;
+        case SDL_KEYDOWN:
+            if (event.key.repeat != 0) {
+                continue;
+            }
+            input.type = Input::KeyDown;
+            input.key = event.key.keysym.sym;
+            break;
+        case SDL_KEYUP:
+            input.type = Input::KeyUp;
+            input.key = event.key.keysym.sym;
+            break;
+        case SDL_MOUSEMOTION:
+            input.type = Input::MouseMotion;
+            input.x = static_cast<float>(event.motion.xrel);
+            input.y = static_cast<float>(event.motion.yrel);
+            break;
+        default:
+            continue;
+        }
+
+        queue.push(input);
+    }
+}
+
 auto main() -> int {
+    // Created first, so this is its main thread.
+    auto &jobs = gim::library::jobs::JobSystem::instance();
     auto ecs = std::make_shared<gim::ecs::ECS>();
 
+    // Load the shaders in the background while the world is set up.
+    gim::library::jobs::Counter loading;
+    auto triangleVertexCode =
+        gim::library::fs::readFileAsync("shaders/triangle.vert.spv", loading);
+
 #pragma mark - Register components
 
     // Register all the components.
-    ecs->registerComponent<gim::ecs::components::EngineState::Component>();
     ecs->registerComponent<gim::ecs::components::Shader::Component>();
     ecs->registerComponent<gim::ecs::components::Shader::ShaderBuilder>();
     ecs->registerComponent<gim::ecs::components::Shader::TriangleShader>();
-    ecs->registerComponent<gim::ecs::components::Camera::Component>();
 
 #pragma mark - Systems
     // Register all the systems.
+    ecs->registerSystem<gim::ecs::systems::InputSystem>();
+    ecs->registerSystem<gim::ecs::systems::CameraSystem>();
     ecs->registerSystem<gim::ecs::systems::VulkanRendererSystem>();
 
 #pragma mark - Game content
 
-    // Track internal state.
-    auto cameraEntity = ecs->createEntity();
-    auto engineStateEntity = ecs->createEntity();
+    // Track internal state, engine wide singletons live as resources.
     auto engineState =
         std::make_shared<gim::ecs::components::EngineState::Component>();
     auto camera = std::make_shared<gim::ecs::components::Camera::Component>();
+    ecs->insertResource(engineState);
+    ecs->insertResource(camera);
+    ecs->emplaceResource<gim::library::loop::FrameTime>();
+
+    // Input goes through a queue any thread can push into, the input system
+    // turns it into the tick's events.
+    auto inputQueue = std::make_shared<Input::Queue>();
+    ecs->insertResource(inputQueue);
+    ecs->emplaceResource<Input::State>();
+    ecs->emplaceResource<gim::ecs::Events<Input::Event>>();
 
 #pragma mark - Shaders
 
+    jobs.wait(loading);
     auto triangleShaderEntity = ecs->createEntity();
     auto triangleShaderBuilder =
         std::make_shared<gim::ecs::components::Shader::ShaderBuilder>();
     triangleShaderBuilder
-        ->setVertexSprv(gim::library::fs::readFile("shaders/triangle.vert.spv"))
+        ->setVertexSprv(std::move(*triangleVertexCode))
         ->setVertices(std::vector<gim::ecs::components::Shader::Vertex>{
             {
                 .position = glm::vec3{1.F, 1.F, 0.F},
@@ -63,15 +144,61 @@ auto main() -> int {
 #pragma mark - Add components
 
     // Register the components.
-    ecs->addComponent(cameraEntity, camera);
-    ecs->addComponent(engineStateEntity, engineState);
     ecs->addComponent(triangleShaderEntity, triangleShaderBuilder);
 
 #pragma mark - Run the game.
 
+    // The simulation runs at a fixed rate, frames are drawn as fast as
+    // presenting allows or GIM_MAX_FPS frames per second. A value which
+    // isn't a positive number is ignored.
+    gim::library::loop::Settings settings;
+    if (auto const *maxFrameRate = std::getenv("GIM_MAX_FPS")) {
+        double rate = 0;
+        auto const *end = maxFrameRate + std::strlen(maxFrameRate);
+        auto [parsed, error] = std::from_chars(maxFrameRate, end, rate);
+        if (error == std::errc{} && parsed == end && std::isfinite(rate) &&
+            rate > 0) {
+            settings.maxFrameRate = rate;
+        }
+    }
+    gim::library::loop::FixedTimestep loop(settings);
+
     while (engineState->state != gim::ecs::components::EngineState::Quitting) {
-        ecs->update();
+        {
+            GIM_PROFILE_ZONE("frame");
+            jobs.runMainThreadJobs();
+            pumpInput(*inputQueue);
+            loop.frame(
+                [&](gim::library::loop::FrameTime const &time) {
+                    pumpInput(*inputQueue);
+                    ecs->resource<gim::library::loop::FrameTime>() = time;
+                    ecs->simulate();
+                },
+                [&](gim::library::loop::FrameTime const &time) {
+                    ecs->resource<gim::library::loop::FrameTime>() = time;
+                    ecs->render();
+                },
+                [&] { pumpInput(*inputQueue); });
+        }
+        GIM_PROFILE_COLLECT();
     }
 
+#ifdef GIM_PROFILE
+    auto &profiler = gim::library::profiler::Profiler::instance();
+    for (auto const &zone : profiler.summary()) {
+        fmt::print("{:<48} min {:>9.1f}us avg {:>9.1f}us p99 {:>9.1f}us\n",
+                   zone.name, zone.minMicroseconds, zone.avgMicroseconds,
+                   zone.p99Microseconds);
+    }
+    profiler.writeChromeTrace("gim-trace.json");
+
+    // Frames that stopped growing reuse the arena's block, so this only
+    // counts the warm-up.
+    auto arenas = gim::library::memory::FrameArenas::instance().getStats();
+    fmt::print("frame arenas: {} allocations, {} bytes, {} upstream "
+               "allocations\n",
+               arenas.allocations, arenas.bytes, arenas.upstreamAllocations);
+#endif
+
     return EXIT_SUCCESS;
 }
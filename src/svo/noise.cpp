@@ -0,0 +1,435 @@
+// FastNoiseLite rounds after every multiply and add, and the kernels have
+// to as well to give the same results bit for bit. GCC and Clang would
+// otherwise fuse them into FMAs wherever the target allows it, so this
+// comes before FastNoiseLite is included.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <gim/svo/noise.hpp>
+
+using gim::svo::Simd;
+
+// The SIMD kernels are written once with GCC/Clang vector extensions and
+// compiled for every instruction set through target attributes, so the
+// rest of the build doesn't need -mavx2.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define GIM_NOISE_SIMD
+#endif
+
+#ifdef GIM_NOISE_SIMD
+namespace {
+constexpr std::uint32_t PrimeX = 501125321U;
+constexpr std::uint32_t PrimeY = 1136930381U;
+constexpr std::uint32_t PrimeZ = 1720413743U;
+
+template <int Width> struct Lanes {
+    using Floats [[gnu::vector_size(Width * sizeof(float))]] = float;
+    using Ints
+        [[gnu::vector_size(Width * sizeof(std::int32_t))]] = std::int32_t;
+    using Bits
+        [[gnu::vector_size(Width * sizeof(std::uint32_t))]] = std::uint32_t;
+};
+
+// Vectors are only passed by reference between the kernel's functions, by
+// value their ABI would depend on the instruction set. Masks are computed
+// with integer arithmetic rather than comparisons, GCC picks the type of a
+// comparison before inlining, which makes AVX-512 fall back to scalar code.
+
+/**
+ * @brief All bits set in the lanes where a > 0, none elsewhere.
+ */
+template <int Width>
+[[gnu::always_inline]] inline void
+positive(typename Lanes<Width>::Floats const &a,
+         typename Lanes<Width>::Ints &mask) {
+    using Bits = typename Lanes<Width>::Bits;
+    Bits bits = reinterpret_cast<Bits>(a);
+    // Only positive floats are positive integers with their negation
+    // negative, which rules out 0, -0 and the negatives.
+    mask = reinterpret_cast<typename Lanes<Width>::Ints>((0U - bits) & ~bits) >>
+           31;
+}
+
+/**
+ * @brief Add the contribution of the lattice point at x, y, z (already
+ * multiplied by the primes) to the lanes where mask is set.
+ */
+template <int Width>
+[[gnu::always_inline]] inline void
+contribute(typename Lanes<Width>::Floats &value,
+           typename Lanes<Width>::Ints const &mask,
+           typename Lanes<Width>::Floats const &a, std::uint32_t seed,
+           typename Lanes<Width>::Bits const &x,
+           typename Lanes<Width>::Bits const &y,
+           typename Lanes<Width>::Bits const &z,
+           typename Lanes<Width>::Floats const &dx,
+           typename Lanes<Width>::Floats const &dy,
+           typename Lanes<Width>::Floats const &dz) {
+    using Floats = typename Lanes<Width>::Floats;
+    using Bits = typename Lanes<Width>::Bits;
+    Bits hash = (seed ^ x ^ y ^ z) * 0x27d4eb2dU;
+    hash = ((hash ^ (hash >> 15U)) >> 2U) & 63U;
+
+    // FastNoiseLite's 64 gradients are the 12 cube edges five times over,
+    // then edges 8, 1, 9 and 3, so compute the edge rather than look it up.
+    Bits edge = hash - 12U * ((hash * 171U) >> 11U);
+    Bits odd = 0U - (hash & 1U);
+    Bits extra =
+        ((1U + (hash & 2U)) & odd) | ((8U + ((hash & 2U) >> 1U)) & ~odd);
+    Bits last = 0U - ((hash + 4U) >> 6U);
+    edge = (extra & last) | (edge & ~last);
+
+    // Edges 0-3 lie along x, 4-7 along y and 8-11 along z, the first two
+    // bits give the signs of the other two axes.
+    Bits group = edge >> 2U;
+    Bits alongX = 0U - (((group | (group >> 1U)) & 1U) ^ 1U);
+    Bits alongZ = 0U - (group >> 1U);
+    Bits u = (reinterpret_cast<Bits>(dy) & alongX) |
+             (reinterpret_cast<Bits>(dx) & ~alongX);
+    Bits v = (reinterpret_cast<Bits>(dy) & alongZ) |
+             (reinterpret_cast<Bits>(dz) & ~alongZ);
+    u ^= (edge & 1U) << 31U;
+    v ^= (edge & 2U) << 30U;
+    Floats gradient = reinterpret_cast<Floats>(u) + reinterpret_cast<Floats>(v);
+
+    Floats a2 = a * a;
+    Floats contribution = (a2 * a2) * gradient;
+    value += reinterpret_cast<Floats>(reinterpret_cast<Bits>(contribution) &
+                                      reinterpret_cast<Bits>(mask));
+}
+
+/**
+ * @brief FastNoiseLite's SingleOpenSimplex2S, with every branch turned into
+ * a mask so each lane takes its own.
+ */
+template <int Width>
+[[gnu::always_inline]] inline void
+evaluate(typename Lanes<Width>::Floats const &px,
+         typename Lanes<Width>::Floats const &py,
+         typename Lanes<Width>::Floats const &pz,
+         typename Lanes<Width>::Floats &value) {
+    using Floats = typename Lanes<Width>::Floats;
+    using Ints = typename Lanes<Width>::Ints;
+    using Bits = typename Lanes<Width>::Bits;
+    constexpr auto Seed = static_cast<std::uint32_t>(SimplexNoise::Seed);
+    constexpr std::uint32_t Seed2 = Seed + 1293373U;
+
+    // Frequency and FastNoiseLite's default 3D rotation.
+    Floats x = px * SimplexNoise::Frequency;
+    Floats y = py * SimplexNoise::Frequency;
+    Floats z = pz * SimplexNoise::Frequency;
+    Floats r = (x + y + z) * (2.0f / 3.0f);
+    x = r - x;
+    y = r - y;
+    z = r - z;
+
+    // FastFloor, which rounds negative integers down too. The sign bit is
+    // as good as x < 0 since the rotation never gives -0.
+    Ints i = __builtin_convertvector(x, Ints) +
+             (reinterpret_cast<Ints>(x) >> 31);
+    Ints j = __builtin_convertvector(y, Ints) +
+             (reinterpret_cast<Ints>(y) >> 31);
+    Ints k = __builtin_convertvector(z, Ints) +
+             (reinterpret_cast<Ints>(z) >> 31);
+    Floats xi = x - __builtin_convertvector(i, Floats);
+    Floats yi = y - __builtin_convertvector(j, Floats);
+    Floats zi = z - __builtin_convertvector(k, Floats);
+    Bits ip = reinterpret_cast<Bits>(i) * PrimeX;
+    Bits jp = reinterpret_cast<Bits>(j) * PrimeY;
+    Bits kp = reinterpret_cast<Bits>(k) * PrimeZ;
+
+    Ints xNMask = __builtin_convertvector(-0.5f - xi, Ints);
+    Ints yNMask = __builtin_convertvector(-0.5f - yi, Ints);
+    Ints zNMask = __builtin_convertvector(-0.5f - zi, Ints);
+    Bits xN = reinterpret_cast<Bits>(xNMask);
+    Bits yN = reinterpret_cast<Bits>(yNMask);
+    Bits zN = reinterpret_cast<Bits>(zNMask);
+    // +-1, towards the second nearest point on each axis.
+    Floats xs = __builtin_convertvector(xNMask | 1, Floats);
+    Floats ys = __builtin_convertvector(yNMask | 1, Floats);
+    Floats zs = __builtin_convertvector(zNMask | 1, Floats);
+
+    Ints all = Ints{} - 1;
+    value = Floats{};
+
+    Floats x0 = xi + __builtin_convertvector(xNMask, Floats);
+    Floats y0 = yi + __builtin_convertvector(yNMask, Floats);
+    Floats z0 = zi + __builtin_convertvector(zNMask, Floats);
+    Floats a0 = 0.75f - x0 * x0 - y0 * y0 - z0 * z0;
+    contribute<Width>(value, all, a0, Seed, ip + (xN & PrimeX),
+                      jp + (yN & PrimeY), kp + (zN & PrimeZ), x0, y0, z0);
+
+    Floats x1 = xi - 0.5f;
+    Floats y1 = yi - 0.5f;
+    Floats z1 = zi - 0.5f;
+    Floats a1 = 0.75f - x1 * x1 - y1 * y1 - z1 * z1;
+    contribute<Width>(value, all, a1, Seed2, ip + PrimeX, jp + PrimeY,
+                      kp + PrimeZ, x1, y1, z1);
+
+    Floats xAFlipMask0 = (2.0f * xs) * x1;
+    Floats yAFlipMask0 = (2.0f * ys) * y1;
+    Floats zAFlipMask0 = (2.0f * zs) * z1;
+    Floats xAFlipMask1 =
+        __builtin_convertvector(-2 - (xNMask << 2), Floats) * x1 - 1.0f;
+    Floats yAFlipMask1 =
+        __builtin_convertvector(-2 - (yNMask << 2), Floats) * y1 - 1.0f;
+    Floats zAFlipMask1 =
+        __builtin_convertvector(-2 - (zNMask << 2), Floats) * z1 - 1.0f;
+
+    Floats a2 = xAFlipMask0 + a0;
+    Ints m2;
+    positive<Width>(a2, m2);
+    contribute<Width>(value, m2, a2, Seed, ip + (~xN & PrimeX),
+                      jp + (yN & PrimeY), kp + (zN & PrimeZ), x0 - xs, y0,
+                      z0);
+    Floats a3 = yAFlipMask0 + zAFlipMask0 + a0;
+    Ints m3;
+    positive<Width>(a3, m3);
+    contribute<Width>(value, ~m2 & m3, a3, Seed, ip + (xN & PrimeX),
+                      jp + (~yN & PrimeY), kp + (~zN & PrimeZ), x0, y0 - ys,
+                      z0 - zs);
+    Floats a4 = xAFlipMask1 + a1;
+    Ints m4;
+    positive<Width>(a4, m4);
+    m4 &= ~m2;
+    contribute<Width>(value, m4, a4, Seed2, ip + (xN & (PrimeX * 2)),
+                      jp + PrimeY, kp + PrimeZ, xs + x1, y1, z1);
+
+    Floats a6 = yAFlipMask0 + a0;
+    Ints m6;
+    positive<Width>(a6, m6);
+    contribute<Width>(value, m6, a6, Seed, ip + (xN & PrimeX),
+                      jp + (~yN & PrimeY), kp + (zN & PrimeZ), x0, y0 - ys,
+                      z0);
+    Floats a7 = xAFlipMask0 + zAFlipMask0 + a0;
+    Ints m7;
+    positive<Width>(a7, m7);
+    contribute<Width>(value, ~m6 & m7, a7, Seed, ip + (~xN & PrimeX),
+                      jp + (yN & PrimeY), kp + (~zN & PrimeZ), x0 - xs, y0,
+                      z0 - zs);
+    Floats a8 = yAFlipMask1 + a1;
+    Ints m8;
+    positive<Width>(a8, m8);
+    m8 &= ~m6;
+    contribute<Width>(value, m8, a8, Seed2, ip + PrimeX,
+                      jp + (yN & (PrimeY << 1U)), kp + PrimeZ, x1, ys + y1,
+                      z1);
+
+    Floats aA = zAFlipMask0 + a0;
+    Ints mA;
+    positive<Width>(aA, mA);
+    contribute<Width>(value, mA, aA, Seed, ip + (xN & PrimeX),
+                      jp + (yN & PrimeY), kp + (~zN & PrimeZ), x0, y0,
+                      z0 - zs);
+    Floats aB = xAFlipMask0 + yAFlipMask0 + a0;
+    Ints mB;
+    positive<Width>(aB, mB);
+    contribute<Width>(value, ~mA & mB, aB, Seed, ip + (~xN & PrimeX),
+                      jp + (~yN & PrimeY), kp + (zN & PrimeZ), x0 - xs,
+                      y0 - ys, z0);
+    Floats aC = zAFlipMask1 + a1;
+    Ints mC;
+    positive<Width>(aC, mC);
+    mC &= ~mA;
+    contribute<Width>(value, mC, aC, Seed2, ip + PrimeX, jp + PrimeY,
+                      kp + (zN & (PrimeZ << 1U)), x1, y1, zs + z1);
+
+    Floats a5 = yAFlipMask1 + zAFlipMask1 + a1;
+    Ints m5;
+    positive<Width>(a5, m5);
+    contribute<Width>(value, ~m4 & m5, a5, Seed2, ip + PrimeX,
+                      jp + (yN & (PrimeY << 1U)), kp + (zN & (PrimeZ << 1U)),
+                      x1, ys + y1, zs + z1);
+    Floats a9 = xAFlipMask1 + zAFlipMask1 + a1;
+    Ints m9;
+    positive<Width>(a9, m9);
+    contribute<Width>(value, ~m8 & m9, a9, Seed2,
+                      ip + (xN & (PrimeX * 2)), jp + PrimeY,
+                      kp + (zN & (PrimeZ << 1U)), xs + x1, y1, zs + z1);
+    Floats aD = xAFlipMask1 + yAFlipMask1 + a1;
+    Ints mD;
+    positive<Width>(aD, mD);
+    contribute<Width>(value, ~mC & mD, aD, Seed2,
+                      ip + (xN & (PrimeX << 1U)), jp + (yN & (PrimeY << 1U)),
+                      kp + PrimeZ, xs + x1, ys + y1, z1);
+
+    value *= 9.046026385208288f;
+}
+
+template <int Width>
+[[gnu::always_inline]] inline void
+generatePositions(std::span<const glm::vec3> positions, std::span<float> out) {
+    using Floats = typename Lanes<Width>::Floats;
+    for (std::size_t begin = 0; begin < positions.size(); begin += Width) {
+        auto lanes = std::min<std::size_t>(Width, positions.size() - begin);
+        Floats x{};
+        Floats y{};
+        Floats z{};
+        for (std::size_t lane = 0; lane < lanes; lane++) {
+            x[lane] = positions[begin + lane].x;
+            y[lane] = positions[begin + lane].y;
+            z[lane] = positions[begin + lane].z;
+        }
+
+        Floats value;
+        evaluate<Width>(x, y, z, value);
+        for (std::size_t lane = 0; lane < lanes; lane++) {
+            out[begin + lane] = value[lane];
+        }
+    }
+}
+
+template <int Width>
+[[gnu::always_inline]] inline void generateGrid(glm::vec3 origin,
+                                                glm::ivec3 size, float step,
+                                                std::span<float> out) {
+    using Floats = typename Lanes<Width>::Floats;
+    Floats offsets;
+    for (int lane = 0; lane < Width; lane++) {
+        offsets[lane] = static_cast<float>(lane);
+    }
+
+    std::size_t index = 0;
+    for (int z = 0; z < size.z; z++) {
+        for (int y = 0; y < size.y; y++) {
+            Floats ys = Floats{} + (origin.y + step * static_cast<float>(y));
+            Floats zs = Floats{} + (origin.z + step * static_cast<float>(z));
+            for (int x = 0; x < size.x; x += Width) {
+                auto lanes = std::min(Width, size.x - x);
+                Floats xs =
+                    origin.x + step * (static_cast<float>(x) + offsets);
+
+                Floats value;
+                evaluate<Width>(xs, ys, zs, value);
+                for (int lane = 0; lane < lanes; lane++) {
+                    out[index++] = value[lane];
+                }
+            }
+        }
+    }
+}
+
+[[gnu::target("avx512f,avx512dq")]] void
+generateAvx512(std::span<const glm::vec3> positions, std::span<float> out) {
+    generatePositions<16>(positions, out);
+}
+
+[[gnu::target("avx2,fma")]] void
+generateAvx2(std::span<const glm::vec3> positions, std::span<float> out) {
+    generatePositions<8>(positions, out);
+}
+
+void generateSse2(std::span<const glm::vec3> positions, std::span<float> out) {
+    generatePositions<4>(positions, out);
+}
+
+[[gnu::target("avx512f,avx512dq")]] void generateGridAvx512(glm::vec3 origin,
+                                                   glm::ivec3 size, float step,
+                                                   std::span<float> out) {
+    generateGrid<16>(origin, size, step, out);
+}
+
+[[gnu::target("avx2,fma")]] void generateGridAvx2(glm::vec3 origin,
+                                                  glm::ivec3 size, float step,
+                                                  std::span<float> out) {
+    generateGrid<8>(origin, size, step, out);
+}
+
+void generateGridSse2(glm::vec3 origin, glm::ivec3 size, float step,
+                      std::span<float> out) {
+    generateGrid<4>(origin, size, step, out);
+}
+} // namespace
+#endif
+
+auto gim::svo::detectSimd() -> Simd {
+#ifdef GIM_NOISE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512dq")) {
+        return Simd::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return Simd::Avx2;
+    }
+    return Simd::Sse2;
+#else
+    return Simd::Scalar;
+#endif
+}
+
+SimplexNoise::SimplexNoise() : noise(Seed), simd(gim::svo::detectSimd()) {
+    noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2S);
+    noise.SetFrequency(Frequency);
+}
+
+float SimplexNoise::getNoise(float x, float y, float z) const {
+    return noise.GetNoise(x, y, z);
+}
+
+void SimplexNoise::generate(std::span<const glm::vec3> positions,
+                            std::span<float> out) const {
+    assert(out.size() >= positions.size() && "Not enough room for the noise.");
+
+    switch (simd) {
+#ifdef GIM_NOISE_SIMD
+    case Simd::Avx512:
+        generateAvx512(positions, out);
+        return;
+    case Simd::Avx2:
+        generateAvx2(positions, out);
+        return;
+    case Simd::Sse2:
+        generateSse2(positions, out);
+        return;
+#endif
+    default:
+        for (std::size_t i = 0; i < positions.size(); i++) {
+            out[i] = getNoise(positions[i].x, positions[i].y, positions[i].z);
+        }
+    }
+}
+
+void SimplexNoise::generateGrid(glm::vec3 origin, glm::ivec3 size, float step,
+                                std::span<float> out) const {
+    assert(out.size() >= static_cast<std::size_t>(size.x) * size.y * size.z &&
+           "Not enough room for the noise.");
+
+    switch (simd) {
+#ifdef GIM_NOISE_SIMD
+    case Simd::Avx512:
+        generateGridAvx512(origin, size, step, out);
+        return;
+    case Simd::Avx2:
+        generateGridAvx2(origin, size, step, out);
+        return;
+    case Simd::Sse2:
+        generateGridSse2(origin, size, step, out);
+        return;
+#endif
+    default:
+        std::size_t index = 0;
+        for (int z = 0; z < size.z; z++) {
+            for (int y = 0; y < size.y; y++) {
+                for (int x = 0; x < size.x; x++) {
+                    out[index++] =
+                        getNoise(origin.x + step * static_cast<float>(x),
+                                 origin.y + step * static_cast<float>(y),
+                                 origin.z + step * static_cast<float>(z));
+                }
+            }
+        }
+    }
+}
+
+void SimplexNoise::setSimd(Simd simd) {
+    this->simd = std::min(simd, gim::svo::detectSimd());
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <gim/library/morton.hpp>
+#include <gim/svo/terrain.hpp>
+#include <glm/glm.hpp>
+
+using gim::svo::Column;
+
+auto TerrainGenerator::generateColumns(
+    std::uint32_t side, gim::library::jobs::JobSystem &jobs) const
+    -> std::vector<Column> {
+    std::vector<Column> columns(static_cast<std::size_t>(side) * side);
+    auto top = static_cast<std::int32_t>(side);
+
+    // The band of every column of a row is evaluated as one batch, a
+    // batch per column would leave most of every vector empty.
+    jobs.parallelFor(side, 1, [&](std::size_t begin, std::size_t end) {
+        std::vector<float> heights(side);
+        std::vector<glm::vec3> positions(side * BandHeight);
+        std::vector<float> density(side * BandHeight);
+        for (auto z = begin; z < end; z++) {
+            auto row = std::span(columns).subspan(z * side, side);
+            auto fz = static_cast<float>(z);
+            noise.generateGrid(glm::vec3(0.0f, 0.0f, fz * HeightScale),
+                               glm::ivec3(static_cast<int>(side), 1, 1),
+                               HeightScale, heights);
+
+            for (std::uint32_t x = 0; x < side; x++) {
+                auto height = BaseHeight + HeightAmplitude * heights[x];
+                row[x].floor = std::clamp(
+                    static_cast<std::int32_t>(std::floor(height)) -
+                        BandHeight / 2,
+                    0, top);
+                for (int i = 0; i < BandHeight; i++) {
+                    positions[x * BandHeight + i] =
+                        glm::vec3(static_cast<float>(x),
+                                  static_cast<float>(row[x].floor + i), fz) *
+                        BandScale;
+                }
+            }
+            noise.generate(positions, density);
+
+            for (std::uint32_t x = 0; x < side; x++) {
+                auto height = BaseHeight + HeightAmplitude * heights[x];
+                auto floor = row[x].floor;
+                std::uint32_t band = 0;
+                for (int i = 0; i < BandHeight && floor + i < top; i++) {
+                    auto below = height - static_cast<float>(floor + i);
+                    if (below + BandAmplitude * density[x * BandHeight + i] >
+                        0.0f) {
+                        band |= 1U << i;
+                    }
+                }
+                row[x].band = band;
+            }
+        }
+    });
+    return columns;
+}
+
+auto TerrainGenerator::solidCubes(std::span<Column const> columns,
+                                  std::uint32_t depth)
+    -> std::vector<std::vector<std::uint64_t>> {
+    auto side = std::size_t{1} << depth;
+    assert(columns.size() == side * side && "One column per (x, z).");
+
+    // floors[l] is the lowest floor of every square of 2^l columns.
+    std::vector<std::vector<std::int32_t>> floors(depth);
+    floors[0].resize(columns.size());
+    std::ranges::transform(columns, floors[0].begin(),
+                           [](Column const &column) { return column.floor; });
+    for (std::uint32_t l = 1; l < depth; l++) {
+        auto width = side >> l;
+        auto const &below = floors[l - 1];
+        floors[l].resize(width * width);
+        for (std::size_t z = 0; z < width; z++) {
+            for (std::size_t x = 0; x < width; x++) {
+                auto at = [&](std::size_t dx, std::size_t dz) {
+                    return below[(2 * z + dz) * 2 * width + 2 * x + dx];
+                };
+                floors[l][z * width + x] =
+                    std::min({at(0, 0), at(1, 0), at(0, 1), at(1, 1)});
+            }
+        }
+    }
+
+    // Every square continues above the cubes of its parent, which reach
+    // its parent's floor rounded down to their size.
+    std::vector<std::vector<std::uint64_t>> cubes(depth);
+    for (auto l = depth; l-- > 0;) {
+        auto width = side >> l;
+        for (std::size_t z = 0; z < width; z++) {
+            for (std::size_t x = 0; x < width; x++) {
+                std::int32_t reached = 0;
+                if (l + 1 < depth) {
+                    auto parent = floors[l + 1][z / 2 * (width / 2) + x / 2];
+                    reached = parent >> (l + 1) << 1U;
+                }
+                auto floor = floors[l][z * width + x] >> l;
+                for (auto y = reached; y < floor; y++) {
+                    cubes[l].push_back(gim::library::morton::encode(
+                        static_cast<std::uint32_t>(x),
+                        static_cast<std::uint32_t>(y),
+                        static_cast<std::uint32_t>(z)));
+                }
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        auto x = static_cast<std::uint32_t>(i % side);
+        auto z = static_cast<std::uint32_t>(i / side);
+        auto floor = static_cast<std::uint32_t>(columns[i].floor);
+        for (auto band = columns[i].band; band != 0; band &= band - 1) {
+            auto y = floor + static_cast<std::uint32_t>(std::countr_zero(band));
+            cubes[0].push_back(gim::library::morton::encode(x, y, z));
+        }
+    }
+    return cubes;
+}
+
+auto TerrainGenerator::generate(gim::svo::SparseVoxelOctree &octree,
+                                gim::library::jobs::JobSystem &jobs) const
+    -> void {
+    auto columns = generateColumns(octree.size(), jobs);
+    auto cubes = solidCubes(columns, octree.getDepth());
+    octree.buildCubes(cubes, jobs);
+}